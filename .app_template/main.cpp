@@ -1,5 +1,6 @@
 #include <blackboard_app/app.h>
 #include <blackboard_app/gui.h>
+#include <blackboard_app/log_console.h>
 #include <blackboard_app/resources.h>
 #include <blackboard_app/window.h>
 
@@ -9,18 +10,24 @@
 
 blackboard::app::App *app_ptr;
 
-void init()
+// runs on a worker while the renderer initializes
+void load()
 {
-  blackboard::app::gui::set_blackboard_theme();
   const auto dpi{app_ptr->main_window.get_ddpi()};
   blackboard::app::gui::load_font(blackboard::app::resources::path() / "assets/fonts/Inter/Inter-Light.otf", 12.0f,
                                   dpi);
 }
 
+void init()
+{
+  blackboard::app::gui::set_blackboard_theme();
+}
+
 void app_update()
 {
   blackboard::app::gui::dockspace();
   ImGui::ShowDemoWindow();
+  blackboard::app::gui::log_console();
 }
 
 int main(int argc, char *argv[])
@@ -29,6 +36,7 @@ int main(int argc, char *argv[])
                            blackboard::app::renderer::Api::AUTO);  // autodetect renderer api
   app_ptr = &app;
   app.on_update = app_update;
+  app.on_load = load;
   app.on_init = init;
   app.run();
 
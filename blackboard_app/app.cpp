@@ -1,10 +1,16 @@
 #include "app.h"
 
+#include "assets.h"
+#include "event_coalescer.h"
 #include "gui.h"
 #include "logger.h"
 #include "platform/imgui_impl_sdl_bgfx.h"
 #include "renderer.h"
 #include "resources.h"
+#include "startup_trace.h"
+#include "textures.h"
+#include "thread_pool.h"
+#include "vfs.h"
 #include "window.h"
 
 #include <SDL3/SDL.h>
@@ -13,27 +19,45 @@
 #include <imgui/imgui_internal.h>
 #include <imguizmo/imguizmo.h>
 
+#include <atomic>
+#include <exception>
 #include <iostream>
+#include <vector>
 
 namespace blackboard::app {
 
 App::App(const char *app_name, const renderer::Api renderer_api, const uint16_t width, const uint16_t height,
          const bool fullscreen)
 : main_window{*new Window()}, m_renderer_api{renderer_api}
-, on_init{[]() { logger::logger->info("init function not defined"); }}
-, on_update{[]() { logger::logger->info("update function not defined"); }}
+, on_init{[]() { BB_LOG_INFO("init function not defined"); }}
+, on_update{[]() { BB_LOG_INFO("update function not defined"); }}
 , on_resize{[](const uint16_t width, const uint16_t height) {
-  logger::logger->info("window resize function not defined");}}
+  BB_LOG_INFO("window resize function not defined");}}
 {
   if (renderer_api == renderer::Api::NONE)
     return;
 
+  BB_STARTUP_SCOPE("App::App");
   logger::init();
-  logger::logger->info("App constructor");
+  BB_LOG_INFO("App constructor");
 
-  if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_GAMEPAD) != 0)
   {
-    logger::logger->error(SDL_GetError());
+    BB_STARTUP_SCOPE("vfs mount");
+    vfs::mount_directory(resources::path());
+    if (const auto archive = resources::path() / "assets.pack"; std::filesystem::exists(archive))
+    {
+      vfs::mount_archive(archive);
+    }
+  }
+  thread_pool = std::make_unique<Thread_pool>();
+
+  {
+    // gamepads are initialized on first use, see init_gamepad
+    BB_STARTUP_SCOPE("SDL_Init");
+    if (SDL_Init(SDL_INIT_VIDEO) != 0)
+    {
+      BB_LOG_LIMITED(spdlog::level::err, 1, "{}", SDL_GetError());
+    }
   }
 
   main_window.title = app_name;
@@ -41,11 +65,76 @@ App::App(const char *app_name, const renderer::Api renderer_api, const uint16_t
   main_window.height = height;
   main_window.fullscreen = fullscreen;
 
-  main_window.init_platform_window();
+  {
+    BB_STARTUP_SCOPE("Window");
+    main_window.init_platform_window();
+  }
+
+  {
+    BB_STARTUP_SCOPE("gui::init");
+    gui::init();
+  }
+
+  // the renderer is initialized by run(), overlapped with on_load
+  BB_LOG_INFO("Ending App constructor");
+}
+
+bool App::init_gamepad()
+{
+  if (SDL_WasInit(SDL_INIT_GAMEPAD))
+    return true;
+
+  BB_STARTUP_SCOPE("Gamepad init");
+  if (SDL_InitSubSystem(SDL_INIT_GAMEPAD) != 0)
+  {
+    BB_LOG_LIMITED(spdlog::level::err, 1, "{}", SDL_GetError());
+    return false;
+  }
+  return true;
+}
 
-  gui::init();
+void App::init_renderer()
+{
+  BB_STARTUP_SCOPE("App::init_renderer");
 
-  renderer::init(main_window, m_renderer_api, main_window.width, main_window.height);
+  // on_load, the font atlas and the saved layout run on a worker while bgfx creates the device
+  vfs::File layout_file;
+  std::exception_ptr load_error;
+  std::atomic_flag loaded;
+  thread_pool->submit(Priority::HIGH, [this, &layout_file, &load_error, &loaded]() {
+    try
+    {
+      if (on_load)
+      {
+        BB_STARTUP_SCOPE("on_load");
+        on_load();
+      }
+      {
+        BB_STARTUP_SCOPE("Font atlas");
+        gui::build_font_atlas();
+      }
+      {
+        BB_STARTUP_SCOPE("Layout read");
+        layout_file = vfs::open("imgui.ini");
+        if (!layout_file.is_open())
+        {
+          layout_file = vfs::open("assets/layouts/default_imgui.ini");
+        }
+      }
+    }
+    catch (...)
+    {
+      // rethrown on the main thread, which waits for loaded in any case
+      load_error = std::current_exception();
+    }
+    loaded.test_and_set();
+    loaded.notify_one();
+  });
+
+  {
+    BB_STARTUP_SCOPE("renderer::init");
+    m_renderer_ready = renderer::init(main_window, m_renderer_api, main_window.width, main_window.height);
+  }
   renderer::ImGui_Impl_sdl_bgfx_Init(main_window.imgui_view_id);
 
   switch (m_renderer_api)
@@ -66,48 +155,88 @@ App::App(const char *app_name, const renderer::Api renderer_api, const uint16_t
       break;
   }
 
-  logger::logger->info("Ending App constructor");
+  {
+    BB_STARTUP_SCOPE("Wait for on_load");
+    loaded.wait(false);
+  }
+  if (load_error)
+  {
+    std::rethrow_exception(load_error);
+  }
+  gui::apply_font_settings();
+
+  if (layout_file.is_open())
+  {
+    BB_STARTUP_SCOPE("Layout load");
+    ImGui::LoadIniSettingsFromMemory(reinterpret_cast<const char *>(layout_file.data()), layout_file.size());
+  }
 }
 
 void App::run()
 {
-  on_init();
+  if (gui::isInit())
+  {
+    init_renderer();
+  }
+  else if (on_load)
+  {
+    BB_STARTUP_SCOPE("on_load");
+    on_load();
+  }
 
+  {
+    BB_STARTUP_SCOPE("on_init");
+    on_init();
+  }
+  gui::apply_font_settings();
+
+  const auto trace_path = logger::path() / "startup_trace.json";
   if (ImGui::GetCurrentContext())
   {
-    auto layout_ui = resources::path() / "imgui.ini";
-    if (!std::filesystem::exists(layout_ui))
-    {
-      layout_ui = resources::path() / "assets/layouts/default_imgui.ini";
-    }
-    ImGui::LoadIniSettingsFromDisk(layout_ui.string().c_str());
     const auto [drawable_width, drawable_height] = main_window.get_size_in_pixels();
     on_resize(drawable_width, drawable_height);
 
-    SDL_Event event;
+    Event_coalescer events;
+    const std::vector<SDL_Event> no_events;    // without a window nothing is polled
+    bool gamepad_requested{false};
     while (running)
     {
-      while (main_window.window != nullptr && SDL_PollEvent(&event))
+      bool resized{false};
+      const auto main_window_id = main_window.window ? SDL_GetWindowID(main_window.window) : 0u;
+      for (const auto &event : main_window.window ? events.poll() : no_events)
       {
         ImGui_ImplSDL3_ProcessEvent(&event);
 
         if (event.type == SDL_EVENT_QUIT)
           running = false;
-        if (event.type == SDL_EVENT_WINDOW_CLOSE_REQUESTED &&
-            event.window.windowID == SDL_GetWindowID(main_window.window))
+        if (event.type == SDL_EVENT_WINDOW_CLOSE_REQUESTED && event.window.windowID == main_window_id)
           running = false;
-        if (event.type == SDL_EVENT_WINDOW_RESIZED)
+        if (event.type == SDL_EVENT_WINDOW_DISPLAY_CHANGED && event.window.windowID == main_window_id)
+          main_window.update_ddpi();
+        if (event.type == SDL_EVENT_WINDOW_RESIZED && event.window.windowID == main_window_id)
         {
-          const auto width = event.window.data1;
-          const auto height = event.window.data2;
-          main_window.width = width;
-          main_window.height = height;
-          renderer::ImGui_Impl_sdl_bgfx_Resize(main_window.window);
-          const auto [drawable_width, drawable_height] = main_window.get_size_in_pixels();
-          on_resize(drawable_width, drawable_height);
+          main_window.width = event.window.data1;
+          main_window.height = event.window.data2;
+          resized = true;
         }
       }
 
+      // a single swapchain reset per frame, whatever the number of resize events
+      if (resized)
+      {
+        renderer::ImGui_Impl_sdl_bgfx_Resize(main_window.window);
+        const auto [drawable_width, drawable_height] = main_window.get_size_in_pixels();
+        on_resize(drawable_width, drawable_height);
+      }
+
+      if (!gamepad_requested && (ImGui::GetIO().ConfigFlags & ImGuiConfigFlags_NavEnableGamepad))
+      {
+        gamepad_requested = true;
+        init_gamepad();
+      }
+
+      assets::update();
+
       renderer::ImGui_Impl_sdl_bgfx_NewFrame();
       ImGui_ImplSDL3_NewFrame();
       ImGui::NewFrame();
@@ -126,14 +255,18 @@ void App::run()
       }
 
       bgfx::frame();
+      textures::update();
+      startup_trace::finish(trace_path);
     }
   }
   else
   {
     while (running)
     {
+      assets::update();
       on_update();
       m_prev_time = std::chrono::steady_clock::now();
+      startup_trace::finish(trace_path);
     }
   }
 }
@@ -144,15 +277,25 @@ App::~App()
   {
     ImGui::SaveIniSettingsToDisk((resources::path() / "imgui.ini").string().c_str());
 
-    ImGui_ImplSDL3_Shutdown();
-    renderer::ImGui_Impl_sdl_bgfx_Shutdown();
+    if (m_renderer_ready)
+    {
+      ImGui_ImplSDL3_Shutdown();
+      renderer::ImGui_Impl_sdl_bgfx_Shutdown();
+    }
 
-    ImGui::DestroyContext();
-    bgfx::shutdown();
+    gui::shutdown();
+    if (m_renderer_ready)
+    {
+      textures::shutdown();
+      bgfx::shutdown();
+    }
 
     SDL_DestroyWindow(main_window.window);
     SDL_Quit();
   }
+  thread_pool.reset();
+  assets::shutdown();
+  vfs::unmount_all();
   logger::shutdown();
 }
 
@@ -17,6 +17,11 @@ class App
       const uint16_t height = 720u, const bool fullscreen = false);
   ~App();
   void run();
+  /// @brief Called on a worker thread while the renderer initializes: load fonts, read files, decode data.
+  /// It must not create bgfx objects nor start an ImGui frame, nor call SDL: main_window.get_ddpi() is cached.
+  /// An exception it throws is rethrown by run() on the main thread.
+  std::function<void()> on_load{};
+  /// @brief Called on the main thread once the renderer is ready, after on_load
   std::function<void()> on_init{};
   std::function<void()> on_update{};
   std::function<void(const uint16_t, const uint16_t)> on_resize{};
@@ -32,10 +37,16 @@ class App
     return std::chrono::duration<float>(std::chrono::steady_clock::now() - m_start_time).count();
   }
 
+  /// @brief Gamepads are initialized on first use, called by run() when ImGui gamepad navigation is enabled
+  static bool init_gamepad();
+
   bool running{true};
   Window &main_window;
 
   protected:
+  void init_renderer();
+
+  bool m_renderer_ready{false};
   uint32_t m_update_rate{16};
   renderer::Api m_renderer_api{renderer::Api::NONE};
   inline static std::chrono::time_point<std::chrono::steady_clock> m_start_time = std::chrono::steady_clock::now();
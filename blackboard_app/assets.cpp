@@ -0,0 +1,143 @@
+#include "assets.h"
+
+#include "logger.h"
+
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+namespace {
+
+using namespace blackboard::app;
+using assets::internal::Request;
+
+std::mutex requests_mutex;
+std::unordered_map<std::string, std::weak_ptr<Request>> requests;    // not finalized yet, by key
+std::deque<std::shared_ptr<Request>> decoded;                        // waiting for the main thread
+
+// the caller's reference is the only one left once every Asset has been released
+bool is_canceled(const std::shared_ptr<Request> &request)
+{
+  return request.use_count() <= 1;
+}
+
+void run(const std::weak_ptr<Request> &weak_request)
+{
+  auto request = weak_request.lock();
+  // canceled, or already run from the queue of another priority
+  if (!request || request->claimed.test_and_set())
+    return;
+
+  const auto file = vfs::open(request->name);
+  if (!file.is_open())
+    logger::logger->error("Asset not found: {}", request->name);
+  else if (!is_canceled(request))
+    request->value = request->decode(file);
+
+  if (is_canceled(request))
+    return;
+
+  std::lock_guard lock{requests_mutex};
+  decoded.push_back(std::move(request));
+}
+
+void submit(const std::shared_ptr<Request> &request, Priority priority)
+{
+  if (thread_pool)
+    thread_pool->submit(priority, [weak_request = std::weak_ptr<Request>{request}]() { run(weak_request); });
+  else
+    run(request);
+}
+
+}    // namespace
+
+namespace blackboard::app::assets {
+
+namespace internal {
+
+std::shared_ptr<Request> load(std::string key, std::string_view name, Priority priority, Decode decode,
+                              Finalize finalize)
+{
+  std::unique_lock lock{requests_mutex};
+  if (const auto it = requests.find(key); it != requests.end())
+  {
+    if (auto existing = it->second.lock(); existing)
+    {
+      // queue it again with the higher priority, the first worker to claim it runs it
+      if (priority < existing->priority && !existing->claimed.test())
+      {
+        existing->priority = priority;
+        lock.unlock();
+        submit(existing, priority);
+      }
+      return existing;
+    }
+  }
+
+  auto request = std::make_shared<Request>();
+  request->key = key;
+  request->name = name;
+  request->priority = priority;
+  request->decode = std::move(decode);
+  request->finalize = std::move(finalize);
+  requests.insert_or_assign(std::move(key), request);
+  lock.unlock();
+
+  submit(request, priority);
+  return request;
+}
+
+}    // namespace internal
+
+void update(std::chrono::microseconds budget)
+{
+  const auto start = std::chrono::steady_clock::now();
+  {
+    std::lock_guard lock{requests_mutex};
+    std::erase_if(requests, [](const auto &entry) { return entry.second.expired(); });
+  }
+
+  do
+  {
+    std::shared_ptr<Request> request;
+    {
+      std::lock_guard lock{requests_mutex};
+      if (decoded.empty())
+        return;
+      request = std::move(decoded.front());
+      decoded.pop_front();
+      requests.erase(request->key);
+    }
+    if (is_canceled(request))
+      continue;
+
+    bool ready = request->value.has_value();
+    if (ready && request->finalize)
+      ready = request->finalize(request->value);
+    if (!ready)
+    {
+      logger::logger->error("Error loading asset: {}", request->name);
+      request->value.reset();
+    }
+    request->decode = nullptr;
+    request->finalize = nullptr;
+    request->state.store(ready ? State::READY : State::FAILED, std::memory_order_release);
+  } while (std::chrono::steady_clock::now() - start < budget);
+}
+
+size_t pending_count()
+{
+  std::lock_guard lock{requests_mutex};
+  return static_cast<size_t>(
+    std::count_if(requests.begin(), requests.end(), [](const auto &entry) { return !entry.second.expired(); }));
+}
+
+void shutdown()
+{
+  std::lock_guard lock{requests_mutex};
+  requests.clear();
+  decoded.clear();
+}
+
+}    // namespace blackboard::app::assets
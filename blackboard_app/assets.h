@@ -0,0 +1,130 @@
+#pragma once
+#include "thread_pool.h"
+#include "vfs.h"
+
+#include <any>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <typeinfo>
+
+// Asynchronous asset loading: files are read through the vfs and decoded on the worker threads,
+// then finalized (e.g. bgfx objects created) on the main thread by update(), called once per frame by App.
+//
+//   assets::Asset<Image> image = assets::load<Image>("assets/images/logo.png", Priority::HIGH, decode_image,
+//                                                    [](Image &image) { return create_texture(image); });
+//   if (const auto *logo = image.get(); logo) draw(*logo);
+//
+// Loads of the same name and type share one request. A request is canceled, wherever it is in the pipeline,
+// once every Asset referencing it has been canceled or destroyed.
+
+namespace blackboard::app::assets {
+
+enum class State : uint8_t
+{
+  NONE = 0,
+  LOADING,
+  READY,
+  FAILED
+};
+
+namespace internal {
+
+/// @brief Returns an empty any if the data can not be decoded
+using Decode = std::function<std::any(const vfs::File &)>;
+/// @brief Main thread step, returns false if the asset can not be used
+using Finalize = std::function<bool(std::any &)>;
+
+struct Request
+{
+  std::string key;
+  std::string name;
+  Priority priority{Priority::NORMAL};
+  Decode decode;
+  Finalize finalize;
+  std::any value;    // written by the worker, only read once the state is READY
+  std::atomic<State> state{State::LOADING};
+  std::atomic_flag claimed;    // set by the worker running the request
+};
+
+std::shared_ptr<Request> load(std::string key, std::string_view name, Priority priority, Decode decode,
+                              Finalize finalize);
+
+}    // namespace internal
+
+template<typename T>
+class Asset
+{
+  public:
+  Asset() = default;
+  explicit Asset(std::shared_ptr<internal::Request> request) : m_request{std::move(request)} {}
+
+  State state() const
+  {
+    return m_request ? m_request->state.load(std::memory_order_acquire) : State::NONE;
+  }
+
+  bool ready() const
+  {
+    return state() == State::READY;
+  }
+
+  /// @brief nullptr until the asset is ready
+  T *get() const
+  {
+    return ready() ? std::any_cast<T>(&m_request->value) : nullptr;
+  }
+
+  const std::string &name() const
+  {
+    static const std::string empty;
+    return m_request ? m_request->name : empty;
+  }
+
+  /// @brief Release this handle, the load stops if no other handle wants it
+  void cancel()
+  {
+    m_request.reset();
+  }
+
+  private:
+  std::shared_ptr<internal::Request> m_request;
+};
+
+/// @brief Load and decode name on the workers, then run finalize on the main thread.
+/// Requesting a name already loading with a higher priority promotes it.
+template<typename T>
+Asset<T> load(std::string_view name, Priority priority, std::function<std::optional<T>(const vfs::File &)> decode,
+              std::function<bool(T &)> finalize = {})
+{
+  std::string key{name};
+  key.append("|").append(typeid(T).name());
+  internal::Decode erased_decode = [decode = std::move(decode)](const vfs::File &file) -> std::any {
+    if (auto value = decode(file); value)
+      return std::any{std::move(*value)};
+    return {};
+  };
+  internal::Finalize erased_finalize;
+  if (finalize)
+  {
+    erased_finalize = [finalize = std::move(finalize)](std::any &value) {
+      return finalize(*std::any_cast<T>(&value));
+    };
+  }
+  return Asset<T>{internal::load(std::move(key), name, priority, std::move(erased_decode), std::move(erased_finalize))};
+}
+
+/// @brief Finalize the decoded assets on the main thread, at least one and then until the budget is spent
+void update(std::chrono::microseconds budget = std::chrono::milliseconds{4});
+
+/// @brief Number of requests not finalized yet
+size_t pending_count();
+
+/// @brief Drop every pending request, assets already handed out stay valid
+void shutdown();
+
+}    // namespace blackboard::app::assets
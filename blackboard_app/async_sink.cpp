@@ -0,0 +1,282 @@
+#include "async_sink.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <string_view>
+
+namespace blackboard::app::logger {
+
+static constexpr std::string_view truncated_marker{"[...]"};
+
+void Async_sink::Message::assign(const spdlog::details::log_msg &message)
+{
+  time = message.time;
+  source = message.source;
+  thread_id = message.thread_id;
+  level = message.level;
+  name_size = static_cast<uint16_t>(std::min(message.logger_name.size(), text_size / 4u));
+  std::memcpy(text.data(), message.logger_name.data(), name_size);
+
+  const size_t room = text_size - name_size;
+  if (message.payload.size() <= room)
+  {
+    payload_size = static_cast<uint16_t>(message.payload.size());
+    std::memcpy(text.data() + name_size, message.payload.data(), payload_size);
+  }
+  else
+  {
+    payload_size = static_cast<uint16_t>(room);
+    const size_t kept = room - truncated_marker.size();
+    std::memcpy(text.data() + name_size, message.payload.data(), kept);
+    std::memcpy(text.data() + name_size + kept, truncated_marker.data(), truncated_marker.size());
+  }
+}
+
+spdlog::details::log_msg Async_sink::Message::view() const
+{
+  spdlog::details::log_msg message{time, source, spdlog::string_view_t{text.data(), name_size}, level,
+                                   spdlog::string_view_t{text.data() + name_size, payload_size}};
+  message.thread_id = thread_id;
+  return message;
+}
+
+Async_sink::Async_sink(std::vector<spdlog::sink_ptr> sinks, size_t capacity, Overflow_policy policy)
+: m_sinks{std::move(sinks)}, m_policy{policy}
+{
+  capacity = std::bit_ceil(std::max<size_t>(capacity, 2u));
+  m_slots = std::make_unique<Slot[]>(capacity);
+  m_mask = capacity - 1u;
+  for (size_t i = 0u; i < capacity; ++i)
+    m_slots[i].sequence.store(i, std::memory_order_relaxed);
+
+  m_thread = std::thread{[this]() { work(); }};
+}
+
+Async_sink::~Async_sink()
+{
+  stop();
+}
+
+void Async_sink::log(const spdlog::details::log_msg &message)
+{
+  // stop() waits for the producers that saw the sink running before it joins the flusher thread
+  m_producers.fetch_add(1u, std::memory_order_seq_cst);
+  if (m_stopped.load(std::memory_order_seq_cst))
+  {
+    m_producers.fetch_sub(1u, std::memory_order_release);
+    write(message);
+    return;
+  }
+
+  switch (m_policy)
+  {
+    case Overflow_policy::BLOCK:
+      if (!try_push(message))
+      {
+        // the flusher thread signals the freed slots once it sees a blocked producer
+        m_blocked.fetch_add(1u, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        while (true)
+        {
+          const auto freed = m_freed.load(std::memory_order_acquire);
+          if (try_push(message))
+            break;
+          wake();
+          m_freed.wait(freed, std::memory_order_acquire);
+        }
+        m_blocked.fetch_sub(1u, std::memory_order_relaxed);
+      }
+      break;
+    case Overflow_policy::DROP_NEWEST:
+      if (!try_push(message))
+        m_dropped.fetch_add(1u, std::memory_order_relaxed);
+      break;
+    case Overflow_policy::DROP_OLDEST:
+      while (!try_push(message))
+      {
+        Message oldest;
+        if (try_pop(oldest))
+          m_dropped.fetch_add(1u, std::memory_order_relaxed);
+      }
+      break;
+  }
+  m_producers.fetch_sub(1u, std::memory_order_release);
+
+  // only the parked flusher thread needs a notification, it parks once the ring is empty
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (m_parked.load(std::memory_order_relaxed))
+    wake();
+}
+
+void Async_sink::flush()
+{
+  if (m_stopped.load(std::memory_order_acquire))
+  {
+    for (auto &sink : m_sinks)
+      sink->flush();
+    return;
+  }
+  m_flush_requested.store(true, std::memory_order_release);
+  wake();
+}
+
+void Async_sink::set_pattern(const std::string &pattern)
+{
+  for (auto &sink : m_sinks)
+    sink->set_pattern(pattern);
+}
+
+void Async_sink::set_formatter(std::unique_ptr<spdlog::formatter> formatter)
+{
+  for (auto &sink : m_sinks)
+    sink->set_formatter(formatter->clone());
+}
+
+void Async_sink::stop()
+{
+  if (!m_thread.joinable())
+    return;
+  // new messages are written inline, the ones being pushed are drained by the flusher thread, which keeps
+  // running until the producers blocked on a full ring are done
+  m_stopped.store(true, std::memory_order_seq_cst);
+  while (m_producers.load(std::memory_order_seq_cst) != 0u)
+  {
+    wake();
+    std::this_thread::yield();
+  }
+  m_stopping.store(true, std::memory_order_release);
+  wake();
+  m_thread.join();
+
+  Message message;
+  while (try_pop(message))
+    write(message.view());
+  for (auto &sink : m_sinks)
+    sink->flush();
+}
+
+// Bounded MPMC ring of Dmitry Vyukov, every slot sequence tells which lap of the ring it is ready for
+bool Async_sink::try_push(const spdlog::details::log_msg &message)
+{
+  size_t position = m_head.load(std::memory_order_relaxed);
+  while (true)
+  {
+    Slot &slot = m_slots[position & m_mask];
+    const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+    const auto difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+    if (difference == 0)
+    {
+      if (m_head.compare_exchange_weak(position, position + 1u, std::memory_order_relaxed))
+      {
+        slot.message.assign(message);
+        slot.sequence.store(position + 1u, std::memory_order_release);
+        return true;
+      }
+    }
+    else if (difference < 0)
+    {
+      return false;    // full
+    }
+    else
+    {
+      position = m_head.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+bool Async_sink::try_pop(Message &message)
+{
+  size_t position = m_tail.load(std::memory_order_relaxed);
+  while (true)
+  {
+    Slot &slot = m_slots[position & m_mask];
+    const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+    const auto difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1u);
+    if (difference == 0)
+    {
+      if (m_tail.compare_exchange_weak(position, position + 1u, std::memory_order_relaxed))
+      {
+        message = slot.message;
+        slot.sequence.store(position + m_mask + 1u, std::memory_order_release);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_blocked.load(std::memory_order_relaxed) != 0u)
+        {
+          m_freed.fetch_add(1u, std::memory_order_release);
+          m_freed.notify_all();
+        }
+        return true;
+      }
+    }
+    else if (difference < 0)
+    {
+      return false;    // empty
+    }
+    else
+    {
+      position = m_tail.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+void Async_sink::wake()
+{
+  m_signal.fetch_add(1u, std::memory_order_release);
+  m_signal.notify_one();
+}
+
+void Async_sink::write(const spdlog::details::log_msg &message)
+{
+  for (auto &sink : m_sinks)
+  {
+    if (sink->should_log(message.level))
+      sink->log(message);
+  }
+}
+
+void Async_sink::work()
+{
+  Message message;
+  std::string logger_name;
+  uint64_t reported_drops{0u};
+  while (true)
+  {
+    const auto signal = m_signal.load(std::memory_order_acquire);
+    bool written{false};
+    while (try_pop(message))
+    {
+      if (logger_name.empty())
+        logger_name.assign(message.text.data(), message.name_size);
+      write(message.view());
+      written = true;
+    }
+
+    if (const auto dropped = dropped_count(); dropped != reported_drops)
+    {
+      const auto text = fmt::format("log queue full, dropped {} messages", dropped - reported_drops);
+      write(spdlog::details::log_msg{logger_name, spdlog::level::warn, text});
+      reported_drops = dropped;
+    }
+
+    const bool stopping = m_stopping.load(std::memory_order_acquire);
+    if (m_flush_requested.exchange(false, std::memory_order_acq_rel) || stopping)
+    {
+      for (auto &sink : m_sinks)
+        sink->flush();
+    }
+    if (stopping)
+      return;
+    if (written)
+      continue;
+
+    // park unless a message was pushed before the producers could see the flag
+    m_parked.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_head.load(std::memory_order_relaxed) == m_tail.load(std::memory_order_relaxed) &&
+        !m_flush_requested.load(std::memory_order_relaxed) && !m_stopping.load(std::memory_order_relaxed))
+      m_signal.wait(signal, std::memory_order_acquire);
+    m_parked.store(false, std::memory_order_relaxed);
+  }
+}
+
+}    // namespace blackboard::app::logger
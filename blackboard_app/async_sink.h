@@ -0,0 +1,98 @@
+#pragma once
+#include <spdlog/details/log_msg.h>
+#include <spdlog/sinks/sink.h>
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace blackboard::app::logger {
+
+enum class Overflow_policy : uint8_t
+{
+  BLOCK = 0,      // wait for the flusher thread to make room
+  DROP_NEWEST,    // discard the message being logged
+  DROP_OLDEST     // discard the oldest queued message
+};
+
+/// @brief Sink handing the messages to a flusher thread that writes them to the wrapped sinks.
+///
+/// Messages are copied into a preallocated lock-free ring of fixed size slots, producers never allocate nor take
+/// a lock unless the ring is full and the policy is BLOCK. The logger name and the text of a message longer than
+/// text_size are truncated. flush() only requests a flush from the flusher thread.
+class Async_sink final : public spdlog::sinks::sink
+{
+  public:
+  inline static constexpr size_t text_size{480u};
+
+  Async_sink(std::vector<spdlog::sink_ptr> sinks, size_t capacity, Overflow_policy policy);
+  ~Async_sink() override;
+
+  Async_sink(const Async_sink &) = delete;
+  Async_sink &operator=(const Async_sink &) = delete;
+
+  void log(const spdlog::details::log_msg &message) override;
+  void flush() override;
+  void set_pattern(const std::string &pattern) override;
+  void set_formatter(std::unique_ptr<spdlog::formatter> formatter) override;
+
+  /// @brief Write the queued messages and join the flusher thread once no thread is pushing anymore,
+  /// later messages are written inline
+  void stop();
+
+  uint64_t dropped_count() const
+  {
+    return m_dropped.load(std::memory_order_relaxed);
+  }
+
+  private:
+  // a log_msg whose strings are copied into text, the logger name first
+  struct Message
+  {
+    spdlog::log_clock::time_point time;
+    spdlog::source_loc source;    // file and function names are string literals
+    size_t thread_id{0u};
+    spdlog::level::level_enum level{spdlog::level::off};
+    uint16_t name_size{0u};
+    uint16_t payload_size{0u};
+    std::array<char, text_size> text;
+
+    void assign(const spdlog::details::log_msg &message);
+    spdlog::details::log_msg view() const;
+  };
+
+  struct Slot
+  {
+    std::atomic<size_t> sequence{0u};
+    Message message;
+  };
+
+  bool try_push(const spdlog::details::log_msg &message);
+  bool try_pop(Message &message);
+  void wake();
+  void write(const spdlog::details::log_msg &message);
+  void work();
+
+  std::vector<spdlog::sink_ptr> m_sinks;
+  std::unique_ptr<Slot[]> m_slots;
+  size_t m_mask{0u};
+  Overflow_policy m_policy{Overflow_policy::BLOCK};
+
+  alignas(64) std::atomic<size_t> m_head{0u};
+  alignas(64) std::atomic<size_t> m_tail{0u};
+  alignas(64) std::atomic<uint32_t> m_signal{0u};
+  std::atomic<bool> m_parked{false};          // the flusher thread waits on m_signal
+  alignas(64) std::atomic<uint32_t> m_freed{0u};    // bumped when a slot is freed while producers are blocked
+  std::atomic<uint32_t> m_blocked{0u};        // producers waiting on m_freed
+  std::atomic<uint64_t> m_dropped{0u};
+  std::atomic<uint32_t> m_producers{0u};    // threads inside log() that found the sink running
+  std::atomic<bool> m_flush_requested{false};
+  std::atomic<bool> m_stopping{false};
+  std::atomic<bool> m_stopped{false};
+  std::thread m_thread;
+};
+
+}    // namespace blackboard::app::logger
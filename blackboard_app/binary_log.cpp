@@ -0,0 +1,283 @@
+#include "binary_log.h"
+
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace blackboard::app::binary_log;
+
+// Single producer single consumer byte ring, records never wrap: the space left at the end of the ring
+// is skipped with a padding record
+struct Thread_buffer
+{
+  std::unique_ptr<uint8_t[]> data;
+  size_t mask{0u};
+  uint32_t thread_index{0u};
+  uint32_t generation{0u};
+  size_t write_position{0u};    // producer only, head plus the padding of the reserved record
+  alignas(64) std::atomic<size_t> head{0u};
+  alignas(64) std::atomic<size_t> tail{0u};
+  std::atomic<bool> retired{false};
+};
+
+struct Format
+{
+  std::string signature;
+  std::string format_string;
+};
+
+// the buffer outlives its thread until the writer has drained it
+struct Thread_registration
+{
+  std::shared_ptr<Thread_buffer> buffer;
+
+  ~Thread_registration()
+  {
+    if (buffer)
+      buffer->retired.store(true, std::memory_order_release);
+  }
+};
+
+thread_local Thread_registration registration;
+
+std::mutex formats_mutex;
+std::vector<Format> formats;    // by id, kept across init so the ids cached by the call sites stay valid
+
+std::mutex buffers_mutex;
+std::vector<std::shared_ptr<Thread_buffer>> buffers;
+uint32_t next_thread_index{0u};
+size_t buffer_capacity{0u};
+std::atomic<uint32_t> generation{0u};
+
+std::atomic<uint64_t> dropped{0u};
+uint64_t reported_drops{0u};
+
+std::chrono::steady_clock::time_point start_time;
+std::ofstream file;
+std::thread writer;
+std::mutex writer_mutex;
+std::condition_variable writer_condition;
+bool stopping{false};
+size_t written_formats{0u};
+
+void write_chunk(format::Chunk_type type, const void *header, size_t header_size, const void *data, size_t data_size)
+{
+  const format::Chunk_header chunk{.type = type, .size = static_cast<uint32_t>(header_size + data_size)};
+  file.write(reinterpret_cast<const char *>(&chunk), sizeof(chunk));
+  file.write(static_cast<const char *>(header), static_cast<std::streamsize>(header_size));
+  file.write(static_cast<const char *>(data), static_cast<std::streamsize>(data_size));
+}
+
+void drain()
+{
+  std::vector<std::shared_ptr<Thread_buffer>> snapshot;
+  {
+    std::lock_guard lock{buffers_mutex};
+    snapshot = buffers;
+  }
+  std::vector<size_t> heads;
+  heads.reserve(snapshot.size());
+  for (const auto &buffer : snapshot)
+    heads.push_back(buffer->head.load(std::memory_order_acquire));
+
+  // formats of the records up to the heads are registered by now
+  {
+    std::lock_guard lock{formats_mutex};
+    for (; written_formats < formats.size(); ++written_formats)
+    {
+      const auto &entry = formats[written_formats];
+      const format::Format_header header{.id = static_cast<uint32_t>(written_formats),
+                                         .signature_size = static_cast<uint16_t>(entry.signature.size()),
+                                         .format_size = static_cast<uint16_t>(entry.format_string.size())};
+      const std::string data = entry.signature + entry.format_string;
+      write_chunk(format::Chunk_type::FORMAT, &header, sizeof(header), data.data(), data.size());
+    }
+  }
+
+  std::vector<uint8_t> events;
+  for (size_t i = 0u; i < snapshot.size(); ++i)
+  {
+    auto &buffer = *snapshot[i];
+    const size_t capacity = buffer.mask + 1u;
+    size_t tail = buffer.tail.load(std::memory_order_relaxed);
+    events.clear();
+    while (tail != heads[i])
+    {
+      const uint8_t *record = buffer.data.get() + (tail & buffer.mask);
+      uint32_t id{0u};
+      uint32_t size{0u};
+      std::memcpy(&id, record, sizeof(id));
+      std::memcpy(&size, record + sizeof(id), sizeof(size));
+      if (size == 0u || size > capacity)
+        break;    // corrupted, should never happen
+      if (id != internal::padding_id)
+        events.insert(events.end(), record, record + size);
+      tail += size;
+    }
+    buffer.tail.store(tail, std::memory_order_release);
+
+    if (!events.empty())
+    {
+      const format::Events_header header{.thread_index = buffer.thread_index};
+      write_chunk(format::Chunk_type::EVENTS, &header, sizeof(header), events.data(), events.size());
+    }
+  }
+
+  if (const auto drops = dropped.load(std::memory_order_relaxed); drops != reported_drops)
+  {
+    const uint64_t count{drops - reported_drops};
+    write_chunk(format::Chunk_type::DROPPED, &count, sizeof(count), nullptr, 0u);
+    reported_drops = drops;
+  }
+  file.flush();
+
+  std::lock_guard lock{buffers_mutex};
+  std::erase_if(buffers, [](const auto &buffer) {
+    return buffer->retired.load(std::memory_order_acquire) &&
+           buffer->tail.load(std::memory_order_relaxed) == buffer->head.load(std::memory_order_acquire);
+  });
+}
+
+void work()
+{
+  using namespace std::chrono_literals;
+  std::unique_lock lock{writer_mutex};
+  while (!stopping)
+  {
+    writer_condition.wait_for(lock, 10ms, []() { return stopping; });
+    lock.unlock();
+    drain();
+    lock.lock();
+  }
+}
+
+}    // namespace
+
+namespace blackboard::app::binary_log {
+
+bool init(const std::filesystem::path &path, size_t thread_buffer_size)
+{
+  if (internal::enabled.load())
+    shutdown();
+
+  file.open(path, std::ios::binary | std::ios::trunc);
+  if (!file.is_open())
+  {
+    logger::logger->error("Error opening binary log: {}", path.string());
+    return false;
+  }
+
+  using namespace std::chrono;
+  start_time = steady_clock::now();
+  const format::File_header header{
+    .start_time = static_cast<uint64_t>(duration_cast<nanoseconds>(system_clock::now().time_since_epoch()).count())};
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+  {
+    std::lock_guard lock{buffers_mutex};
+    buffer_capacity = std::bit_ceil(std::max<size_t>(thread_buffer_size, 4096u));
+    next_thread_index = 0u;
+  }
+  generation.fetch_add(1u, std::memory_order_release);
+  dropped.store(0u);
+  reported_drops = 0u;
+  written_formats = 0u;
+  stopping = false;
+  writer = std::thread{work};
+  internal::enabled.store(true);
+  return true;
+}
+
+void shutdown()
+{
+  if (!internal::enabled.exchange(false, std::memory_order_seq_cst))
+    return;
+  // records being written are committed before the last drain
+  while (internal::producers.load(std::memory_order_acquire) != 0u)
+    std::this_thread::yield();
+
+  {
+    std::lock_guard lock{writer_mutex};
+    stopping = true;
+  }
+  writer_condition.notify_one();
+  writer.join();
+  drain();
+  file.close();
+
+  std::lock_guard lock{buffers_mutex};
+  buffers.clear();
+}
+
+uint64_t dropped_count()
+{
+  return dropped.load(std::memory_order_relaxed);
+}
+
+namespace internal {
+
+uint32_t register_format(const char *format_string, std::string_view signature)
+{
+  std::lock_guard lock{formats_mutex};
+  formats.push_back({.signature = std::string{signature}, .format_string = format_string});
+  return static_cast<uint32_t>(formats.size() - 1u);
+}
+
+uint8_t *reserve(uint32_t size)
+{
+  auto &buffer = registration.buffer;
+  if (!buffer || buffer->generation != generation.load(std::memory_order_acquire))
+  {
+    std::lock_guard lock{buffers_mutex};
+    buffer = std::make_shared<Thread_buffer>();
+    buffer->data = std::make_unique<uint8_t[]>(buffer_capacity);
+    buffer->mask = buffer_capacity - 1u;
+    buffer->thread_index = next_thread_index++;
+    buffer->generation = generation.load(std::memory_order_relaxed);
+    buffers.push_back(buffer);
+  }
+
+  const size_t capacity = buffer->mask + 1u;
+  const size_t head = buffer->head.load(std::memory_order_relaxed);
+  const size_t used = head - buffer->tail.load(std::memory_order_acquire);
+  const size_t contiguous = capacity - (head & buffer->mask);
+  const size_t needed = size <= contiguous ? size : contiguous + size;
+  if (size > capacity / 2u || capacity - used < needed)
+  {
+    dropped.fetch_add(1u, std::memory_order_relaxed);
+    return nullptr;
+  }
+
+  buffer->write_position = head;
+  if (size > contiguous)
+  {
+    const uint32_t padding[2]{padding_id, static_cast<uint32_t>(contiguous)};
+    std::memcpy(buffer->data.get() + (head & buffer->mask), padding, sizeof(padding));
+    buffer->write_position += contiguous;
+  }
+  return buffer->data.get() + (buffer->write_position & buffer->mask);
+}
+
+void commit(uint32_t size)
+{
+  auto &buffer = *registration.buffer;
+  buffer.head.store(buffer.write_position + size, std::memory_order_release);
+}
+
+uint64_t now()
+{
+  return static_cast<uint64_t>(
+    std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time).count());
+}
+
+}    // namespace internal
+
+}    // namespace blackboard::app::binary_log
@@ -0,0 +1,166 @@
+#pragma once
+#include "binary_log_format.h"
+#include "logger.h"
+
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <string_view>
+#include <type_traits>
+
+// Binary log channel for high-rate tracing: the producer thread only copies a format id, a timestamp and the raw
+// arguments into its own buffer, a writer thread appends the buffers to a binary file and the formatting happens
+// offline with tools/log_decode (blackboard_log_decode <file.blog>).
+//
+//   BB_LOG_BINARY("entity {} moved to {} {}", entity_id, position.x, position.y);
+//
+// Arguments can be arithmetic types, enums, pointers and strings. A record is dropped if its thread buffer is full.
+
+namespace blackboard::app::binary_log {
+
+/// @brief Open the file and start the writer thread, records logged before init are ignored
+bool init(const std::filesystem::path &path = logger::path() / "blackboard.blog", size_t thread_buffer_size = 1u << 20u);
+
+/// @brief Write the pending records and close the file
+void shutdown();
+
+/// @brief Records discarded since init because a thread buffer was full
+uint64_t dropped_count();
+
+namespace internal {
+
+inline std::atomic<bool> enabled{false};
+inline std::atomic<uint32_t> producers{0u};    // threads writing a record, waited for by shutdown
+inline constexpr uint32_t padding_id{0xffffffffu};
+
+uint32_t register_format(const char *format_string, std::string_view signature);
+
+/// @brief size bytes at the head of the thread buffer, nullptr if they do not fit
+uint8_t *reserve(uint32_t size);
+
+/// @brief Publish the record written in the reserved bytes
+void commit(uint32_t size);
+
+uint64_t now();
+
+template<typename>
+inline constexpr bool unsupported_argument{false};
+
+template<typename T>
+constexpr char arg_code()
+{
+  using U = std::remove_cv_t<std::decay_t<T>>;
+  if constexpr (std::is_same_v<U, bool>)
+    return format::arg_bool;
+  else if constexpr (std::is_same_v<U, char>)
+    return format::arg_char;
+  else if constexpr (std::is_enum_v<U>)
+    return arg_code<std::underlying_type_t<U>>();
+  else if constexpr (std::is_integral_v<U>)
+    return std::is_signed_v<U> ? format::arg_int : format::arg_uint;
+  else if constexpr (std::is_same_v<U, float>)
+    return format::arg_float;
+  else if constexpr (std::is_floating_point_v<U>)
+    return format::arg_double;
+  else if constexpr (std::is_convertible_v<const U &, std::string_view>)
+    return format::arg_string;
+  else if constexpr (std::is_pointer_v<U>)
+    return format::arg_pointer;
+  else
+    static_assert(unsupported_argument<T>, "BB_LOG_BINARY argument type not supported");
+}
+
+template<typename T>
+uint32_t encoded_size(const T &value)
+{
+  constexpr char code = arg_code<T>();
+  if constexpr (code == format::arg_bool || code == format::arg_char)
+    return 1u;
+  else if constexpr (code == format::arg_float)
+    return 4u;
+  else if constexpr (code == format::arg_string)
+    return static_cast<uint32_t>(sizeof(uint32_t) + std::string_view{value}.size());
+  else
+    return 8u;
+}
+
+template<typename T>
+uint8_t *encode(uint8_t *out, const T &value)
+{
+  constexpr char code = arg_code<T>();
+  const auto put = [&out](const auto &raw) {
+    std::memcpy(out, &raw, sizeof(raw));
+    out += sizeof(raw);
+  };
+  if constexpr (code == format::arg_bool)
+    put(static_cast<uint8_t>(value));
+  else if constexpr (code == format::arg_char)
+    put(value);
+  else if constexpr (code == format::arg_int)
+    put(static_cast<int64_t>(value));
+  else if constexpr (code == format::arg_uint)
+    put(static_cast<uint64_t>(value));
+  else if constexpr (code == format::arg_float)
+    put(value);
+  else if constexpr (code == format::arg_double)
+    put(static_cast<double>(value));
+  else if constexpr (code == format::arg_pointer)
+    put(static_cast<uint64_t>(reinterpret_cast<uintptr_t>(value)));
+  else
+  {
+    const std::string_view text{value};
+    put(static_cast<uint32_t>(text.size()));
+    std::memcpy(out, text.data(), text.size());
+    out += text.size();
+  }
+  return out;
+}
+
+/// @brief Site is a type unique to the call site, so every call site registers its format once
+template<typename Site, typename... Args>
+void log(Site, const char *format_string, const Args &...args)
+{
+  if (!enabled.load(std::memory_order_relaxed))
+    return;
+  // shutdown disables the log, then waits for the producers that saw it enabled before its last drain
+  producers.fetch_add(1u, std::memory_order_seq_cst);
+  struct Producer_guard
+  {
+    ~Producer_guard()
+    {
+      producers.fetch_sub(1u, std::memory_order_release);
+    }
+  } guard;
+  if (!enabled.load(std::memory_order_seq_cst))
+    return;
+
+  static constexpr std::array<char, sizeof...(Args)> signature{arg_code<Args>()...};
+  static const uint32_t format_id = register_format(format_string, {signature.data(), signature.size()});
+
+  const uint32_t unaligned_size = static_cast<uint32_t>(sizeof(format::Record_header)) + (0u + ... + encoded_size(args));
+  const uint32_t size = (unaligned_size + format::record_alignment - 1u) & ~(format::record_alignment - 1u);
+  uint8_t *out = reserve(size);
+  if (!out)
+    return;
+
+  const format::Record_header header{.format_id = format_id, .size = size, .time = now()};
+  std::memcpy(out, &header, sizeof(header));
+  out += sizeof(header);
+  ((out = encode(out, args)), ...);
+  commit(size);
+}
+
+}    // namespace internal
+}    // namespace blackboard::app::binary_log
+
+// kept in release builds, where the incidents to trace happen: calls are cheap until binary_log::init
+#ifndef BB_LOG_BINARY_ENABLED
+#define BB_LOG_BINARY_ENABLED 1
+#endif
+
+#if BB_LOG_BINARY_ENABLED
+#define BB_LOG_BINARY(...) ::blackboard::app::binary_log::internal::log([] {}, __VA_ARGS__)
+#else
+#define BB_LOG_BINARY(...) (void)0
+#endif
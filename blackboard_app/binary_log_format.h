@@ -0,0 +1,75 @@
+#pragma once
+#include <stdint.h>
+
+// Binary log file layout, shared by blackboard::app::binary_log and the blackboard_log_decode tool.
+//
+// [File_header][Chunk_header, payload]...
+//
+// FORMAT   payload: Format_header, signature, format string. Defines a format id before its first record.
+// EVENTS   payload: Events_header, records of one thread. Every record is a Record_header followed by the
+//          arguments encoded as listed in the signature of its format, the record size is a multiple of 8.
+// DROPPED  payload: uint64_t, records discarded because a thread buffer was full since the previous DROPPED.
+
+namespace blackboard::app::binary_log::format {
+
+inline constexpr uint32_t magic{0x474c4242u};    // "BBLG"
+inline constexpr uint32_t version{1u};
+inline constexpr uint32_t record_alignment{8u};
+
+// Argument encodings, one character per argument in the signature
+inline constexpr char arg_bool{'b'};      // uint8_t
+inline constexpr char arg_char{'c'};      // char
+inline constexpr char arg_int{'i'};       // int64_t
+inline constexpr char arg_uint{'u'};      // uint64_t
+inline constexpr char arg_float{'f'};     // float
+inline constexpr char arg_double{'d'};    // double
+inline constexpr char arg_pointer{'p'};   // uint64_t
+inline constexpr char arg_string{'s'};    // uint32_t size, then the characters
+
+enum class Chunk_type : uint32_t
+{
+  FORMAT = 1,
+  EVENTS,
+  DROPPED
+};
+
+struct File_header
+{
+  uint32_t magic{format::magic};
+  uint32_t version{format::version};
+  uint64_t start_time{0u};    // nanoseconds since the unix epoch when the log was opened
+};
+
+struct Chunk_header
+{
+  Chunk_type type{Chunk_type::EVENTS};
+  uint32_t size{0u};    // of the payload
+};
+
+struct Format_header
+{
+  uint32_t id{0u};
+  uint16_t signature_size{0u};
+  uint16_t format_size{0u};
+};
+
+struct Events_header
+{
+  uint32_t thread_index{0u};    // order in which the threads logged their first record
+  uint32_t reserved{0u};
+};
+
+struct Record_header
+{
+  uint32_t format_id{0u};
+  uint32_t size{0u};    // including this header
+  uint64_t time{0u};    // nanoseconds since File_header::start_time
+};
+
+static_assert(sizeof(File_header) == 16u);
+static_assert(sizeof(Chunk_header) == 8u);
+static_assert(sizeof(Format_header) == 8u);
+static_assert(sizeof(Events_header) == 8u);
+static_assert(sizeof(Record_header) == 16u);
+
+}    // namespace blackboard::app::binary_log::format
@@ -0,0 +1,48 @@
+#include "event_coalescer.h"
+
+#include <algorithm>
+
+namespace blackboard::app {
+
+const std::vector<SDL_Event> &Event_coalescer::poll()
+{
+  m_events.clear();
+  SDL_Event event;
+  while (SDL_PollEvent(&event))
+    push(event);
+  return m_events;
+}
+
+void Event_coalescer::push(const SDL_Event &event)
+{
+  switch (event.type)
+  {
+    case SDL_EVENT_MOUSE_MOTION:
+      if (!m_events.empty())
+      {
+        auto &previous = m_events.back();
+        if (previous.type == SDL_EVENT_MOUSE_MOTION && previous.motion.windowID == event.motion.windowID &&
+            previous.motion.which == event.motion.which)
+        {
+          const float xrel = previous.motion.xrel + event.motion.xrel;
+          const float yrel = previous.motion.yrel + event.motion.yrel;
+          previous = event;
+          previous.motion.xrel = xrel;
+          previous.motion.yrel = yrel;
+          return;
+        }
+      }
+      break;
+    case SDL_EVENT_WINDOW_RESIZED:
+    case SDL_EVENT_WINDOW_PIXEL_SIZE_CHANGED:
+      std::erase_if(m_events, [&event](const SDL_Event &previous) {
+        return previous.type == event.type && previous.window.windowID == event.window.windowID;
+      });
+      break;
+    default:
+      break;
+  }
+  m_events.push_back(event);
+}
+
+}    // namespace blackboard::app
@@ -0,0 +1,23 @@
+#pragma once
+#include <SDL3/SDL.h>
+
+#include <vector>
+
+namespace blackboard::app {
+
+/// @brief Events of one frame with the storms merged: only the latest resize of every window is kept and
+/// consecutive mouse motions of a window are merged into one carrying the summed relative motion.
+/// The order of the other events is preserved.
+class Event_coalescer
+{
+  public:
+  /// @brief Drain the SDL queue
+  const std::vector<SDL_Event> &poll();
+
+  private:
+  void push(const SDL_Event &event);
+
+  std::vector<SDL_Event> m_events;    // reused every frame
+};
+
+}    // namespace blackboard::app
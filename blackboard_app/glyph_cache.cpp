@@ -0,0 +1,511 @@
+#include "glyph_cache.h"
+
+#include "logger.h"
+#include "vfs.h"
+
+#include <imgui/imgui_internal.h>
+#include <imgui/imstb_truetype.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace blackboard::app::glyph_cache {
+
+// Virtual UVs: the glyph id is split between the integer parts of u (low byte) and v (high byte), the fractional
+// parts locate the vertex inside the glyph so that ImGui can still clip glyphs by interpolating their UVs.
+// Real UVs are in [0, 1], virtual ones start at 2.
+static constexpr float virtual_uv_base{2.0f};
+static constexpr uint32_t max_glyphs{1u << 16u};
+static constexpr uint32_t no_glyph{std::numeric_limits<uint32_t>::max()};
+static constexpr uint32_t no_cell{std::numeric_limits<uint32_t>::max()};
+
+struct Glyph_metrics
+{
+  uint32_t codepoint{0u};
+  int index{0};
+  int x0{0}, y0{0}, x1{0}, y1{0};
+  float advance{0.0f};
+};
+
+struct Font
+{
+  vfs::File file;
+  stbtt_fontinfo info{};
+  Kind kind{Kind::BITMAP};
+  float scale{1.0f};         // stb_truetype scale of the rasterized glyphs
+  float quad_scale{1.0f};    // size of the drawn quads relative to the rasterized glyphs
+  float rasterizer_multiply{1.0f};
+  ImFont *font{nullptr};
+  std::vector<Glyph_metrics> glyphs;
+};
+
+struct Glyph
+{
+  uint16_t font{0u};
+  uint16_t width{0u};
+  uint16_t height{0u};
+  Kind kind{Kind::BITMAP};
+  int index{0};
+  uint32_t cell{no_cell};
+};
+
+// cells are linked from the most recently drawn (head) to the least recently drawn (tail), cell 0 stays empty
+// and is used by the glyphs that do not fit in the page during a frame
+struct Cell
+{
+  uint32_t glyph{no_glyph};
+  int frame{-1};
+  uint32_t previous{no_cell};
+  uint32_t next{no_cell};
+};
+
+struct Page
+{
+  int rect{-1};
+  int cell_width{1};
+  int cell_height{1};
+  int columns{0};
+  std::vector<Cell> cells;
+  std::vector<std::pair<int, int>> dirty_columns;    // first and last dirty column of every row
+  uint32_t head{no_cell};
+  uint32_t tail{no_cell};
+};
+
+static std::vector<Font> fonts;
+static std::vector<Glyph> glyphs;
+static std::array<Page, static_cast<size_t>(Kind::COUNT)> pages;
+static Stats counters;
+
+static Page &page_of(Kind kind)
+{
+  return pages[static_cast<size_t>(kind)];
+}
+
+static const ImFontAtlasCustomRect *page_rect(const ImFontAtlas &atlas, const Page &page)
+{
+  if (page.rect < 0 || page.rect >= atlas.CustomRects.Size)
+    return nullptr;
+  return &atlas.CustomRects[page.rect];
+}
+
+static bool has_fonts(Kind kind)
+{
+  return std::any_of(fonts.begin(), fonts.end(), [kind](const Font &font) { return font.kind == kind; });
+}
+
+static void unlink(Page &page, uint32_t cell)
+{
+  auto &c = page.cells[cell];
+  (c.previous != no_cell ? page.cells[c.previous].next : page.head) = c.next;
+  (c.next != no_cell ? page.cells[c.next].previous : page.tail) = c.previous;
+  c.previous = c.next = no_cell;
+}
+
+static void push_front(Page &page, uint32_t cell)
+{
+  auto &c = page.cells[cell];
+  c.previous = no_cell;
+  c.next = page.head;
+  (page.head != no_cell ? page.cells[page.head].previous : page.tail) = cell;
+  page.head = cell;
+}
+
+static void touch(Page &page, uint32_t cell, int frame)
+{
+  if (page.cells[cell].frame == frame)
+    return;
+  page.cells[cell].frame = frame;
+  unlink(page, cell);
+  push_front(page, cell);
+}
+
+static void rasterize(const Glyph &glyph, Page &page, uint32_t cell, ImFontAtlas &atlas)
+{
+  const auto *rect = page_rect(atlas, page);
+  const int column = static_cast<int>(cell) % page.columns;
+  const int row = static_cast<int>(cell) / page.columns;
+  const int x = rect->X + column * (page.cell_width + 1);
+  const int y = rect->Y + row * (page.cell_height + 1);
+
+  unsigned char *pixels = atlas.TexPixelsAlpha8 + y * atlas.TexWidth + x;
+  for (int i = 0; i < page.cell_height; ++i)
+    std::memset(pixels + i * atlas.TexWidth, 0, static_cast<size_t>(page.cell_width));
+
+  const auto &font = fonts[glyph.font];
+  if (glyph.kind == Kind::SDF)
+  {
+    // distance 0.5 on the edge, 0 and 1 sdf_padding pixels outside and inside
+    int width{0}, height{0}, x_offset{0}, y_offset{0};
+    unsigned char *sdf = stbtt_GetGlyphSDF(&font.info, font.scale, glyph.index, sdf_padding, 128,
+                                           128.0f / static_cast<float>(sdf_padding), &width, &height, &x_offset,
+                                           &y_offset);
+    if (sdf)
+    {
+      const int copy_width = std::min(width, static_cast<int>(glyph.width));
+      for (int i = 0; i < std::min(height, static_cast<int>(glyph.height)); ++i)
+        std::memcpy(pixels + i * atlas.TexWidth, sdf + i * width, static_cast<size_t>(copy_width));
+      stbtt_FreeSDF(sdf, nullptr);
+    }
+  }
+  else
+  {
+    stbtt_MakeGlyphBitmap(&font.info, pixels, glyph.width, glyph.height, atlas.TexWidth, font.scale, font.scale,
+                          glyph.index);
+    if (font.rasterizer_multiply != 1.0f)
+    {
+      unsigned char table[256];
+      ImFontAtlasBuildMultiplyCalcLookupTable(table, font.rasterizer_multiply);
+      ImFontAtlasBuildMultiplyRectAlpha8(table, atlas.TexPixelsAlpha8, x, y, glyph.width, glyph.height,
+                                         atlas.TexWidth);
+    }
+  }
+
+  auto &dirty = page.dirty_columns[static_cast<size_t>(row)];
+  dirty = {std::min(dirty.first, column), std::max(dirty.second, column)};
+  ++counters.rasterized;
+}
+
+static uint32_t acquire(uint32_t id, int frame, ImFontAtlas &atlas)
+{
+  auto &glyph = glyphs[id];
+  auto &page = page_of(glyph.kind);
+  if (glyph.cell != no_cell)
+  {
+    touch(page, glyph.cell, frame);
+    return glyph.cell;
+  }
+
+  // glyphs drawn by this frame can not be evicted, their vertices already point to their cells
+  const uint32_t cell = page.tail;
+  if (cell == no_cell || page.cells[cell].frame == frame || !atlas.TexPixelsAlpha8)
+  {
+    BB_LOG_LIMITED(spdlog::level::warn, 1, "Glyph cache full, increase glyph_cache::page_size");
+    return 0u;
+  }
+
+  if (page.cells[cell].glyph != no_glyph)
+  {
+    glyphs[page.cells[cell].glyph].cell = no_cell;
+    ++counters.evicted;
+  }
+  page.cells[cell].glyph = id;
+  glyph.cell = cell;
+  rasterize(glyph, page, cell, atlas);
+  touch(page, cell, frame);
+  return cell;
+}
+
+ImFont *add_font(ImFontAtlas &atlas, const std::filesystem::path &path, float size_pixels, const ImWchar *glyph_ranges,
+                 float rasterizer_multiply, Kind kind)
+{
+  Font entry;
+  entry.file = vfs::open(path);
+  if (!entry.file.is_open())
+  {
+    BB_LOG_ERROR("Error opening font {}", path.string());
+    return nullptr;
+  }
+  const unsigned char *data = entry.file.data();
+  if (!stbtt_InitFont(&entry.info, data, stbtt_GetFontOffsetForIndex(data, 0)))
+  {
+    BB_LOG_ERROR("Invalid font {}", path.string());
+    return nullptr;
+  }
+  // SDF glyphs are rasterized once at sdf_size and their quads scaled to the font size
+  const float display_scale = stbtt_ScaleForPixelHeight(&entry.info, size_pixels);
+  const int padding = kind == Kind::SDF ? sdf_padding : 0;
+  entry.kind = kind;
+  entry.scale = kind == Kind::SDF ? stbtt_ScaleForPixelHeight(&entry.info, sdf_size) : display_scale;
+  entry.quad_scale = display_scale / entry.scale;
+  entry.rasterizer_multiply = rasterizer_multiply;
+
+  // metrics only, no rasterization
+  static constexpr ImWchar whole_font[]{0x0020, 0xFFFF, 0};
+  for (const ImWchar *range = glyph_ranges ? glyph_ranges : whole_font; range[0] && range[1]; range += 2)
+  {
+    for (uint32_t codepoint = range[0]; codepoint <= range[1]; ++codepoint)
+    {
+      const int index = stbtt_FindGlyphIndex(&entry.info, static_cast<int>(codepoint));
+      if (index == 0)
+        continue;
+      Glyph_metrics metrics{.codepoint = codepoint, .index = index};
+      int advance{0}, left_side_bearing{0};
+      stbtt_GetGlyphHMetrics(&entry.info, index, &advance, &left_side_bearing);
+      stbtt_GetGlyphBitmapBox(&entry.info, index, entry.scale, entry.scale, &metrics.x0, &metrics.y0, &metrics.x1,
+                              &metrics.y1);
+      if (padding > 0 && metrics.x1 > metrics.x0 && metrics.y1 > metrics.y0)
+      {
+        // same box as stbtt_GetGlyphSDF
+        metrics.x0 -= padding;
+        metrics.y0 -= padding;
+        metrics.x1 += padding;
+        metrics.y1 += padding;
+      }
+      metrics.advance = static_cast<float>(advance) * display_scale;
+      entry.glyphs.push_back(metrics);
+    }
+  }
+
+  // ImGui only rasterizes the space, add_glyphs adds the other glyphs once the atlas is built
+  static constexpr ImWchar space[]{0x0020, 0x0020, 0};
+  ImFontConfig config;
+  config.FontData = const_cast<unsigned char *>(data);
+  config.FontDataSize = static_cast<int>(entry.file.size());
+  config.FontDataOwnedByAtlas = false;
+  config.SizePixels = size_pixels;
+  config.GlyphRanges = space;
+  config.OversampleH = 1;
+  config.OversampleV = 1;
+  config.RasterizerMultiply = rasterizer_multiply;
+  entry.font = atlas.AddFont(&config);
+
+  BB_LOG_DEBUG("Dynamic {}font {}: {} glyphs", kind == Kind::SDF ? "SDF " : "", path.string(), entry.glyphs.size());
+  fonts.push_back(std::move(entry));
+  return fonts.back().font;
+}
+
+bool empty()
+{
+  return fonts.empty();
+}
+
+void reserve(ImFontAtlas &atlas)
+{
+  if (fonts.empty())
+    return;
+  for (size_t kind = 0; kind < pages.size(); ++kind)
+  {
+    auto &page = pages[kind];
+    if (has_fonts(static_cast<Kind>(kind)) && !page_rect(atlas, page))
+      page.rect = atlas.AddCustomRectRegular(page_size, page_size);
+  }
+  // the pages and the static glyphs side by side
+  atlas.TexDesiredWidth = std::max(atlas.TexDesiredWidth, page_size * 2);
+}
+
+int page_count(const ImFontAtlas &atlas)
+{
+  return static_cast<int>(
+    std::count_if(pages.begin(), pages.end(), [&atlas](const auto &page) { return page_rect(atlas, page); }));
+}
+
+void add_glyphs(ImFontAtlas &atlas)
+{
+  glyphs.clear();
+  for (size_t kind = 0; kind < pages.size(); ++kind)
+  {
+    auto &page = pages[kind];
+    page.cells.clear();
+    page.dirty_columns.clear();
+    page.head = page.tail = no_cell;
+    const auto *rect = page_rect(atlas, page);
+    if (!rect)
+      continue;
+
+    // cells fit the largest glyph, up to twice the rasterized font size: bigger glyphs are cropped
+    page.cell_width = page.cell_height = 1;
+    for (const auto &font : fonts)
+    {
+      if (font.kind != static_cast<Kind>(kind))
+        continue;
+      const float raster_size = font.kind == Kind::SDF ? sdf_size : font.font->FontSize;
+      const int limit = static_cast<int>(std::ceil(raster_size * 2.0f)) +
+                        (font.kind == Kind::SDF ? sdf_padding * 2 : 0);
+      for (const auto &metrics : font.glyphs)
+      {
+        page.cell_width = std::max(page.cell_width, std::min(metrics.x1 - metrics.x0, limit));
+        page.cell_height = std::max(page.cell_height, std::min(metrics.y1 - metrics.y0, limit));
+      }
+    }
+    page.columns = rect->Width / (page.cell_width + 1);
+    const int rows = rect->Height / (page.cell_height + 1);
+    page.cells.resize(static_cast<size_t>(page.columns * rows));
+    page.dirty_columns.assign(static_cast<size_t>(rows), {std::numeric_limits<int>::max(), -1});
+    for (uint32_t cell = 1u; cell < page.cells.size(); ++cell)
+      push_front(page, cell);
+  }
+  if (fonts.empty())
+    return;
+
+  for (size_t font_index = 0; font_index < fonts.size(); ++font_index)
+  {
+    auto &font = fonts[font_index];
+    const auto &page = page_of(font.kind);
+    if (page.cells.empty())
+      continue;
+    ImFont *imgui_font = font.font;
+    const ImFontConfig *config = imgui_font->ConfigData;
+    const float offset_x = config->GlyphOffset.x;
+    const float offset_y = config->GlyphOffset.y + IM_ROUND(imgui_font->Ascent);
+    for (const auto &metrics : font.glyphs)
+    {
+      if (imgui_font->FindGlyphNoFallback(static_cast<ImWchar>(metrics.codepoint)))
+        continue;    // rasterized by ImGui
+      if (glyphs.size() == max_glyphs)
+      {
+        BB_LOG_WARN("Too many dynamic glyphs, restrict the glyph ranges of the dynamic fonts");
+        break;
+      }
+
+      const auto id = static_cast<uint32_t>(glyphs.size());
+      const Glyph glyph{.font = static_cast<uint16_t>(font_index),
+                        .width = static_cast<uint16_t>(std::min(metrics.x1 - metrics.x0, page.cell_width)),
+                        .height = static_cast<uint16_t>(std::min(metrics.y1 - metrics.y0, page.cell_height)),
+                        .kind = font.kind,
+                        .index = metrics.index};
+      glyphs.push_back(glyph);
+
+      // same adjustments as ImFont::AddGlyph
+      float x0 = static_cast<float>(metrics.x0) * font.quad_scale + offset_x;
+      float advance = std::clamp(metrics.advance, config->GlyphMinAdvanceX, config->GlyphMaxAdvanceX);
+      if (advance != metrics.advance)
+        x0 += config->PixelSnapH ? ImFloor((advance - metrics.advance) * 0.5f) : (advance - metrics.advance) * 0.5f;
+      if (config->PixelSnapH)
+        advance = IM_ROUND(advance);
+      advance += config->GlyphExtraSpacing.x;
+
+      ImFontGlyph imgui_glyph{};
+      imgui_glyph.Codepoint = metrics.codepoint;
+      imgui_glyph.Visible = glyph.width > 0u && glyph.height > 0u;
+      imgui_glyph.AdvanceX = advance;
+      imgui_glyph.X0 = x0;
+      imgui_glyph.Y0 = static_cast<float>(metrics.y0) * font.quad_scale + offset_y;
+      imgui_glyph.X1 = imgui_glyph.X0 + static_cast<float>(glyph.width) * font.quad_scale;
+      imgui_glyph.Y1 = imgui_glyph.Y0 + static_cast<float>(glyph.height) * font.quad_scale;
+      imgui_glyph.U0 = virtual_uv_base + static_cast<float>(id & 0xffu) * 2.0f;
+      imgui_glyph.V0 = virtual_uv_base + static_cast<float>(id >> 8u) * 2.0f;
+      imgui_glyph.U1 = imgui_glyph.U0 + 1.0f;
+      imgui_glyph.V1 = imgui_glyph.V0 + 1.0f;
+      imgui_font->Glyphs.push_back(imgui_glyph);
+    }
+    imgui_font->BuildLookupTable();
+  }
+}
+
+void resolve(ImDrawVert *vertices, const ImDrawIdx *indices, const ImDrawCmd &command)
+{
+  if (glyphs.empty())
+    return;
+
+  auto &atlas = *ImGui::GetIO().Fonts;
+  const int frame = ImGui::GetFrameCount();
+  // vertices shared by several indices are resolved once, their UVs are no longer virtual after the first
+  for (uint32_t i = command.IdxOffset; i < command.IdxOffset + command.ElemCount; ++i)
+  {
+    auto &vertex = vertices[command.VtxOffset + indices[i]];
+    if (vertex.uv.x < virtual_uv_base)
+      continue;
+
+    const float u = vertex.uv.x - virtual_uv_base;
+    const float v = vertex.uv.y - virtual_uv_base;
+    const auto low = static_cast<uint32_t>(u * 0.5f);
+    const auto high = static_cast<uint32_t>(v * 0.5f);
+    const uint32_t id = low | (high << 8u);
+    if (id >= glyphs.size())
+      continue;
+
+    const auto &glyph = glyphs[id];
+    const auto &page = page_of(glyph.kind);
+    const auto *rect = page_rect(atlas, page);
+    if (!rect)
+      continue;
+
+    const uint32_t cell = acquire(id, frame, atlas);
+    const float fraction_u = std::clamp(u - static_cast<float>(low) * 2.0f, 0.0f, 1.0f);
+    const float fraction_v = std::clamp(v - static_cast<float>(high) * 2.0f, 0.0f, 1.0f);
+    const float x = static_cast<float>(rect->X + static_cast<int>(cell) % page.columns * (page.cell_width + 1)) +
+                    fraction_u * glyph.width;
+    const float y = static_cast<float>(rect->Y + static_cast<int>(cell) / page.columns * (page.cell_height + 1)) +
+                    fraction_v * glyph.height;
+    vertex.uv = ImVec2(x * atlas.TexUvScale.x, y * atlas.TexUvScale.y);
+  }
+}
+
+void upload(bgfx::TextureHandle texture, bgfx::TextureFormat::Enum format)
+{
+  if (glyphs.empty() || !bgfx::isValid(texture))
+    return;
+
+  const auto &atlas = *ImGui::GetIO().Fonts;
+  if (!atlas.TexPixelsAlpha8)
+    return;
+
+  for (auto &page : pages)
+  {
+    const auto *rect = page_rect(atlas, page);
+    if (!rect)
+      continue;
+
+    // one update per row of cells, from its first to its last rasterized cell
+    for (size_t row = 0; row < page.dirty_columns.size(); ++row)
+    {
+      auto &dirty = page.dirty_columns[row];
+      if (dirty.second < 0)
+        continue;
+
+      const int x = rect->X + dirty.first * (page.cell_width + 1);
+      const int y = rect->Y + static_cast<int>(row) * (page.cell_height + 1);
+      const int width = (dirty.second - dirty.first + 1) * (page.cell_width + 1);
+      const int height = page.cell_height + 1;
+      const uint32_t texel_size = format == bgfx::TextureFormat::RGBA8 ? 4u : 1u;
+      const bgfx::Memory *memory = bgfx::alloc(static_cast<uint32_t>(width * height) * texel_size);
+      for (int i = 0; i < height; ++i)
+      {
+        const uint8_t *source = atlas.TexPixelsAlpha8 + (y + i) * atlas.TexWidth + x;
+        uint8_t *destination = memory->data + i * width * texel_size;
+        if (texel_size == 1u)
+        {
+          std::memcpy(destination, source, static_cast<size_t>(width));
+          continue;
+        }
+        for (int texel = 0; texel < width; ++texel, destination += 4)
+        {
+          destination[0] = destination[1] = destination[2] = 255u;
+          destination[3] = source[texel];
+        }
+      }
+      bgfx::updateTexture2D(texture, 0, 0, static_cast<uint16_t>(x), static_cast<uint16_t>(y),
+                            static_cast<uint16_t>(width), static_cast<uint16_t>(height), memory);
+      dirty = {std::numeric_limits<int>::max(), -1};
+    }
+  }
+}
+
+bool sdf_page_uvs(float uvs[4])
+{
+  const auto &atlas = *ImGui::GetIO().Fonts;
+  const auto *rect = page_rect(atlas, page_of(Kind::SDF));
+  if (!rect || page_of(Kind::SDF).cells.empty())
+    return false;
+  uvs[0] = static_cast<float>(rect->X) * atlas.TexUvScale.x;
+  uvs[1] = static_cast<float>(rect->Y) * atlas.TexUvScale.y;
+  uvs[2] = static_cast<float>(rect->X + rect->Width) * atlas.TexUvScale.x;
+  uvs[3] = static_cast<float>(rect->Y + rect->Height) * atlas.TexUvScale.y;
+  return true;
+}
+
+Stats stats()
+{
+  Stats result{counters};
+  for (const auto &page : pages)
+  {
+    result.cells += page.cells.empty() ? 0u : static_cast<uint32_t>(page.cells.size() - 1u);
+    result.cached_glyphs += static_cast<uint32_t>(
+      std::count_if(page.cells.begin(), page.cells.end(), [](const Cell &cell) { return cell.glyph != no_glyph; }));
+  }
+  return result;
+}
+
+void shutdown()
+{
+  glyphs.clear();
+  pages = {};
+  fonts.clear();
+  counters = {};
+}
+
+}    // namespace blackboard::app::glyph_cache
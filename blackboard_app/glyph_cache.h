@@ -0,0 +1,73 @@
+#pragma once
+#include <stdint.h>
+
+#include <bgfx/bgfx.h>
+#include <imgui/imgui.h>
+
+#include <filesystem>
+
+// Glyphs of the dynamic fonts (gui::load_dynamic_font, gui::load_sdf_font) are rasterized the first time a frame
+// draws them. ImGui knows the metrics of every glyph of the font, but their UVs are virtual: the backend replaces them
+// by the position of the glyph inside a page reserved in the font atlas, rasterizing missing glyphs and evicting the
+// least recently drawn ones when the page is full. Only the page rows that changed are uploaded.
+// SDF glyphs live in their own page, the ImGui shader reads the texels of that page as signed distances.
+
+namespace blackboard::app::glyph_cache {
+
+/// @brief Side of the pages reserved inside the font atlas
+inline constexpr int page_size{1024};
+
+/// @brief Signed distance fields are rasterized at this size whatever the size of the font, with sdf_padding pixels
+/// of distance around the glyphs. The glyph edge is at the distance value 0.5.
+inline constexpr float sdf_size{32.0f};
+inline constexpr int sdf_padding{4};
+
+enum class Kind : uint8_t
+{
+  BITMAP = 0,
+  SDF,
+  COUNT
+};
+
+/// @brief Register a font in the atlas, only the metrics of its glyphs are read.
+/// Returns nullptr if the font can not be opened or parsed.
+ImFont *add_font(ImFontAtlas &atlas, const std::filesystem::path &path, float size_pixels, const ImWchar *glyph_ranges,
+                 float rasterizer_multiply, Kind kind = Kind::BITMAP);
+
+/// @brief No dynamic font registered
+bool empty();
+
+/// @brief Reserve the pages inside the atlas, before the atlas is built
+void reserve(ImFontAtlas &atlas);
+
+/// @brief Custom rectangles of the atlas reserved as pages, one per kind of dynamic font loaded
+int page_count(const ImFontAtlas &atlas);
+
+/// @brief Add the glyphs with virtual UVs to the dynamic fonts once the atlas is built, the pages are emptied
+void add_glyphs(ImFontAtlas &atlas);
+
+/// @brief Replace the virtual UVs of the vertices drawn by command with the page positions of their glyphs.
+/// Only for commands drawing the font atlas, other textures may use UVs past 1 to repeat
+void resolve(ImDrawVert *vertices, const ImDrawIdx *indices, const ImDrawCmd &command);
+
+/// @brief Upload the glyphs rasterized since the last upload into the font atlas texture, A8 or RGBA8 with white
+/// texels as built by ImFontAtlas::GetTexDataAsRGBA32
+void upload(bgfx::TextureHandle texture, bgfx::TextureFormat::Enum format = bgfx::TextureFormat::A8);
+
+/// @brief UVs of the SDF page as min x, min y, max x, max y, false without SDF fonts
+bool sdf_page_uvs(float uvs[4]);
+
+struct Stats
+{
+  uint32_t cells{0u};
+  uint32_t cached_glyphs{0u};
+  uint64_t rasterized{0u};
+  uint64_t evicted{0u};
+};
+
+Stats stats();
+
+/// @brief Release the fonts, called by gui::shutdown
+void shutdown();
+
+}    // namespace blackboard::app::glyph_cache
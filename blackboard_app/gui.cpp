@@ -1,11 +1,38 @@
 #include "gui.h"
 
+#include "glyph_cache.h"
+#include "logger.h"
+#include "mapped_file.h"
+#include "pack.h"
+#include "resources.h"
+#include "vfs.h"
+
 #include <bgfx/bgfx.h>
 #include <imgui/imgui.h>
 #include <imgui/imgui_internal.h>
 
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
 namespace blackboard::app::gui {
 
+// Font files are read by the atlas straight from the vfs, they have to outlive the ImGui context
+static std::vector<vfs::File> font_files;
+
+// Fonts may be loaded on a worker while the main thread uses ImGuiIO, their settings are applied by
+// apply_font_settings on the main thread
+struct Font_settings
+{
+  ImFont *default_font{nullptr};
+  float global_scale{0.0f};
+  bool scale_fonts{false};
+};
+static Font_settings font_settings;
+
 void init()
 {
   // Setup Dear ImGui context
@@ -32,6 +59,17 @@ void init()
   }
 }
 
+void shutdown()
+{
+  if (!isInit())
+    return;
+
+  ImGui::DestroyContext();
+  font_files.clear();
+  font_settings = {};
+  glyph_cache::shutdown();
+}
+
 bool isInit()
 {
   return ImGui::GetCurrentContext();
@@ -156,24 +194,310 @@ void load_font(const std::filesystem::path &path, const float size, const float
   font_config.OversampleH = oversample_h;
   font_config.OversampleV = oversample_v;
   auto &io{ImGui::GetIO()};
-  if (!std::filesystem::exists(path))
+  if (path.extension() != ".ttf" && path.extension() != ".otf")
   {
     return;
   }
-  if (path.extension() != ".ttf" && path.extension() != ".otf")
+  vfs::File font_file{vfs::open(path)};
+  if (!font_file.is_open())
   {
     return;
   }
+  // the atlas only reads the font data, it does not own the file
+  font_config.FontDataOwnedByAtlas = false;
   float ratio{ddpi / 96.f};
-  io.Fonts->AddFontFromFileTTF(path.string().c_str(), size * ratio, &font_config);
+  io.Fonts->AddFontFromMemoryTTF(const_cast<uint8_t *>(font_file.data()), static_cast<int>(font_file.size()),
+                                 size * ratio, &font_config);
+  font_files.push_back(std::move(font_file));
   // setup default font
   if (set_as_default)
   {
-    io.FontDefault = io.Fonts->Fonts.back();
+    font_settings.default_font = io.Fonts->Fonts.back();
+  }
+#ifdef __APPLE__
+  font_settings.global_scale = 1.0f / floor(ratio);
+#endif
+}
+
+void apply_font_settings()
+{
+  if (!isInit())
+    return;
+
+  auto &io{ImGui::GetIO()};
+  if (font_settings.default_font)
+  {
+    io.FontDefault = font_settings.default_font;
+  }
+  if (font_settings.global_scale > 0.0f)
+  {
+    io.FontGlobalScale = font_settings.global_scale;
+  }
+  if (font_settings.scale_fonts)
+  {
+    io.ConfigFlags |= ImGuiConfigFlags_DpiEnableScaleFonts;
+  }
+  font_settings = {};
+}
+
+// Font atlas cache, one file per set of fonts named by the hash of everything the rasterization depends on:
+// [Atlas_cache_header][Atlas_cache_font * font_count][ImFontGlyph * glyphs of every font]
+// [Atlas_cache_rect * rect_count][alpha8 pixels]
+struct Atlas_cache_header
+{
+  uint32_t magic{0x41464242u};    // "BBFA"
+  uint32_t version{IMGUI_VERSION_NUM};
+  uint64_t key{0u};
+  uint32_t width{0u};
+  uint32_t height{0u};
+  uint32_t font_count{0u};
+  uint32_t rect_count{0u};
+};
+
+struct Atlas_cache_font
+{
+  float ascent{0.0f};
+  float descent{0.0f};
+  uint32_t glyph_count{0u};
+  int32_t metrics_total_surface{0};
+};
+
+struct Atlas_cache_rect
+{
+  uint16_t x{0u};
+  uint16_t y{0u};
+};
+
+static std::filesystem::path atlas_cache_path(uint64_t key)
+{
+  return resources::path() / "cache" / "fonts" / fmt::format("{:016x}.atlas", key);
+}
+
+template<typename T>
+static void append_bytes(std::string &bytes, const T &value)
+{
+  bytes.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+// the size of a font already includes the dpi ratio, see load_font
+static uint64_t atlas_cache_key(ImFontAtlas &atlas)
+{
+  std::string bytes;
+  append_bytes(bytes, IMGUI_VERSION_NUM);
+  append_bytes(bytes, sizeof(ImFontGlyph));
+  append_bytes(bytes, atlas.Flags);
+  append_bytes(bytes, atlas.TexDesiredWidth);
+  append_bytes(bytes, atlas.TexGlyphPadding);
+  for (const auto &config : atlas.ConfigData)
+  {
+    append_bytes(bytes, pack::hash({static_cast<const char *>(config.FontData), static_cast<size_t>(config.FontDataSize)}));
+    append_bytes(bytes, config.FontNo);
+    append_bytes(bytes, config.SizePixels);
+    append_bytes(bytes, config.OversampleH);
+    append_bytes(bytes, config.OversampleV);
+    append_bytes(bytes, config.PixelSnapH);
+    append_bytes(bytes, config.GlyphExtraSpacing);
+    append_bytes(bytes, config.GlyphOffset);
+    append_bytes(bytes, config.GlyphMinAdvanceX);
+    append_bytes(bytes, config.GlyphMaxAdvanceX);
+    append_bytes(bytes, config.MergeMode);
+    append_bytes(bytes, config.FontBuilderFlags);
+    append_bytes(bytes, config.RasterizerMultiply);
+    append_bytes(bytes, config.EllipsisChar);
+    append_bytes(bytes, static_cast<int32_t>(std::find(atlas.Fonts.begin(), atlas.Fonts.end(), config.DstFont) -
+                                             atlas.Fonts.begin()));
+    for (const ImWchar *range = config.GlyphRanges ? config.GlyphRanges : atlas.GetGlyphRangesDefault(); *range;
+         ++range)
+      append_bytes(bytes, *range);
+    append_bytes(bytes, ImWchar{0});
+  }
+  return pack::hash(bytes);
+}
+
+static bool restore_font_atlas(ImFontAtlas &atlas, uint64_t key, std::span<const uint8_t> file)
+{
+  Atlas_cache_header header;
+  if (file.size() < sizeof(header))
+    return false;
+  std::memcpy(&header, file.data(), sizeof(header));
+  if (header.magic != Atlas_cache_header{}.magic || header.version != Atlas_cache_header{}.version ||
+      header.key != key || header.font_count != static_cast<uint32_t>(atlas.Fonts.Size))
+    return false;
+
+  size_t offset{sizeof(header)};
+  if (offset + header.font_count * sizeof(Atlas_cache_font) > file.size())
+    return false;
+  std::vector<Atlas_cache_font> fonts(header.font_count);
+  std::memcpy(fonts.data(), file.data() + offset, fonts.size() * sizeof(Atlas_cache_font));
+  offset += fonts.size() * sizeof(Atlas_cache_font);
+
+  size_t glyph_count{0u};
+  for (const auto &font : fonts)
+    glyph_count += font.glyph_count;
+  const size_t glyphs_offset{offset};
+  const size_t rects_offset{glyphs_offset + glyph_count * sizeof(ImFontGlyph)};
+  const size_t pixels_offset{rects_offset + header.rect_count * sizeof(Atlas_cache_rect)};
+  if (pixels_offset + static_cast<size_t>(header.width) * header.height != file.size())
+    return false;
+
+  // registers the mouse cursors and lines rectangles, their pixels are rendered again by ImFontAtlasBuildFinish
+  ImFontAtlasBuildInit(&atlas);
+  if (header.rect_count != static_cast<uint32_t>(atlas.CustomRects.Size))
+    return false;
+
+  atlas.ClearTexData();
+  atlas.TexWidth = static_cast<int>(header.width);
+  atlas.TexHeight = static_cast<int>(header.height);
+  atlas.TexUvScale = ImVec2(1.0f / atlas.TexWidth, 1.0f / atlas.TexHeight);
+  atlas.TexPixelsAlpha8 = static_cast<unsigned char *>(IM_ALLOC(static_cast<size_t>(header.width) * header.height));
+  std::memcpy(atlas.TexPixelsAlpha8, file.data() + pixels_offset, static_cast<size_t>(header.width) * header.height);
+
+  for (auto &config : atlas.ConfigData)
+  {
+    const auto index = std::find(atlas.Fonts.begin(), atlas.Fonts.end(), config.DstFont) - atlas.Fonts.begin();
+    ImFontAtlasBuildSetupFont(&atlas, config.DstFont, &config, fonts[index].ascent, fonts[index].descent);
+  }
+  offset = glyphs_offset;
+  for (int i = 0; i < atlas.Fonts.Size; ++i)
+  {
+    auto *font = atlas.Fonts[i];
+    font->Glyphs.resize(static_cast<int>(fonts[i].glyph_count));
+    std::memcpy(font->Glyphs.Data, file.data() + offset, fonts[i].glyph_count * sizeof(ImFontGlyph));
+    offset += fonts[i].glyph_count * sizeof(ImFontGlyph);
+    font->MetricsTotalSurface = fonts[i].metrics_total_surface;
+    font->DirtyLookupTables = true;
+  }
+  for (int i = 0; i < atlas.CustomRects.Size; ++i)
+  {
+    Atlas_cache_rect rect;
+    std::memcpy(&rect, file.data() + rects_offset + i * sizeof(rect), sizeof(rect));
+    atlas.CustomRects[i].X = rect.x;
+    atlas.CustomRects[i].Y = rect.y;
+  }
+
+  ImFontAtlasBuildFinish(&atlas);
+  return true;
+}
+
+static void save_font_atlas(const ImFontAtlas &atlas, uint64_t key)
+{
+  if (!atlas.TexPixelsAlpha8)
+    return;
+
+  const auto path = atlas_cache_path(key);
+  std::error_code error;
+  std::filesystem::create_directories(path.parent_path(), error);
+  auto temporary_path = path;
+  temporary_path += ".tmp";
+  {
+    std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+      BB_LOG_WARN("Can not write the font atlas cache {}", path.string());
+      return;
+    }
+
+    const Atlas_cache_header header{.key = key,
+                                    .width = static_cast<uint32_t>(atlas.TexWidth),
+                                    .height = static_cast<uint32_t>(atlas.TexHeight),
+                                    .font_count = static_cast<uint32_t>(atlas.Fonts.Size),
+                                    .rect_count = static_cast<uint32_t>(atlas.CustomRects.Size)};
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    for (const auto *font : atlas.Fonts)
+    {
+      const Atlas_cache_font cached{.ascent = font->Ascent,
+                                    .descent = font->Descent,
+                                    .glyph_count = static_cast<uint32_t>(font->Glyphs.Size),
+                                    .metrics_total_surface = font->MetricsTotalSurface};
+      file.write(reinterpret_cast<const char *>(&cached), sizeof(cached));
+    }
+    for (const auto *font : atlas.Fonts)
+      file.write(reinterpret_cast<const char *>(font->Glyphs.Data), font->Glyphs.Size * sizeof(ImFontGlyph));
+    for (const auto &rect : atlas.CustomRects)
+    {
+      const Atlas_cache_rect cached{.x = rect.X, .y = rect.Y};
+      file.write(reinterpret_cast<const char *>(&cached), sizeof(cached));
+    }
+    file.write(reinterpret_cast<const char *>(atlas.TexPixelsAlpha8),
+               static_cast<std::streamsize>(atlas.TexWidth) * atlas.TexHeight);
+  }
+  // another instance may be reading the previous file
+  std::filesystem::rename(temporary_path, path, error);
+}
+
+void build_font_atlas()
+{
+  if (!isInit())
+    return;
+
+  auto &atlas{*ImGui::GetIO().Fonts};
+  if (atlas.IsBuilt())
+    return;
+  if (atlas.ConfigData.Size == 0)
+    atlas.AddFontDefault();
+  glyph_cache::reserve(atlas);
+
+  // custom rectangles of the application are filled after the build, they can not be cached
+  const int known_rects{(atlas.PackIdMouseCursors >= 0 ? 1 : 0) + (atlas.PackIdLines >= 0 ? 1 : 0) +
+                        glyph_cache::page_count(atlas)};
+  if (atlas.CustomRects.Size != known_rects)
+  {
+    atlas.Build();
+    glyph_cache::add_glyphs(atlas);
+    return;
+  }
+
+  const auto key = atlas_cache_key(atlas);
+  if (const Mapped_file file{atlas_cache_path(key)}; file.is_open() && restore_font_atlas(atlas, key, file.span()))
+  {
+    BB_LOG_DEBUG("Font atlas {:016x} restored from the cache", key);
+  }
+  else
+  {
+    atlas.ClearTexData();
+    atlas.Build();
+    save_font_atlas(atlas, key);
+  }
+  // the dynamic glyphs are not part of the cached atlas
+  glyph_cache::add_glyphs(atlas);
+}
+
+ImFont *load_dynamic_font(const std::filesystem::path &path, const float size, const float ddpi,
+                          const bool set_as_default, const ImWchar *glyph_ranges, const float rasterizer_multiply)
+{
+  if (!isInit())
+    return nullptr;
+
+  auto &io{ImGui::GetIO()};
+  const float ratio{ddpi / 96.f};
+  ImFont *font = glyph_cache::add_font(*io.Fonts, path, size * ratio, glyph_ranges, rasterizer_multiply);
+  if (font && set_as_default)
+  {
+    font_settings.default_font = font;
   }
 #ifdef __APPLE__
-  io.FontGlobalScale = 1.0f / floor(ratio);
+  font_settings.global_scale = 1.0f / floor(ratio);
+#endif
+  return font;
+}
+
+ImFont *load_sdf_font(const std::filesystem::path &path, const float size, const bool set_as_default,
+                      const ImWchar *glyph_ranges)
+{
+  if (!isInit())
+    return nullptr;
+
+  auto &io{ImGui::GetIO()};
+  ImFont *font = glyph_cache::add_font(*io.Fonts, path, size, glyph_ranges, 1.0f, glyph_cache::Kind::SDF);
+  if (font && set_as_default)
+  {
+    font_settings.default_font = font;
+  }
+#ifndef __APPLE__
+  // the framebuffer scale already covers retina displays
+  font_settings.scale_fonts = true;
 #endif
+  return font;
 }
 
 void dockspace()
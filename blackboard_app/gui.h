@@ -1,4 +1,5 @@
 #pragma once
+#include <imgui/imgui.h>
 
 #include <filesystem>
 #include <string>
@@ -16,6 +17,9 @@ namespace gui {
 
 void init();
 
+/// @brief Destroy the ImGui context and release the font files
+void shutdown();
+
 bool isInit();
 
 void set_blackboard_theme();
@@ -26,6 +30,27 @@ void dockspace();
 void load_font(const std::filesystem::path &path, const float size, const float ddpi, const bool set_as_default = false,
                const int oversample_h = 4, const int oversample_v = 4, const float rasterizer_multiply = 1.25f);
 
+/// @brief Load a font whose glyphs are rasterized the first time they are drawn and kept in a fixed size cache,
+/// for fonts with a wide coverage (CJK, symbols). All the glyphs of the font are available when glyph_ranges is null.
+/// Returns nullptr if the font can not be loaded.
+ImFont *load_dynamic_font(const std::filesystem::path &path, const float size, const float ddpi,
+                          const bool set_as_default = false, const ImWchar *glyph_ranges = nullptr,
+                          const float rasterizer_multiply = 1.25f);
+
+/// @brief Load a font drawn from signed distance fields: its glyphs are rasterized once and stay sharp at every
+/// scale, a DPI or zoom change does not rebuild the atlas. size is in 96 dpi pixels, windows are scaled to the DPI
+/// of their monitor (ImGuiConfigFlags_DpiEnableScaleFonts). Returns nullptr if the font can not be loaded.
+ImFont *load_sdf_font(const std::filesystem::path &path, const float size, const bool set_as_default = false,
+                      const ImWchar *glyph_ranges = nullptr);
+
+/// @brief Set the default font and the font scale chosen by the load_*font calls, they only write ImGuiIO here.
+/// Main thread, called by App after on_load and after on_init
+void apply_font_settings();
+
+/// @brief Rasterize the fonts added with load_font, or restore them from the font atlas cache when the same fonts
+/// were rasterized by a previous run. Called by App on a worker while the renderer initializes.
+void build_font_atlas();
+
 // input format #aa1199ff
 ImVec4 string_hex_to_rgba_float(const std::string &color);
 
@@ -0,0 +1,192 @@
+#include "log_console.h"
+
+#include "logger.h"
+
+#include <imgui/imgui.h>
+
+#include <algorithm>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+using namespace blackboard::app;
+
+// lines scanned per frame when the filter changes, the rest are scanned over the next frames
+constexpr uint64_t scan_budget{200000u};
+
+// copy of a displayed line, the ring is only locked while the visible lines are copied
+struct Visible_line
+{
+  size_t offset{0u};    // in Console::visible_text
+  size_t size{0u};
+  spdlog::level::level_enum level{spdlog::level::off};
+};
+
+struct Console
+{
+  char filter[256]{};
+  int min_level{spdlog::level::trace};
+  bool auto_scroll{true};
+  // sequence numbers of the lines passing the filter, a circular buffer as large as the line index of the ring:
+  // the lines it refers to are still in the ring, so it never grows
+  std::vector<uint64_t> matches;
+  size_t matches_head{0u};
+  size_t match_count{0u};
+  uint64_t scanned{0u};    // next line to test against the filter
+  std::vector<char> visible_text;
+  std::vector<Visible_line> visible_lines;
+
+  uint64_t match(size_t index) const
+  {
+    return matches[(matches_head + index) % matches.size()];
+  }
+};
+
+Console console;
+
+ImVec4 level_color(spdlog::level::level_enum level)
+{
+  switch (level)
+  {
+    case spdlog::level::trace:
+    case spdlog::level::debug:
+      return {0.55f, 0.55f, 0.55f, 1.f};
+    case spdlog::level::warn:
+      return {1.f, 0.8f, 0.3f, 1.f};
+    case spdlog::level::err:
+    case spdlog::level::critical:
+      return {1.f, 0.4f, 0.4f, 1.f};
+    default:
+      return ImGui::GetStyleColorVec4(ImGuiCol_Text);
+  }
+}
+
+void reset(const logger::Ring_sink &ring)
+{
+  // allocated once, the line capacity of the ring does not change
+  if (console.matches.size() != std::max<size_t>(ring.line_capacity(), 1u))
+    console.matches.assign(std::max<size_t>(ring.line_capacity(), 1u), 0u);
+  console.matches_head = 0u;
+  console.match_count = 0u;
+  console.scanned = ring.first_line();
+}
+
+void update_matches(const logger::Ring_sink &ring)
+{
+  if (console.matches.size() != std::max<size_t>(ring.line_capacity(), 1u))
+    reset(ring);
+
+  // drop the evicted lines
+  const uint64_t first = ring.first_line();
+  while (console.match_count > 0u && console.match(0u) < first)
+  {
+    console.matches_head = (console.matches_head + 1u) % console.matches.size();
+    --console.match_count;
+  }
+
+  const std::string_view filter{console.filter};
+  const uint64_t end = std::min(ring.end_line(), std::max(console.scanned, first) + scan_budget);
+  for (uint64_t sequence = std::max(console.scanned, first); sequence < end; ++sequence)
+  {
+    const auto line = ring.line(sequence);
+    if (line.level < console.min_level || (!filter.empty() && line.text.find(filter) == std::string_view::npos))
+      continue;
+    if (console.match_count == console.matches.size())
+    {
+      // only when lines were evicted during the scan, the oldest match is gone from the ring
+      console.matches_head = (console.matches_head + 1u) % console.matches.size();
+      --console.match_count;
+    }
+    console.matches[(console.matches_head + console.match_count) % console.matches.size()] = sequence;
+    ++console.match_count;
+  }
+  console.scanned = end;
+}
+
+// copy the matches first to last - 1 out of the ring
+void copy_visible(const logger::Ring_sink &ring, size_t first, size_t last)
+{
+  console.visible_text.clear();
+  console.visible_lines.clear();
+  for (size_t i = first; i < last; ++i)
+  {
+    const uint64_t sequence = console.match(i);
+    if (sequence < ring.first_line())
+    {
+      console.visible_lines.push_back({});    // evicted since the matches were updated
+      continue;
+    }
+    const auto line = ring.line(sequence);
+    console.visible_lines.push_back({console.visible_text.size(), line.text.size(), line.level});
+    console.visible_text.insert(console.visible_text.end(), line.text.begin(), line.text.end());
+  }
+}
+
+}    // namespace
+
+namespace blackboard::app::gui {
+
+void log_console(const char *title, bool *open)
+{
+  if (!ImGui::Begin(title, open))
+  {
+    ImGui::End();
+    return;
+  }
+
+  const auto ring = logger::ring_sink();
+  if (!ring)
+  {
+    ImGui::TextUnformatted("The log has no ring sink");
+    ImGui::End();
+    return;
+  }
+
+  bool filter_changed{false};
+  static constexpr const char *levels[]{"trace", "debug", "info", "warning", "error", "critical"};
+  ImGui::SetNextItemWidth(ImGui::GetFontSize() * 8.f);
+  filter_changed |= ImGui::Combo("##level", &console.min_level, levels, IM_ARRAYSIZE(levels));
+  ImGui::SameLine();
+  ImGui::SetNextItemWidth(-ImGui::GetFontSize() * 12.f);
+  filter_changed |= ImGui::InputTextWithHint("##filter", "filter", console.filter, sizeof(console.filter));
+  ImGui::SameLine();
+  ImGui::Checkbox("Auto-scroll", &console.auto_scroll);
+
+  {
+    const auto lock = ring->lock();
+    if (filter_changed)
+      reset(*ring);
+    update_matches(*ring);
+  }
+
+  ImGui::Separator();
+  ImGui::BeginChild("##lines", ImVec2(0.f, 0.f), false, ImGuiWindowFlags_HorizontalScrollbar);
+  ImGui::PushStyleVar(ImGuiStyleVar_ItemSpacing, ImVec2(0.f, 0.f));
+  ImGuiListClipper clipper;
+  // with the height of the lines known the clipper gives the visible range without measuring a line first
+  clipper.Begin(static_cast<int>(console.match_count), ImGui::GetTextLineHeight());
+  while (clipper.Step())
+  {
+    {
+      const auto lock = ring->lock();
+      copy_visible(*ring, static_cast<size_t>(clipper.DisplayStart), static_cast<size_t>(clipper.DisplayEnd));
+    }
+    for (const auto &line : console.visible_lines)
+    {
+      const char *text = console.visible_text.data() + line.offset;
+      ImGui::PushStyleColor(ImGuiCol_Text, level_color(line.level));
+      ImGui::TextUnformatted(text, text + line.size);
+      ImGui::PopStyleColor();
+    }
+  }
+  clipper.End();
+  ImGui::PopStyleVar();
+  if (console.auto_scroll && ImGui::GetScrollY() >= ImGui::GetScrollMaxY())
+    ImGui::SetScrollHereY(1.f);
+  ImGui::EndChild();
+
+  ImGui::End();
+}
+
+}    // namespace blackboard::app::gui
@@ -0,0 +1,9 @@
+#pragma once
+
+namespace blackboard::app::gui {
+
+/// @brief Window showing the lines kept by logger::ring_sink(), filtered by level and text.
+/// Only the visible lines are drawn and the filter only scans the lines added since the previous frame.
+void log_console(const char *title = "Log", bool *open = nullptr);
+
+}    // namespace blackboard::app::gui
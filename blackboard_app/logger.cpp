@@ -2,6 +2,7 @@
 
 #include <SDL3/SDL.h>
 #include <spdlog/spdlog.h>
+#include <spdlog/details/periodic_worker.h>
 #include <spdlog/sinks/rotating_file_sink.h>
 #include <spdlog/sinks/stdout_sinks.h>
 #include <spdlog/sinks/msvc_sink.h>
@@ -27,7 +28,25 @@ std::filesystem::path path()
   return strdup("/");
 }
 
-void init()
+// flusher thread of the async mode, stopped by shutdown
+static std::shared_ptr<Async_sink> async_sink{nullptr};
+static std::shared_ptr<Ring_sink> ring{nullptr};
+// replaces spdlog::flush_every to also report the summaries of the rate limited call sites
+static std::unique_ptr<spdlog::details::periodic_worker> periodic_flush{nullptr};
+
+static void report_suppressed(bool expired_only)
+{
+  auto *log = raw_logger;
+  if (!log)
+    return;
+  for (auto *limiter = internal::rate_limiters.load(std::memory_order_acquire); limiter; limiter = limiter->next())
+  {
+    if (const uint64_t suppressed = limiter->take_suppressed(expired_only); suppressed > 0u)
+      log->log(limiter->location(), limiter->level(), "suppressed {} messages", suppressed);
+  }
+}
+
+void init(const Config &config)
 {
   static constexpr size_t file_size{5u * 1024u * 1024u};
   static constexpr size_t rotating_files{5u};
@@ -37,22 +56,62 @@ void init()
   console_sink_trace->set_pattern("[multi_sink_example] [%^%l%$] %v");
 
   auto file_sink = std::make_shared<spdlog::sinks::rotating_file_sink_mt>(filename.string().c_str(), file_size , rotating_files, true);
-  spdlog::sinks_init_list sink_list = { file_sink, console_sink_trace };
+  std::vector<spdlog::sink_ptr> sinks{file_sink, console_sink_trace};
+  if (config.ring_bytes > 0u && config.ring_lines > 0u)
+  {
+    ring = std::make_shared<Ring_sink>(config.ring_bytes, config.ring_lines);
+    sinks.push_back(ring);
+  }
 
 #ifdef _WIN32
   auto msvc_sink = std::make_shared<spdlog::sinks::msvc_sink_mt>();
 #endif
 
-  logger = std::make_shared<spdlog::logger>("blackboard_log", sink_list.begin(), sink_list.end());
+  if (config.async)
+  {
+    async_sink = std::make_shared<Async_sink>(std::move(sinks), config.queue_size, config.overflow_policy);
+    sinks = {async_sink};
+  }
+
+  logger = std::make_shared<spdlog::logger>("blackboard_log", sinks.begin(), sinks.end());
   logger::logger->set_level(spdlog::level::trace);
+  raw_logger = logger.get();
   spdlog::set_default_logger(logger);
   using namespace std::chrono_literals;
-  spdlog::flush_every(1s);
+  periodic_flush = std::make_unique<spdlog::details::periodic_worker>(
+    []()
+    {
+      report_suppressed(true);
+      logger->flush();
+    },
+    1s);
+}
+
+uint64_t dropped_count()
+{
+  return async_sink ? async_sink->dropped_count() : 0u;
+}
+
+std::shared_ptr<Ring_sink> ring_sink()
+{
+  return ring;
+}
+
+void flush()
+{
+  report_suppressed(false);
+  if (logger)
+    logger->flush();
 }
 
 void shutdown()
 {
+  periodic_flush.reset();
+  report_suppressed(false);
+  raw_logger = nullptr;
   spdlog::shutdown();
+  if (async_sink)
+    async_sink->stop();
 }
 
 }    // namespace blackboard::app::log
@@ -1,16 +1,247 @@
 #pragma once
+#include "async_sink.h"
+#include "ring_sink.h"
+
 #include <spdlog/spdlog.h>
 
+#include <atomic>
+#include <chrono>
 #include <filesystem>
+#include <limits>
 
 namespace blackboard::app::logger {
 
 inline std::shared_ptr<spdlog::logger> logger{nullptr};
 
+/// @brief Same logger without the shared_ptr indirection, read by the BB_LOG_* macros.
+/// Only written by init and shutdown, which must not race with logging threads.
+inline spdlog::logger *raw_logger{nullptr};
+
 std::filesystem::path path();
 
-void init();
+struct Config
+{
+  /// @brief Write to the file and the console from a background thread
+  bool async{true};
+  /// @brief Messages the async queue can hold, rounded up to a power of two
+  size_t queue_size{8192u};
+  Overflow_policy overflow_policy{Overflow_policy::BLOCK};
+  /// @brief Latest lines kept in memory for the log console, no ring when zero
+  size_t ring_bytes{8u * 1024u * 1024u};
+  size_t ring_lines{256u * 1024u};
+};
+
+void init(const Config &config = {});
+
+/// @brief Messages discarded by the async queue since init
+uint64_t dropped_count();
+
+/// @brief Latest lines of the log, nullptr before init or without a ring
+std::shared_ptr<Ring_sink> ring_sink();
+
+/// @brief Log the pending "suppressed N messages" summaries of the rate limited call sites and flush the logger
+void flush();
 
 void shutdown();
 
+class Rate_limiter;
+
+namespace internal {
+inline std::atomic<Rate_limiter *> rate_limiters{nullptr};    // every limiter, their summaries are reported by flush
+}
+
+/// @brief Allows up to max_messages per period to a log call site, counting the rest
+///
+/// The summary of the suppressed messages is returned with the next allowed one, or logged once the window ended
+/// by the periodic flush of the logger, flush() and shutdown().
+class Rate_limiter
+{
+  public:
+  Rate_limiter(uint32_t max_messages, spdlog::level::level_enum level, spdlog::source_loc location,
+               std::chrono::milliseconds period = std::chrono::seconds{1})
+  : m_max_messages{max_messages}, m_period{period.count()}, m_level{level}, m_location{location}
+  {
+    // limiters are function statics, they outlive the logger
+    m_next = internal::rate_limiters.load(std::memory_order_relaxed);
+    while (!internal::rate_limiters.compare_exchange_weak(m_next, this, std::memory_order_release,
+                                                          std::memory_order_relaxed))
+    {}
+  }
+
+  Rate_limiter(const Rate_limiter &) = delete;
+  Rate_limiter &operator=(const Rate_limiter &) = delete;
+
+  /// @brief suppressed receives the messages dropped since the previous allowed one
+  bool allow(uint64_t &suppressed)
+  {
+    using namespace std::chrono;
+    const int64_t now = duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+    int64_t window_start = m_window_start.load(std::memory_order_relaxed);
+    if (now - window_start >= m_period &&
+        m_window_start.compare_exchange_strong(window_start, now, std::memory_order_relaxed))
+      m_count.store(0u, std::memory_order_relaxed);
+
+    if (m_count.fetch_add(1u, std::memory_order_relaxed) < m_max_messages)
+    {
+      suppressed = m_suppressed.exchange(0u, std::memory_order_relaxed);
+      return true;
+    }
+    m_suppressed.fetch_add(1u, std::memory_order_relaxed);
+    return false;
+  }
+
+  /// @brief Take the messages suppressed in a window that ended, or in any window when expired_only is false
+  uint64_t take_suppressed(bool expired_only)
+  {
+    if (m_suppressed.load(std::memory_order_relaxed) == 0u)
+      return 0u;
+    if (expired_only)
+    {
+      using namespace std::chrono;
+      const int64_t now = duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+      if (now - m_window_start.load(std::memory_order_relaxed) < m_period)
+        return 0u;
+    }
+    return m_suppressed.exchange(0u, std::memory_order_relaxed);
+  }
+
+  spdlog::level::level_enum level() const
+  {
+    return m_level;
+  }
+
+  const spdlog::source_loc &location() const
+  {
+    return m_location;
+  }
+
+  Rate_limiter *next() const
+  {
+    return m_next;
+  }
+
+  private:
+  const uint32_t m_max_messages;
+  const int64_t m_period;
+  const spdlog::level::level_enum m_level;
+  const spdlog::source_loc m_location;
+  Rate_limiter *m_next{nullptr};
+  std::atomic<int64_t> m_window_start{std::numeric_limits<int64_t>::min() / 2};
+  std::atomic<uint32_t> m_count{0u};
+  std::atomic<uint64_t> m_suppressed{0u};
+};
+
+/// @brief Allows one message out of every n to a log call site
+class Sampler
+{
+  public:
+  explicit Sampler(uint32_t n) : m_n{n > 0u ? n : 1u} {}
+
+  bool sample()
+  {
+    return m_count.fetch_add(1u, std::memory_order_relaxed) % m_n == 0u;
+  }
+
+  private:
+  const uint32_t m_n;
+  std::atomic<uint64_t> m_count{0u};
+};
+
 }    // namespace blackboard::app::log
+
+// Logging macros for hot paths: levels below BB_LOG_ACTIVE_LEVEL compile to nothing, levels filtered out by the
+// logger at runtime are skipped before the arguments are evaluated or formatted.
+//
+//   BB_LOG_TRACE("entity {} moved to {}", entity, position);
+
+#define BB_LOG_LEVEL_TRACE 0
+#define BB_LOG_LEVEL_DEBUG 1
+#define BB_LOG_LEVEL_INFO 2
+#define BB_LOG_LEVEL_WARN 3
+#define BB_LOG_LEVEL_ERROR 4
+#define BB_LOG_LEVEL_CRITICAL 5
+#define BB_LOG_LEVEL_OFF 6
+
+#ifndef BB_LOG_ACTIVE_LEVEL
+#ifdef NDEBUG
+#define BB_LOG_ACTIVE_LEVEL BB_LOG_LEVEL_INFO
+#else
+#define BB_LOG_ACTIVE_LEVEL BB_LOG_LEVEL_TRACE
+#endif
+#endif
+
+#define BB_LOG(level, ...)                                                                                          \
+  do                                                                                                                \
+  {                                                                                                                 \
+    if (auto *bb_logger = ::blackboard::app::logger::raw_logger; bb_logger && bb_logger->should_log(level))         \
+      bb_logger->log(spdlog::source_loc{__FILE__, __LINE__, SPDLOG_FUNCTION}, level, __VA_ARGS__);                  \
+  } while (0)
+
+#if BB_LOG_ACTIVE_LEVEL <= BB_LOG_LEVEL_TRACE
+#define BB_LOG_TRACE(...) BB_LOG(spdlog::level::trace, __VA_ARGS__)
+#else
+#define BB_LOG_TRACE(...) (void)0
+#endif
+
+#if BB_LOG_ACTIVE_LEVEL <= BB_LOG_LEVEL_DEBUG
+#define BB_LOG_DEBUG(...) BB_LOG(spdlog::level::debug, __VA_ARGS__)
+#else
+#define BB_LOG_DEBUG(...) (void)0
+#endif
+
+#if BB_LOG_ACTIVE_LEVEL <= BB_LOG_LEVEL_INFO
+#define BB_LOG_INFO(...) BB_LOG(spdlog::level::info, __VA_ARGS__)
+#else
+#define BB_LOG_INFO(...) (void)0
+#endif
+
+#if BB_LOG_ACTIVE_LEVEL <= BB_LOG_LEVEL_WARN
+#define BB_LOG_WARN(...) BB_LOG(spdlog::level::warn, __VA_ARGS__)
+#else
+#define BB_LOG_WARN(...) (void)0
+#endif
+
+#if BB_LOG_ACTIVE_LEVEL <= BB_LOG_LEVEL_ERROR
+#define BB_LOG_ERROR(...) BB_LOG(spdlog::level::err, __VA_ARGS__)
+#else
+#define BB_LOG_ERROR(...) (void)0
+#endif
+
+#if BB_LOG_ACTIVE_LEVEL <= BB_LOG_LEVEL_CRITICAL
+#define BB_LOG_CRITICAL(...) BB_LOG(spdlog::level::critical, __VA_ARGS__)
+#else
+#define BB_LOG_CRITICAL(...) (void)0
+#endif
+
+// Call site limits for messages that can repeat every frame or event, e.g. errors of the platform layer.
+// BB_LOG_LIMITED logs up to max_per_second messages per second and then a "suppressed N messages" line with the
+// next allowed one, or within a second after the window ended, BB_LOG_SAMPLED logs one message out of every n.
+//
+//   BB_LOG_LIMITED(spdlog::level::err, 1, "{}", SDL_GetError());
+
+#define BB_LOG_LIMITED(level, max_per_second, ...)                                                                 \
+  do                                                                                                                \
+  {                                                                                                                 \
+    if (auto *bb_logger = ::blackboard::app::logger::raw_logger; bb_logger && bb_logger->should_log(level))         \
+    {                                                                                                               \
+      static ::blackboard::app::logger::Rate_limiter bb_limiter{                                                    \
+        max_per_second, level, spdlog::source_loc{__FILE__, __LINE__, SPDLOG_FUNCTION}};                            \
+      if (uint64_t bb_suppressed{0u}; bb_limiter.allow(bb_suppressed))                                              \
+      {                                                                                                             \
+        if (bb_suppressed > 0u)                                                                                     \
+          bb_logger->log(bb_limiter.location(), level, "suppressed {} messages", bb_suppressed);                    \
+        bb_logger->log(bb_limiter.location(), level, __VA_ARGS__);                                                  \
+      }                                                                                                             \
+    }                                                                                                               \
+  } while (0)
+
+#define BB_LOG_SAMPLED(level, n, ...)                                                                               \
+  do                                                                                                                \
+  {                                                                                                                 \
+    if (auto *bb_logger = ::blackboard::app::logger::raw_logger; bb_logger && bb_logger->should_log(level))         \
+    {                                                                                                               \
+      static ::blackboard::app::logger::Sampler bb_sampler{n};                                                      \
+      if (bb_sampler.sample())                                                                                      \
+        bb_logger->log(spdlog::source_loc{__FILE__, __LINE__, SPDLOG_FUNCTION}, level, __VA_ARGS__);                \
+    }                                                                                                               \
+  } while (0)
@@ -0,0 +1,105 @@
+#include "mapped_file.h"
+
+#include <bgfx/bgfx.h>
+
+#include <utility>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace blackboard::app {
+
+Mapped_file::Mapped_file(const std::filesystem::path &path)
+{
+#ifdef _WIN32
+  HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    return;
+
+  LARGE_INTEGER file_size;
+  if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0)
+  {
+    if (HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr); mapping)
+    {
+      // the view keeps the mapping object alive
+      if (void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0); view)
+      {
+        m_data = static_cast<const uint8_t *>(view);
+        m_size = static_cast<size_t>(file_size.QuadPart);
+      }
+      CloseHandle(mapping);
+    }
+  }
+  CloseHandle(file);
+#else
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return;
+
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) == 0 && file_stat.st_size > 0)
+  {
+    if (void *view = mmap(nullptr, static_cast<size_t>(file_stat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        view != MAP_FAILED)
+    {
+      m_data = static_cast<const uint8_t *>(view);
+      m_size = static_cast<size_t>(file_stat.st_size);
+    }
+  }
+  // the mapping stays valid after the descriptor is closed
+  ::close(fd);
+#endif
+}
+
+Mapped_file::~Mapped_file()
+{
+  close();
+}
+
+Mapped_file::Mapped_file(Mapped_file &&other) noexcept
+: m_data{std::exchange(other.m_data, nullptr)}, m_size{std::exchange(other.m_size, 0u)}
+{}
+
+Mapped_file &Mapped_file::operator=(Mapped_file &&other) noexcept
+{
+  if (this != &other)
+  {
+    close();
+    m_data = std::exchange(other.m_data, nullptr);
+    m_size = std::exchange(other.m_size, 0u);
+  }
+  return *this;
+}
+
+void Mapped_file::close()
+{
+  if (!m_data)
+    return;
+#ifdef _WIN32
+  UnmapViewOfFile(m_data);
+#else
+  munmap(const_cast<uint8_t *>(m_data), m_size);
+#endif
+  m_data = nullptr;
+  m_size = 0u;
+}
+
+const bgfx::Memory *make_ref(Mapped_file &&file)
+{
+  if (!file.is_open())
+    return nullptr;
+
+  auto *owner = new Mapped_file{std::move(file)};
+  return bgfx::makeRef(
+    owner->data(), static_cast<uint32_t>(owner->size()),
+    [](void *, void *user_data) { delete static_cast<Mapped_file *>(user_data); }, owner);
+}
+
+}    // namespace blackboard::app
@@ -0,0 +1,57 @@
+#pragma once
+#include <stdint.h>
+
+#include <filesystem>
+#include <span>
+
+namespace bgfx {
+struct Memory;
+}
+
+namespace blackboard::app {
+
+/// @brief Read only memory mapping of a whole file, unmapped on destruction
+class Mapped_file
+{
+  public:
+  Mapped_file() = default;
+  explicit Mapped_file(const std::filesystem::path &path);
+  ~Mapped_file();
+
+  Mapped_file(const Mapped_file &) = delete;
+  Mapped_file &operator=(const Mapped_file &) = delete;
+  Mapped_file(Mapped_file &&other) noexcept;
+  Mapped_file &operator=(Mapped_file &&other) noexcept;
+
+  bool is_open() const
+  {
+    return m_data != nullptr;
+  }
+
+  const uint8_t *data() const
+  {
+    return m_data;
+  }
+
+  size_t size() const
+  {
+    return m_size;
+  }
+
+  std::span<const uint8_t> span() const
+  {
+    return {m_data, m_size};
+  }
+
+  void close();
+
+  private:
+  const uint8_t *m_data{nullptr};
+  size_t m_size{0u};
+};
+
+/// @brief Hand the mapped pages to bgfx without copying them, the file is unmapped by bgfx once it is consumed.
+/// Returns nullptr and leaves the file untouched if it is not open.
+const bgfx::Memory *make_ref(Mapped_file &&file);
+
+}    // namespace blackboard::app
@@ -0,0 +1,108 @@
+#pragma once
+#include <stdint.h>
+
+#include <algorithm>
+#include <span>
+#include <string_view>
+
+// Indexed pack file layout, shared by the blackboard_pack tool and the runtime readers.
+//
+// [Header][Entry * entry_count][names blob][data, every entry aligned to data_alignment]
+//
+// Entries are sorted by name hash so a lookup is a binary search over the mapped file.
+
+namespace blackboard::app::pack {
+
+inline constexpr uint32_t magic{0x4b504242u};    // "BBPK"
+inline constexpr uint32_t version{1u};
+inline constexpr uint64_t data_alignment{16u};
+
+// Entry flags
+inline constexpr uint16_t flag_lz4{1u << 0};    // stored as a raw LZ4 block of stored_size bytes
+
+struct Header
+{
+  uint32_t magic{pack::magic};
+  uint32_t version{pack::version};
+  uint32_t entry_count{0u};
+  uint32_t names_offset{0u};
+};
+
+struct Entry
+{
+  uint64_t hash{0u};
+  uint64_t offset{0u};         // from the beginning of the file
+  uint32_t size{0u};           // size of the data once unpacked
+  uint32_t stored_size{0u};    // size of the data inside the pack
+  uint32_t name_offset{0u};    // from the beginning of the names blob
+  uint16_t name_size{0u};
+  uint16_t flags{0u};
+};
+
+static_assert(sizeof(Header) == 16u);
+static_assert(sizeof(Entry) == 32u);
+
+// FNV-1a, stable across platforms and compilers
+constexpr uint64_t hash(std::string_view name)
+{
+  uint64_t h{0xcbf29ce484222325ull};
+  for (const char c : name)
+  {
+    h ^= static_cast<uint8_t>(c);
+    h *= 0x100000001b3ull;
+  }
+  return h;
+}
+
+inline const Header *header(std::span<const uint8_t> file)
+{
+  if (file.size() < sizeof(Header))
+    return nullptr;
+  const auto *h = reinterpret_cast<const Header *>(file.data());
+  if (h->magic != magic || h->version != version)
+    return nullptr;
+  if (sizeof(Header) + static_cast<uint64_t>(h->entry_count) * sizeof(Entry) > file.size() ||
+      h->names_offset > file.size())
+    return nullptr;
+  return h;
+}
+
+inline std::span<const Entry> entries(std::span<const uint8_t> file)
+{
+  if (const auto *h = header(file); h)
+    return {reinterpret_cast<const Entry *>(file.data() + sizeof(Header)), h->entry_count};
+  return {};
+}
+
+inline std::string_view name(std::span<const uint8_t> file, const Entry &entry)
+{
+  const auto *h = header(file);
+  if (!h || static_cast<uint64_t>(h->names_offset) + entry.name_offset + entry.name_size > file.size())
+    return {};
+  return {reinterpret_cast<const char *>(file.data()) + h->names_offset + entry.name_offset, entry.name_size};
+}
+
+/// @brief Find an entry by name, nullptr if it is not in the pack or if its data lies outside the file
+inline const Entry *find(std::span<const uint8_t> file, std::string_view entry_name)
+{
+  const auto all = entries(file);
+  const auto h = hash(entry_name);
+  auto it = std::lower_bound(all.begin(), all.end(), h, [](const Entry &e, uint64_t value) { return e.hash < value; });
+  for (; it != all.end() && it->hash == h; ++it)
+  {
+    if (name(file, *it) == entry_name)
+    {
+      if (it->offset + it->stored_size > file.size())
+        return nullptr;
+      return &*it;
+    }
+  }
+  return nullptr;
+}
+
+inline std::span<const uint8_t> data(std::span<const uint8_t> file, const Entry &entry)
+{
+  return file.subspan(entry.offset, entry.stored_size);
+}
+
+}    // namespace blackboard::app::pack
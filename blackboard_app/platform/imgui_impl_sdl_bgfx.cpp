@@ -2,6 +2,8 @@
 
 #include "fs_ocornut_imgui.bin.h"
 #include "vs_ocornut_imgui.bin.h"
+#include <fs_imgui_alpha.bin.h>    // generated by embed_shaders
+#include <fs_imgui_sdf.bin.h>
 
 #include <SDL3/SDL.h>
 #include <SDL3/SDL_syswm.h>
@@ -11,6 +13,10 @@
 #include <bx/timer.h>
 #include <imgui/imgui.h>
 #include <imgui/imgui_internal.h>
+#include <blackboard_app/glyph_cache.h>
+#include <blackboard_app/gui.h>
+#include <blackboard_app/logger.h>
+#include <blackboard_app/textures.h>
 
 #include <string>
 #include <vector>
@@ -23,7 +29,11 @@ static uint8_t main_view_id{255};
 static bool is_init{false};
 static bgfx::TextureHandle font_texture = BGFX_INVALID_HANDLE;
 static bgfx::ProgramHandle shader_handle = BGFX_INVALID_HANDLE;
+static bgfx::ProgramHandle alpha_shader_handle = BGFX_INVALID_HANDLE;
+static bgfx::ProgramHandle sdf_shader_handle = BGFX_INVALID_HANDLE;
+static bgfx::TextureFormat::Enum font_format{bgfx::TextureFormat::A8};
 static bgfx::UniformHandle uniform_texture = BGFX_INVALID_HANDLE;
+static bgfx::UniformHandle uniform_sdf_rect = BGFX_INVALID_HANDLE;
 static bgfx::VertexLayout vertex_layout;
 static std::vector<bgfx::ViewId> free_view_ids;
 static bgfx::ViewId sub_view_id = 200;
@@ -46,6 +56,8 @@ static void free_view_id(bgfx::ViewId id)
 
 static const bgfx::EmbeddedShader s_embeddedShaders[] = {BGFX_EMBEDDED_SHADER(vs_ocornut_imgui),
                                                          BGFX_EMBEDDED_SHADER(fs_ocornut_imgui),
+                                                         BLACKBOARD_EMBEDDED_SHADER(fs_imgui_alpha),
+                                                         BLACKBOARD_EMBEDDED_SHADER(fs_imgui_sdf),
                                                          BGFX_EMBEDDED_SHADER_END()};
 
 bool checkAvailTransientBuffers(uint32_t _numVertices, const bgfx::VertexLayout &_layout,
@@ -59,7 +71,8 @@ enum class BgfxTextureFlags : uint32_t
 {
   Opaque = 1u << 31,
   PointSampler = 1u << 30,
-  All = Opaque | PointSampler,
+  Alpha = 1u << 29,    // single channel texture, the color comes from the vertices
+  All = Opaque | PointSampler | Alpha,
 };
 
 void *native_window_handle(void *window)
@@ -68,7 +81,7 @@ void *native_window_handle(void *window)
   SDL_SysWMinfo wmi;
   int ok = SDL_GetWindowWMInfo(sdl_window, &wmi, SDL_SYSWM_CURRENT_VERSION);
   if (ok != 0) {
-    const char* err = SDL_GetError();
+    BB_LOG_LIMITED(spdlog::level::err, 1, "{}", SDL_GetError());
     return nullptr;
   }
 #if BX_PLATFORM_LINUX || BX_PLATFORM_BSD
@@ -161,7 +174,8 @@ void ImGui_Impl_sdl_bgfx_Resize(SDL_Window *window)
 
 void ImGui_Impl_sdl_bgfx_Render(const bgfx::ViewId view_id, ImDrawData *draw_data, uint32_t clearColor)
 {
-  if (ImGuiIO &io = ImGui::GetIO(); io.DisplaySize.x <= 0 || io.DisplaySize.y <= 0)
+  const ImGuiIO &io = ImGui::GetIO();
+  if (io.DisplaySize.x <= 0 || io.DisplaySize.y <= 0)
   {
     return;
   }
@@ -194,6 +208,11 @@ void ImGui_Impl_sdl_bgfx_Render(const bgfx::ViewId view_id, ImDrawData *draw_dat
                       static_cast<uint16_t>(clip_size.y * clip_scale.y));
   }
 
+  // the atlas holds SDF glyphs when SDF fonts are loaded, the same atlas then serves every font scale
+  float sdf_rect[4];
+  const bool sdf_atlas = glyph_cache::sdf_page_uvs(sdf_rect);
+  const bgfx::ProgramHandle atlas_program = sdf_atlas ? sdf_shader_handle : alpha_shader_handle;
+
   // draw_data->ScaleClipRects(clipScale);
   // Render command lists
   for (int32_t ii = 0, num = draw_data->CmdListsCount; ii < num; ++ii)
@@ -238,6 +257,12 @@ void ImGui_Impl_sdl_bgfx_Render(const bgfx::ViewId view_id, ImDrawData *draw_dat
         bgfx::TextureHandle texture_handle = font_texture;
         bgfx::ProgramHandle program = shader_handle;
 
+        // glyphs of the dynamic fonts are rasterized on first use, they are only drawn with the font atlas
+        if (cmd->TextureId == io.Fonts->TexID)
+        {
+          glyph_cache::resolve(verts, indices, *cmd);
+        }
+
         auto alphaBlend = true;
         if (cmd->TextureId != nullptr)
         {
@@ -250,8 +275,14 @@ void ImGui_Impl_sdl_bgfx_Render(const bgfx::ViewId view_id, ImDrawData *draw_dat
           {
             sampler_state = BGFX_SAMPLER_POINT;
           }
+          if (textureInfo & (uint32_t)BgfxTextureFlags::Alpha && bgfx::isValid(atlas_program))
+          {
+            program = atlas_program;
+          }
           textureInfo &= ~(uint32_t)BgfxTextureFlags::All;
           texture_handle = {(uint16_t)textureInfo};
+          // residency of the texture cache
+          textures::mark_used(texture_handle);
         }
         if (alphaBlend)
         {
@@ -277,6 +308,10 @@ void ImGui_Impl_sdl_bgfx_Render(const bgfx::ViewId view_id, ImDrawData *draw_dat
 
           encoder->setState(state);
           encoder->setTexture(0, uniform_texture, texture_handle, sampler_state);
+          if (program.idx == sdf_shader_handle.idx)
+          {
+            encoder->setUniform(uniform_sdf_rect, sdf_rect);
+          }
           encoder->setVertexBuffer(0, &tvb, 0, numVertices);
           encoder->setIndexBuffer(&tib, offset, cmd->ElemCount);
           encoder->submit(view_id, program);
@@ -288,14 +323,42 @@ void ImGui_Impl_sdl_bgfx_Render(const bgfx::ViewId view_id, ImDrawData *draw_dat
 
     bgfx::end(encoder);
   }
+
+  glyph_cache::upload(font_texture, font_format);
 }
 
 void ImGui_Implbgfx_CreateDeviceObjects()
 {
   const auto type = bgfx::getRendererType();
-  shader_handle =
-    bgfx::createProgram(bgfx::createEmbeddedShader(s_embeddedShaders, type, "vs_ocornut_imgui"),
-                        bgfx::createEmbeddedShader(s_embeddedShaders, type, "fs_ocornut_imgui"), true);
+  // the vertex shader is shared, programs keep a reference to their shaders
+  const auto vertex_shader = bgfx::createEmbeddedShader(s_embeddedShaders, type, "vs_ocornut_imgui");
+  const auto create_program = [&](const char *fragment_name) {
+    bgfx::ProgramHandle program = BGFX_INVALID_HANDLE;
+    const auto fragment_shader = bgfx::createEmbeddedShader(s_embeddedShaders, type, fragment_name);
+    if (bgfx::isValid(vertex_shader) && bgfx::isValid(fragment_shader))
+      program = bgfx::createProgram(vertex_shader, fragment_shader, false);
+    if (bgfx::isValid(fragment_shader))
+      bgfx::destroy(fragment_shader);
+    return program;
+  };
+  shader_handle = create_program("fs_ocornut_imgui");
+  // the alpha and SDF shaders are only cooked for the BLACKBOARD_SHADER_PROFILES renderers
+  alpha_shader_handle = create_program("fs_imgui_alpha");
+  sdf_shader_handle = create_program("fs_imgui_sdf");
+  if (bgfx::isValid(vertex_shader))
+    bgfx::destroy(vertex_shader);
+  if (!bgfx::isValid(alpha_shader_handle) || !bgfx::isValid(sdf_shader_handle))
+  {
+    BB_LOG_WARN("No alpha font shaders for the {} renderer, the font atlas is uploaded as RGBA8",
+                bgfx::getRendererName(type));
+    for (auto *program : {&alpha_shader_handle, &sdf_shader_handle})
+    {
+      if (bgfx::isValid(*program))
+        bgfx::destroy(*program);
+      program->idx = bgfx::kInvalidHandle;
+    }
+  }
+  font_format = bgfx::isValid(alpha_shader_handle) ? bgfx::TextureFormat::A8 : bgfx::TextureFormat::RGBA8;
 
   vertex_layout.begin()
     .add(bgfx::Attrib::Position, 2, bgfx::AttribType::Float)
@@ -304,19 +367,29 @@ void ImGui_Implbgfx_CreateDeviceObjects()
     .end();
 
   uniform_texture = bgfx::createUniform("s_tex", bgfx::UniformType::Sampler);
+  uniform_sdf_rect = bgfx::createUniform("u_sdfRect", bgfx::UniformType::Vec4);
 
-  // Build texture atlas
+  // Build texture atlas, restored from the font atlas cache when the fonts did not change
   ImGuiIO &io = ImGui::GetIO();
+  gui::build_font_atlas();
   unsigned char *pixels;
   int width, height;
-  io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
-  // Upload texture to graphics system
-  font_texture =
-    bgfx::createTexture2D((uint16_t)width, (uint16_t)height, false, 1, bgfx::TextureFormat::BGRA8, 0,
-                          bgfx::copy(pixels, width * height * 4));
+  int texel_size{1};
+  if (font_format == bgfx::TextureFormat::A8)
+    io.Fonts->GetTexDataAsAlpha8(&pixels, &width, &height);
+  else
+    io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height, &texel_size);
+  // Upload a single channel texture, a quarter of the RGBA32 atlas. The texture is updatable for the glyph cache
+  font_texture = bgfx::createTexture2D((uint16_t)width, (uint16_t)height, false, 1, font_format, 0);
+  if (bgfx::isValid(font_texture))
+  {
+    bgfx::updateTexture2D(font_texture, 0, 0, 0, 0, (uint16_t)width, (uint16_t)height,
+                          bgfx::copy(pixels, width * height * texel_size));
+  }
   is_init = bgfx::isValid(font_texture);
-  // Store our identifier
-  io.Fonts->TexID = (void *)(intptr_t)font_texture.idx;
+  // Store our identifier, the RGBA8 atlas is drawn like any other texture
+  const uint32_t font_flags = font_format == bgfx::TextureFormat::A8 ? (uint32_t)BgfxTextureFlags::Alpha : 0u;
+  io.Fonts->TexID = (void *)(intptr_t)(font_texture.idx | font_flags);
 }
 
 void ImGui_Implbgfx_InvalidateDeviceObjects()
@@ -327,6 +400,24 @@ void ImGui_Implbgfx_InvalidateDeviceObjects()
     shader_handle.idx = bgfx::kInvalidHandle;
   }
 
+  if (bgfx::isValid(alpha_shader_handle))
+  {
+    bgfx::destroy(alpha_shader_handle);
+    alpha_shader_handle.idx = bgfx::kInvalidHandle;
+  }
+
+  if (bgfx::isValid(sdf_shader_handle))
+  {
+    bgfx::destroy(sdf_shader_handle);
+    sdf_shader_handle.idx = bgfx::kInvalidHandle;
+  }
+
+  if (bgfx::isValid(uniform_sdf_rect))
+  {
+    bgfx::destroy(uniform_sdf_rect);
+    uniform_sdf_rect.idx = bgfx::kInvalidHandle;
+  }
+
   if (isValid(font_texture))
   {
     bgfx::destroy(font_texture);
@@ -0,0 +1,14 @@
+$input v_color0, v_texcoord0
+
+// ImGui fragment shader for single channel textures (the alpha8 font atlas): the color comes from the vertices,
+// the texture only provides the coverage
+
+#include <bgfx_shader.sh>
+
+SAMPLER2D(s_tex, 0);
+
+void main()
+{
+	float alpha = texture2D(s_tex, v_texcoord0).a;
+	gl_FragColor = vec4(v_color0.rgb, v_color0.a * alpha);
+}
@@ -0,0 +1,19 @@
+$input v_color0, v_texcoord0
+
+// ImGui fragment shader for the alpha8 font atlas when it holds signed distance field glyphs: texels inside
+// u_sdfRect are distances (0.5 on the glyph edge) smoothed over one screen pixel, the other texels are coverage
+
+#include <bgfx_shader.sh>
+
+SAMPLER2D(s_tex, 0);
+uniform vec4 u_sdfRect;    // uv bounds of the SDF page: min x, min y, max x, max y
+
+void main()
+{
+	float texel = texture2D(s_tex, v_texcoord0).a;
+	float width = max(fwidth(texel) * 0.5, 0.001);
+	float distance_alpha = smoothstep(0.5 - width, 0.5 + width, texel);
+	vec2 inside = step(u_sdfRect.xy, v_texcoord0) * step(v_texcoord0, u_sdfRect.zw);
+	float alpha = mix(texel, distance_alpha, inside.x * inside.y);
+	gl_FragColor = vec4(v_color0.rgb, v_color0.a * alpha);
+}
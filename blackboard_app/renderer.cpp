@@ -21,7 +21,7 @@ bool init(Window &window, Api &renderer_api, const uint16_t width, const uint16_
       SDL_SysWMinfo wmi;
       if (SDL_GetWindowWMInfo(window.window, &wmi, SDL_SYSWM_CURRENT_VERSION) != 0)
       {
-          logger::logger->error(SDL_GetError());
+          BB_LOG_LIMITED(spdlog::level::err, 1, "{}", SDL_GetError());
           return false;
       }
   bgfx::Init bgfx_init;
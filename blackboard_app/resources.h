@@ -5,19 +5,22 @@
 
 namespace blackboard::app::resources {
 
+/// @brief Folder of the application resources, queried once
 inline std::filesystem::path path()
 {
+  static const std::filesystem::path resources_path = [] {
+    std::filesystem::path result{"/"};
+    if (char *base_path = SDL_GetBasePath(); base_path)
+    {
 #ifdef __APPLE__
-  if (char *base_path = SDL_GetBasePath(); base_path)
-  {
-    return {base_path};
-  }
+      result = base_path;
 #else
-  if (char *base_path = SDL_GetBasePath(); base_path)
-  {
-    return std::filesystem::path(base_path) / "Resources";
-  }
+      result = std::filesystem::path(base_path) / "Resources";
 #endif
-  return strdup("/");
+      SDL_free(base_path);
+    }
+    return result;
+  }();
+  return resources_path;
 }
 }    // namespace blackboard::app::resources
@@ -0,0 +1,46 @@
+#include "ring_sink.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace blackboard::app::logger {
+
+Ring_sink::Ring_sink(size_t byte_capacity, size_t line_capacity)
+: m_bytes{std::make_unique<char[]>(byte_capacity)}, m_byte_capacity{byte_capacity}
+, m_lines{std::make_unique<Entry[]>(line_capacity)}, m_line_capacity{line_capacity}
+{
+  set_pattern_("[%H:%M:%S.%e] [%l] %v");
+}
+
+Ring_sink::Line Ring_sink::line(uint64_t sequence) const
+{
+  const Entry &entry = m_lines[sequence % m_line_capacity];
+  return {.text = {m_bytes.get() + entry.offset % m_byte_capacity, entry.size}, .level = entry.level};
+}
+
+void Ring_sink::sink_it_(const spdlog::details::log_msg &message)
+{
+  m_formatted.clear();
+  formatter_->format(message, m_formatted);
+  size_t size = m_formatted.size();
+  while (size > 0u && (m_formatted[size - 1u] == '\n' || m_formatted[size - 1u] == '\r'))
+    --size;
+  size = std::min(size, m_byte_capacity);
+
+  // lines never wrap around the end of the bytes
+  if (const size_t at = m_write_position % m_byte_capacity; at + size > m_byte_capacity)
+    m_write_position += m_byte_capacity - at;
+
+  Entry &entry = m_lines[m_end_line % m_line_capacity];
+  entry = {.offset = m_write_position, .size = static_cast<uint32_t>(size), .level = message.level};
+  std::memcpy(m_bytes.get() + m_write_position % m_byte_capacity, m_formatted.data(), size);
+  m_write_position += size;
+  ++m_end_line;
+
+  // evict the lines whose index slot or bytes have been reused
+  m_first_line = std::max(m_first_line, m_end_line > m_line_capacity ? m_end_line - m_line_capacity : 0u);
+  while (m_first_line < m_end_line && m_lines[m_first_line % m_line_capacity].offset + m_byte_capacity < m_write_position)
+    ++m_first_line;
+}
+
+}    // namespace blackboard::app::logger
@@ -0,0 +1,74 @@
+#pragma once
+#include <spdlog/sinks/base_sink.h>
+
+#include <memory>
+#include <mutex>
+#include <string_view>
+
+namespace blackboard::app::logger {
+
+/// @brief Sink keeping the latest formatted lines in a fixed byte ring, memory does not grow with the log.
+///
+/// Lines are identified by a sequence number increasing for the whole run, the oldest lines are evicted
+/// when the bytes or the line index are full. Readers hold lock() while accessing the lines.
+class Ring_sink final : public spdlog::sinks::base_sink<std::mutex>
+{
+  public:
+  struct Line
+  {
+    std::string_view text;
+    spdlog::level::level_enum level{spdlog::level::off};
+  };
+
+  Ring_sink(size_t byte_capacity, size_t line_capacity);
+
+  std::unique_lock<std::mutex> lock()
+  {
+    return std::unique_lock{mutex_};
+  }
+
+  /// @brief Sequence number of the oldest line still in the ring
+  uint64_t first_line() const
+  {
+    return m_first_line;
+  }
+
+  /// @brief Sequence number of the next line
+  uint64_t end_line() const
+  {
+    return m_end_line;
+  }
+
+  /// @brief A line between first_line and end_line, valid until the lock is released
+  Line line(uint64_t sequence) const;
+
+  size_t line_capacity() const
+  {
+    return m_line_capacity;
+  }
+
+  protected:
+  void sink_it_(const spdlog::details::log_msg &message) override;
+  void flush_() override {}
+
+  private:
+  struct Entry
+  {
+    uint64_t offset{0u};    // byte position since the first line
+    uint32_t size{0u};
+    spdlog::level::level_enum level{spdlog::level::off};
+  };
+
+  std::unique_ptr<char[]> m_bytes;
+  size_t m_byte_capacity{0u};
+  uint64_t m_write_position{0u};
+
+  std::unique_ptr<Entry[]> m_lines;
+  size_t m_line_capacity{0u};
+  uint64_t m_first_line{0u};
+  uint64_t m_end_line{0u};
+
+  spdlog::memory_buf_t m_formatted;
+};
+
+}    // namespace blackboard::app::logger
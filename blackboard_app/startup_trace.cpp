@@ -0,0 +1,107 @@
+#include "startup_trace.h"
+
+#include "logger.h"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+struct Event
+{
+  const char *name;
+  int64_t begin_us;
+  int64_t duration_us;
+  uint32_t thread;
+};
+
+const auto epoch{std::chrono::steady_clock::now()};
+std::atomic<bool> recording{true};
+std::atomic<uint32_t> thread_count{0u};
+std::mutex events_mutex;
+std::vector<Event> events;
+
+uint32_t thread_index()
+{
+  thread_local const uint32_t index{thread_count.fetch_add(1u, std::memory_order_relaxed)};
+  return index;
+}
+
+// names are literals or identifiers, only quotes and backslashes need escaping
+void write_json_string(std::ofstream &out, const char *text)
+{
+  out << '"';
+  for (; *text; ++text)
+  {
+    if (*text == '"' || *text == '\\')
+      out << '\\';
+    out << *text;
+  }
+  out << '"';
+}
+
+}    // namespace
+
+namespace blackboard::app::startup_trace {
+
+int64_t now_us()
+{
+  using namespace std::chrono;
+  return duration_cast<microseconds>(steady_clock::now() - epoch).count();
+}
+
+Scope::Scope(const char *name) : m_name{name}
+{
+  if (recording.load(std::memory_order_relaxed))
+    m_begin_us = now_us();
+}
+
+Scope::~Scope()
+{
+  if (m_begin_us < 0 || !recording.load(std::memory_order_relaxed))
+    return;
+  const Event event{.name = m_name, .begin_us = m_begin_us, .duration_us = now_us() - m_begin_us, .thread = thread_index()};
+  std::lock_guard lock{events_mutex};
+  events.push_back(event);
+}
+
+void finish(const std::filesystem::path &trace_path)
+{
+  if (!recording.exchange(false))
+    return;
+
+  std::vector<Event> recorded;
+  {
+    std::lock_guard lock{events_mutex};
+    recorded.swap(events);
+  }
+
+  std::error_code error;
+  std::filesystem::create_directories(trace_path.parent_path(), error);
+  std::ofstream out(trace_path, std::ios::trunc);
+  if (!out.is_open())
+  {
+    BB_LOG_WARN("Can not write the startup trace {}", trace_path.string());
+    return;
+  }
+
+  // complete events ("ph":"X") of a single process, one track per thread
+  out << "{\"traceEvents\":[\n";
+  for (size_t i = 0; i < recorded.size(); ++i)
+  {
+    const auto &event = recorded[i];
+    out << "{\"name\":";
+    write_json_string(out, event.name);
+    out << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.thread << ",\"ts\":" << event.begin_us
+        << ",\"dur\":" << event.duration_us << "}" << (i + 1 < recorded.size() ? ",\n" : "\n");
+  }
+  out << "],\"displayTimeUnit\":\"ms\"}\n";
+
+  BB_LOG_INFO("First frame after {:.1f} ms, startup trace written to {}", static_cast<double>(now_us()) / 1000.0,
+              trace_path.string());
+}
+
+}    // namespace blackboard::app::startup_trace
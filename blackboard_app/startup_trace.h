@@ -0,0 +1,36 @@
+#pragma once
+#include <stdint.h>
+
+#include <filesystem>
+
+// Timeline of the application startup, written as a Chrome trace (chrome://tracing, Perfetto) once the first
+// frame is presented. Scopes can be opened from any thread, they cost an atomic load after finish.
+
+namespace blackboard::app::startup_trace {
+
+class Scope
+{
+  public:
+  explicit Scope(const char *name);
+  ~Scope();
+
+  Scope(const Scope &) = delete;
+  Scope &operator=(const Scope &) = delete;
+
+  private:
+  const char *m_name;
+  int64_t m_begin_us{-1};
+};
+
+/// @brief Stop recording and write the trace, called by App after the first frame
+void finish(const std::filesystem::path &trace_path);
+
+/// @brief Microseconds since the process started recording
+int64_t now_us();
+
+}    // namespace blackboard::app::startup_trace
+
+#define BB_STARTUP_CONCAT_IMPL(a, b) a##b
+#define BB_STARTUP_CONCAT(a, b) BB_STARTUP_CONCAT_IMPL(a, b)
+#define BB_STARTUP_SCOPE(name) \
+  const blackboard::app::startup_trace::Scope BB_STARTUP_CONCAT(bb_startup_scope_, __LINE__)(name)
@@ -0,0 +1,3 @@
+// stb_truetype for the glyph cache, ImGui compiles its own static copy inside imgui_draw.cpp
+#define STB_TRUETYPE_IMPLEMENTATION
+#include <imgui/imstb_truetype.h>
@@ -0,0 +1,41 @@
+#include "texture_stats.h"
+
+#include "textures.h"
+
+#include <imgui/imgui.h>
+
+#include <cstdio>
+
+namespace blackboard::app::gui {
+
+void texture_stats(const char *title, bool *open)
+{
+  if (!ImGui::Begin(title, open))
+  {
+    ImGui::End();
+    return;
+  }
+
+  const auto stats = textures::stats();
+  constexpr float mebibyte{1024.f * 1024.f};
+  const float used = static_cast<float>(stats.resident_bytes) / mebibyte;
+  const float budget = static_cast<float>(stats.budget_bytes) / mebibyte;
+  char overlay[64];
+  std::snprintf(overlay, sizeof(overlay), "%.1f / %.0f MiB", used, budget);
+  ImGui::ProgressBar(budget > 0.f ? used / budget : 0.f, ImVec2(-1.f, 0.f), overlay);
+
+  int budget_mib = static_cast<int>(stats.budget_bytes >> 20u);
+  if (ImGui::DragInt("Budget (MiB)", &budget_mib, 1.f, 1, 16384))
+    textures::set_budget(static_cast<size_t>(budget_mib) << 20u);
+
+  const uint64_t lookups = stats.hits + stats.misses;
+  ImGui::Text("Textures: %u, resident: %u", stats.textures, stats.resident);
+  ImGui::Text("Hits: %llu, misses: %llu (%.1f%% hit rate)", static_cast<unsigned long long>(stats.hits),
+              static_cast<unsigned long long>(stats.misses),
+              lookups > 0u ? 100.0 * static_cast<double>(stats.hits) / static_cast<double>(lookups) : 0.0);
+  ImGui::Text("Evictions: %llu", static_cast<unsigned long long>(stats.evictions));
+
+  ImGui::End();
+}
+
+}    // namespace blackboard::app::gui
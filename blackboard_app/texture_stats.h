@@ -0,0 +1,9 @@
+#pragma once
+
+namespace blackboard::app::gui {
+
+/// @brief Window showing the residency of the texture cache: memory used against the budget, hits, misses and
+/// evictions. The budget can be changed from the window.
+void texture_stats(const char *title = "Textures", bool *open = nullptr);
+
+}    // namespace blackboard::app::gui
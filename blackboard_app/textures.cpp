@@ -0,0 +1,355 @@
+#include "textures.h"
+
+#include "gui.h"
+#include "logger.h"
+
+#include <bimg/decode.h>
+#include <bx/allocator.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace blackboard::app::textures {
+
+struct Image
+{
+  uint16_t width{0u};
+  uint16_t height{0u};
+  uint8_t mips{1u};
+  std::vector<uint8_t> pixels;    // RGBA8 mip chain, handed over to bgfx by the upload
+};
+
+static bx::DefaultAllocator allocator;
+static bgfx::TextureHandle placeholder = BGFX_INVALID_HANDLE;
+static bool renderer_alive{true};
+static std::unordered_map<std::string, std::weak_ptr<Resident>> residents;    // by name
+static std::vector<Resident *> by_handle;                                      // uploaded textures by handle index
+static size_t budget{256u << 20u};
+static constexpr int pending_frames{120};    // decoded images not drawn for that long are dropped
+static size_t resident_bytes{0u};
+static Stats counters;
+
+// main thread only, lives as long as a Texture references it whatever the eviction state
+struct Resident
+{
+  std::string name;
+  Priority priority{Priority::NORMAL};
+  assets::Asset<Image> pending;
+  bgfx::TextureHandle handle = BGFX_INVALID_HANDLE;
+  uint16_t width{0u};
+  uint16_t height{0u};
+  size_t bytes{0u};
+  int last_used{-1};
+  int ready_frame{-1};    // first update() that saw the decoded image waiting for its upload
+  bool failed{false};
+
+  ~Resident()
+  {
+    release();
+  }
+
+  void release()
+  {
+    if (!bgfx::isValid(handle))
+      return;
+    if (renderer_alive)
+      bgfx::destroy(handle);
+    by_handle[handle.idx] = nullptr;
+    resident_bytes -= bytes;
+    handle.idx = bgfx::kInvalidHandle;
+  }
+};
+
+// 2x2 box filter, the last row and column are repeated for odd sizes
+static void downsample(const uint8_t *source, uint32_t width, uint32_t height, uint8_t *destination)
+{
+  const uint32_t destination_width = std::max(width / 2u, 1u);
+  const uint32_t destination_height = std::max(height / 2u, 1u);
+  for (uint32_t y = 0; y < destination_height; ++y)
+  {
+    const uint8_t *row0 = source + std::min(y * 2u, height - 1u) * width * 4u;
+    const uint8_t *row1 = source + std::min(y * 2u + 1u, height - 1u) * width * 4u;
+    for (uint32_t x = 0; x < destination_width; ++x)
+    {
+      const uint32_t x0 = std::min(x * 2u, width - 1u) * 4u;
+      const uint32_t x1 = std::min(x * 2u + 1u, width - 1u) * 4u;
+      for (uint32_t channel = 0; channel < 4u; ++channel)
+      {
+        const uint32_t sum = row0[x0 + channel] + row0[x1 + channel] + row1[x0 + channel] + row1[x1 + channel];
+        *destination++ = static_cast<uint8_t>((sum + 2u) / 4u);
+      }
+    }
+  }
+}
+
+static std::optional<Image> decode(const vfs::File &file)
+{
+  bimg::ImageContainer *container = bimg::imageParse(&allocator, file.data(), static_cast<uint32_t>(file.size()),
+                                                     bimg::TextureFormat::RGBA8);
+  if (!container)
+    return std::nullopt;
+
+  std::optional<Image> result;
+  if (container->m_cubeMap || container->m_depth > 1u || container->m_width > 0xffffu ||
+      container->m_height > 0xffffu)
+  {
+    BB_LOG_ERROR("Only 2D images are supported as textures");
+  }
+  else
+  {
+    Image image;
+    image.width = static_cast<uint16_t>(container->m_width);
+    image.height = static_cast<uint16_t>(container->m_height);
+    image.mips = static_cast<uint8_t>(std::bit_width(std::max(container->m_width, container->m_height)));
+
+    // the top level comes first in the decoded data, the mips are generated again from it
+    size_t size{0u};
+    for (uint32_t mip = 0, width = container->m_width, height = container->m_height; mip < image.mips; ++mip)
+    {
+      size += static_cast<size_t>(width) * height * 4u;
+      width = std::max(width / 2u, 1u);
+      height = std::max(height / 2u, 1u);
+    }
+    image.pixels.resize(size);
+    std::memcpy(image.pixels.data(), container->m_data,
+                static_cast<size_t>(container->m_width) * container->m_height * 4u);
+
+    uint8_t *level = image.pixels.data();
+    for (uint32_t mip = 1, width = container->m_width, height = container->m_height; mip < image.mips; ++mip)
+    {
+      uint8_t *next = level + static_cast<size_t>(width) * height * 4u;
+      downsample(level, width, height, next);
+      level = next;
+      width = std::max(width / 2u, 1u);
+      height = std::max(height / 2u, 1u);
+    }
+    result = std::move(image);
+  }
+  bimg::imageFree(container);
+  return result;
+}
+
+static void upload(Resident &resident, Image &image)
+{
+  // bgfx reads the pixels in place and releases them once the texture is created
+  resident.bytes = image.pixels.size();
+  auto *pixels = new std::vector<uint8_t>(std::move(image.pixels));
+  const bgfx::Memory *memory = bgfx::makeRef(
+    pixels->data(), static_cast<uint32_t>(pixels->size()),
+    [](void *, void *user_data) { delete static_cast<std::vector<uint8_t> *>(user_data); }, pixels);
+  resident.handle = bgfx::createTexture2D(image.width, image.height, image.mips > 1u, 1, bgfx::TextureFormat::RGBA8,
+                                          BGFX_TEXTURE_NONE, memory);
+  if (!bgfx::isValid(resident.handle))
+  {
+    BB_LOG_ERROR("Error creating texture {}", resident.name);
+    resident.failed = true;
+    return;
+  }
+
+  resident.width = image.width;
+  resident.height = image.height;
+  if (by_handle.size() <= resident.handle.idx)
+    by_handle.resize(resident.handle.idx + 1u, nullptr);
+  by_handle[resident.handle.idx] = &resident;
+  resident_bytes += resident.bytes;
+}
+
+static bgfx::TextureHandle placeholder_handle()
+{
+  if (!bgfx::isValid(placeholder) && renderer_alive)
+  {
+    // grey checkerboard
+    static const uint8_t pixels[]{96, 96, 96, 255, 160, 160, 160, 255, 160, 160, 160, 255, 96, 96, 96, 255};
+    placeholder = bgfx::createTexture2D(2, 2, false, 1, bgfx::TextureFormat::RGBA8, BGFX_SAMPLER_POINT,
+                                        bgfx::makeRef(pixels, sizeof(pixels)));
+  }
+  return placeholder;
+}
+
+// record that resident is drawn by the current frame, an uploaded texture counts one hit per frame it is drawn in
+static void touch(Resident &resident)
+{
+  if (!ImGui::GetCurrentContext() || resident.last_used == ImGui::GetFrameCount())
+    return;
+  resident.last_used = ImGui::GetFrameCount();
+  if (bgfx::isValid(resident.handle))
+    ++counters.hits;
+}
+
+bgfx::TextureHandle Texture::handle() const
+{
+  if (!m_resident)
+    return placeholder_handle();
+
+  auto &resident = *m_resident;
+  // asking for the handle counts as drawing it, textures bound with bgfx directly never reach mark_used
+  touch(resident);
+  if (bgfx::isValid(resident.handle))
+    return resident.handle;
+  if (resident.failed || !renderer_alive)
+    return placeholder_handle();
+
+  switch (resident.pending.state())
+  {
+    case assets::State::NONE:
+      // first draw, or drawn again after an eviction
+      ++counters.misses;
+      resident.pending = assets::load<Image>(resident.name, resident.priority, decode);
+      break;
+    case assets::State::READY:
+      if (auto *image = resident.pending.get(); image && !image->pixels.empty())
+        upload(resident, *image);
+      resident.pending.cancel();
+      resident.ready_frame = -1;
+      break;
+    case assets::State::FAILED:
+      resident.failed = true;
+      resident.pending.cancel();
+      break;
+    case assets::State::LOADING:
+      break;
+  }
+  return bgfx::isValid(resident.handle) ? resident.handle : placeholder_handle();
+}
+
+ImTextureID Texture::id() const
+{
+  return gui::toId(handle(), 0, 0);
+}
+
+assets::State Texture::state() const
+{
+  if (!m_resident)
+    return assets::State::NONE;
+  if (bgfx::isValid(m_resident->handle))
+    return assets::State::READY;
+  if (m_resident->failed)
+    return assets::State::FAILED;
+  return m_resident->pending.state() == assets::State::NONE ? assets::State::NONE : assets::State::LOADING;
+}
+
+uint16_t Texture::width() const
+{
+  return m_resident ? m_resident->width : 0u;
+}
+
+uint16_t Texture::height() const
+{
+  return m_resident ? m_resident->height : 0u;
+}
+
+Texture load(std::string_view name, Priority priority)
+{
+  std::string key{name};
+  if (const auto it = residents.find(key); it != residents.end())
+  {
+    if (auto existing = it->second.lock(); existing)
+    {
+      existing->priority = std::min(existing->priority, priority);
+      return Texture{std::move(existing)};
+    }
+  }
+
+  auto resident = std::make_shared<Resident>();
+  resident->name = key;
+  resident->priority = priority;
+  // the decode starts right away, the upload waits for the first draw
+  ++counters.misses;
+  resident->pending = assets::load<Image>(resident->name, priority, decode);
+  residents.insert_or_assign(std::move(key), resident);
+  return Texture{std::move(resident)};
+}
+
+void mark_used(bgfx::TextureHandle handle)
+{
+  if (handle.idx < by_handle.size() && by_handle[handle.idx])
+    touch(*by_handle[handle.idx]);
+}
+
+// decoded images are uploaded as soon as they are drawn, the ones left waiting hold RAM outside of the budget
+static void expire_pending(int frame)
+{
+  for (const auto &[name, weak_resident] : residents)
+  {
+    const auto resident = weak_resident.lock();
+    if (!resident || resident->pending.state() != assets::State::READY)
+      continue;
+    if (resident->ready_frame < 0)
+    {
+      resident->ready_frame = frame;
+    }
+    else if (frame - resident->ready_frame > pending_frames)
+    {
+      // decoded again by the next draw
+      BB_LOG_TRACE("Decoded texture {} dropped, not drawn since frame {}", resident->name, resident->ready_frame);
+      resident->pending.cancel();
+      resident->ready_frame = -1;
+    }
+  }
+}
+
+void update()
+{
+  std::erase_if(residents, [](const auto &entry) { return entry.second.expired(); });
+  const int frame = ImGui::GetFrameCount();
+  expire_pending(frame);
+  if (resident_bytes <= budget)
+    return;
+
+  // the textures drawn by the current frame are kept, even over budget
+  std::vector<Resident *> candidates;
+  for (auto *resident : by_handle)
+  {
+    if (resident && resident->last_used < frame)
+      candidates.push_back(resident);
+  }
+  std::sort(candidates.begin(), candidates.end(),
+            [](const Resident *a, const Resident *b) { return a->last_used < b->last_used; });
+  for (auto *resident : candidates)
+  {
+    if (resident_bytes <= budget)
+      break;
+    BB_LOG_TRACE("Texture {} evicted, last drawn by frame {}", resident->name, resident->last_used);
+    resident->release();
+    ++counters.evictions;
+  }
+}
+
+void set_budget(size_t bytes)
+{
+  budget = bytes;
+}
+
+Stats stats()
+{
+  Stats result{counters};
+  result.textures = static_cast<uint32_t>(
+    std::count_if(residents.begin(), residents.end(), [](const auto &entry) { return !entry.second.expired(); }));
+  result.resident = static_cast<uint32_t>(
+    std::count_if(by_handle.begin(), by_handle.end(), [](const Resident *resident) { return resident != nullptr; }));
+  result.resident_bytes = resident_bytes;
+  result.budget_bytes = budget;
+  return result;
+}
+
+void shutdown()
+{
+  for (auto *resident : by_handle)
+  {
+    if (resident)
+      resident->release();
+  }
+  if (bgfx::isValid(placeholder))
+  {
+    bgfx::destroy(placeholder);
+    placeholder.idx = bgfx::kInvalidHandle;
+  }
+  renderer_alive = false;
+}
+
+}    // namespace blackboard::app::textures
@@ -0,0 +1,79 @@
+#pragma once
+#include "assets.h"
+
+#include <bgfx/bgfx.h>
+#include <imgui/imgui.h>
+
+#include <memory>
+#include <string_view>
+
+// Textures loaded through the vfs: images (png, jpg, tga, dds, ktx...) are decoded to RGBA8 and their mips generated
+// on the worker threads, then uploaded without copying the pixels the first time they are drawn. Until the upload
+// lands, and when the image can not be loaded, a texture draws as a placeholder.
+//
+//   const auto thumbnail = textures::load("assets/images/thumbnail.png");
+//   ImGui::Image(thumbnail.id(), {64.0f, 64.0f});
+//
+// Uploaded textures count against a byte budget: when it is exceeded, the textures that were not drawn for the longest
+// time are destroyed. A texture counts as drawn in the frames that call handle() or id(). An evicted texture is loaded
+// again the next time it is drawn. Decoded images that are not drawn within 120 frames are dropped before their
+// upload.
+
+namespace blackboard::app::textures {
+
+struct Resident;
+
+class Texture
+{
+  public:
+  Texture() = default;
+  explicit Texture(std::shared_ptr<Resident> resident) : m_resident{std::move(resident)} {}
+
+  /// @brief The uploaded texture, or the placeholder. Reloads the texture if it was evicted.
+  bgfx::TextureHandle handle() const;
+
+  /// @brief ImGui texture id of handle(), see gui::toId
+  ImTextureID id() const;
+
+  /// @brief NONE when the texture is evicted
+  assets::State state() const;
+
+  /// @brief Size in pixels, 0 until the texture is uploaded
+  uint16_t width() const;
+  uint16_t height() const;
+
+  private:
+  std::shared_ptr<Resident> m_resident;
+};
+
+/// @brief Decode name on the workers and upload it on the main thread, textures are destroyed with their last Texture
+Texture load(std::string_view name, Priority priority = Priority::NORMAL);
+
+/// @brief Record that a draw command of the current frame samples handle, called by the ImGui backend for the
+/// ImGui ids made from a handle kept across frames
+void mark_used(bgfx::TextureHandle handle);
+
+/// @brief Evict the least recently drawn textures while the budget is exceeded, called by App after each frame
+void update();
+
+/// @brief Bytes of GPU memory the uploaded textures may use, 256 MiB by default
+void set_budget(size_t bytes);
+
+struct Stats
+{
+  uint64_t hits{0u};         // frames an uploaded texture was drawn in
+  uint64_t misses{0u};       // loads, the first one and the reloads after an eviction
+  uint64_t evictions{0u};
+  uint32_t textures{0u};     // alive Texture entries
+  uint32_t resident{0u};     // uploaded textures
+  size_t resident_bytes{0u};
+  size_t budget_bytes{0u};
+};
+
+Stats stats();
+
+/// @brief Destroy the textures and the placeholder, called by App before bgfx shuts down.
+/// Textures released later are not destroyed.
+void shutdown();
+
+}    // namespace blackboard::app::textures
@@ -0,0 +1,99 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+
+namespace blackboard::app {
+
+Thread_pool::Thread_pool(size_t thread_count)
+{
+  m_threads.reserve(thread_count);
+  for (size_t i = 0u; i < thread_count; ++i)
+    m_threads.emplace_back([this]() { work(); });
+}
+
+Thread_pool::~Thread_pool()
+{
+  {
+    std::lock_guard lock{m_mutex};
+    m_stopping = true;
+  }
+  m_condition.notify_all();
+  for (auto &thread : m_threads)
+    thread.join();
+}
+
+void Thread_pool::submit(Priority priority, std::function<void()> job)
+{
+  {
+    std::lock_guard lock{m_mutex};
+    m_queues[static_cast<size_t>(priority)].push_back(std::move(job));
+  }
+  m_condition.notify_one();
+}
+
+size_t Thread_pool::default_thread_count()
+{
+  return std::max(std::thread::hardware_concurrency(), 2u) - 1u;
+}
+
+void Thread_pool::work()
+{
+  while (true)
+  {
+    std::function<void()> job;
+    {
+      std::unique_lock lock{m_mutex};
+      const auto queue = [this]() {
+        return std::find_if(m_queues.begin(), m_queues.end(), [](const auto &q) { return !q.empty(); });
+      };
+      m_condition.wait(lock, [&]() { return m_stopping || queue() != m_queues.end(); });
+      if (m_stopping)
+        return;
+      auto &jobs = *queue();
+      job = std::move(jobs.front());
+      jobs.pop_front();
+    }
+    job();
+  }
+}
+
+void parallel_for(size_t count, const std::function<void(size_t)> &job, Priority priority)
+{
+  if (!thread_pool || count < 2u)
+  {
+    for (size_t index = 0u; index < count; ++index)
+      job(index);
+    return;
+  }
+
+  // helpers starting after the last index was claimed return without touching the job
+  struct State
+  {
+    const std::function<void(size_t)> *job;
+    size_t count;
+    std::atomic<size_t> next{0u};
+    std::atomic<size_t> done{0u};
+  };
+  auto state = std::make_shared<State>();
+  state->job = &job;
+  state->count = count;
+  const auto run = [state]() {
+    for (size_t index = state->next.fetch_add(1u); index < state->count; index = state->next.fetch_add(1u))
+    {
+      (*state->job)(index);
+      if (state->done.fetch_add(1u, std::memory_order_acq_rel) + 1u == state->count)
+        state->done.notify_all();
+    }
+  };
+
+  const size_t helpers = std::min(count - 1u, thread_pool->thread_count());
+  for (size_t i = 0u; i < helpers; ++i)
+    thread_pool->submit(priority, run);
+  run();
+  for (size_t done = state->done.load(std::memory_order_acquire); done < count;
+       done = state->done.load(std::memory_order_acquire))
+    state->done.wait(done);
+}
+
+}    // namespace blackboard::app
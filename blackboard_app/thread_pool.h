@@ -0,0 +1,61 @@
+#pragma once
+#include <stdint.h>
+
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace blackboard::app {
+
+enum class Priority : uint8_t
+{
+  HIGH = 0,
+  NORMAL,
+  LOW,
+  COUNT
+};
+
+/// @brief Fixed set of worker threads, jobs of a higher priority class always run first.
+/// Jobs still queued when the pool is destroyed are dropped.
+class Thread_pool
+{
+  public:
+  explicit Thread_pool(size_t thread_count = default_thread_count());
+  ~Thread_pool();
+
+  Thread_pool(const Thread_pool &) = delete;
+  Thread_pool &operator=(const Thread_pool &) = delete;
+
+  void submit(Priority priority, std::function<void()> job);
+
+  size_t thread_count() const
+  {
+    return m_threads.size();
+  }
+
+  /// @brief One thread per core, leaving one to the main thread
+  static size_t default_thread_count();
+
+  private:
+  void work();
+
+  std::mutex m_mutex;
+  std::condition_variable m_condition;
+  std::array<std::deque<std::function<void()>>, static_cast<size_t>(Priority::COUNT)> m_queues;
+  std::vector<std::thread> m_threads;
+  bool m_stopping{false};
+};
+
+/// @brief Workers shared by the app subsystems, alive between the App constructor and destructor
+inline std::unique_ptr<Thread_pool> thread_pool{nullptr};
+
+/// @brief Run job(index) for every index in [0, count) on the workers and the calling thread, returns once every
+/// index ran. Runs on the calling thread only without thread_pool.
+void parallel_for(size_t count, const std::function<void(size_t)> &job, Priority priority = Priority::HIGH);
+
+}    // namespace blackboard::app
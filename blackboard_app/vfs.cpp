@@ -0,0 +1,164 @@
+#include "vfs.h"
+
+#include "logger.h"
+#include "mapped_file.h"
+#include "pack.h"
+
+#include <bgfx/bgfx.h>
+#include <lz4.h>
+
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace blackboard::app;
+
+struct Mount
+{
+  std::filesystem::path root;                    // directory mounts
+  std::shared_ptr<const Mapped_file> archive;    // archive mounts
+};
+
+std::shared_mutex mounts_mutex;
+std::vector<Mount> mounts;
+
+vfs::File map_file(const std::filesystem::path &path)
+{
+  auto file = std::make_shared<const Mapped_file>(path);
+  if (!file->is_open())
+    return {};
+  const auto data = file->span();
+  return {std::move(file), data};
+}
+
+vfs::File open_entry(const std::shared_ptr<const Mapped_file> &archive, const pack::Entry &entry, std::string_view name)
+{
+  const auto stored = pack::data(archive->span(), entry);
+  if (!(entry.flags & pack::flag_lz4))
+    return {archive, stored};
+
+  auto unpacked = std::make_shared<std::vector<uint8_t>>(entry.size);
+  const int size = LZ4_decompress_safe(reinterpret_cast<const char *>(stored.data()),
+                                       reinterpret_cast<char *>(unpacked->data()), static_cast<int>(stored.size()),
+                                       static_cast<int>(unpacked->size()));
+  if (size < 0 || static_cast<uint32_t>(size) != entry.size)
+  {
+    logger::logger->error("Corrupted archive entry: {}", name);
+    return {};
+  }
+  const std::span<const uint8_t> data{unpacked->data(), unpacked->size()};
+  return {std::move(unpacked), data};
+}
+
+}    // namespace
+
+namespace blackboard::app::vfs {
+
+bool mount_directory(const std::filesystem::path &root)
+{
+  std::error_code error;
+  if (!std::filesystem::is_directory(root, error))
+  {
+    logger::logger->error("Error mounting directory: {}", root.string());
+    return false;
+  }
+
+  std::unique_lock lock{mounts_mutex};
+  mounts.push_back({.root = root.lexically_normal(), .archive = nullptr});
+  return true;
+}
+
+bool mount_archive(const std::filesystem::path &archive_path)
+{
+  auto archive = std::make_shared<const Mapped_file>(archive_path);
+  if (!archive->is_open())
+  {
+    logger::logger->error("Error opening archive: {}", archive_path.string());
+    return false;
+  }
+  if (!pack::header(archive->span()))
+  {
+    logger::logger->error("Invalid archive: {}", archive_path.string());
+    return false;
+  }
+
+  std::unique_lock lock{mounts_mutex};
+  mounts.push_back({.root = {}, .archive = std::move(archive)});
+  return true;
+}
+
+void unmount_all()
+{
+  std::unique_lock lock{mounts_mutex};
+  mounts.clear();
+}
+
+File open(std::string_view name)
+{
+  std::shared_lock lock{mounts_mutex};
+  for (auto it = mounts.rbegin(); it != mounts.rend(); ++it)
+  {
+    if (it->archive)
+    {
+      if (const auto *entry = pack::find(it->archive->span(), name); entry)
+        return open_entry(it->archive, *entry, name);
+    }
+    else if (auto file = map_file(it->root / name); file.is_open())
+    {
+      return file;
+    }
+  }
+  return {};
+}
+
+File open(const std::filesystem::path &path)
+{
+  if (path.is_relative())
+    return open(std::string_view{path.generic_string()});
+
+  std::string name;
+  {
+    std::shared_lock lock{mounts_mutex};
+    const auto normal_path = path.lexically_normal();
+    for (const auto &mount : mounts)
+    {
+      if (mount.archive)
+        continue;
+      const auto relative = normal_path.lexically_relative(mount.root);
+      if (!relative.empty() && *relative.begin() != "..")
+      {
+        name = relative.generic_string();
+        break;
+      }
+    }
+  }
+  return name.empty() ? map_file(path) : open(std::string_view{name});
+}
+
+bool exists(std::string_view name)
+{
+  std::shared_lock lock{mounts_mutex};
+  for (auto it = mounts.rbegin(); it != mounts.rend(); ++it)
+  {
+    if (it->archive ? pack::find(it->archive->span(), name) != nullptr
+                    : std::filesystem::exists(it->root / name))
+      return true;
+  }
+  return false;
+}
+
+const bgfx::Memory *make_ref(File &&file)
+{
+  if (!file.is_open())
+    return nullptr;
+
+  auto *owner = new File{std::move(file)};
+  return bgfx::makeRef(
+    owner->data(), static_cast<uint32_t>(owner->size()),
+    [](void *, void *user_data) { delete static_cast<File *>(user_data); }, owner);
+}
+
+}    // namespace blackboard::app::vfs
@@ -0,0 +1,85 @@
+#pragma once
+#include <stdint.h>
+
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace bgfx {
+struct Memory;
+}
+
+// Virtual file system: directories and pack archives (see pack.h) are mounted once and files are looked up by
+// their path relative to the mount, e.g. "assets/fonts/Inter/Inter-Light.otf". Mounts added later are searched
+// first. Archive entries are served straight from the mapped archive, LZ4 entries are unpacked on open.
+
+namespace blackboard::app::vfs {
+
+/// @brief Read only view of a file, the data stays valid while any copy of the File is alive
+class File
+{
+  public:
+  File() = default;
+  File(std::shared_ptr<const void> owner, std::span<const uint8_t> data)
+  : m_owner{std::move(owner)}, m_data{data}
+  {}
+
+  bool is_open() const
+  {
+    return m_owner != nullptr;
+  }
+
+  const uint8_t *data() const
+  {
+    return m_data.data();
+  }
+
+  size_t size() const
+  {
+    return m_data.size();
+  }
+
+  std::span<const uint8_t> span() const
+  {
+    return m_data;
+  }
+
+  private:
+  std::shared_ptr<const void> m_owner;
+  std::span<const uint8_t> m_data;
+};
+
+bool mount_directory(const std::filesystem::path &root);
+
+/// @brief Map the archive and index it, its entries take priority over the mounts added before
+bool mount_archive(const std::filesystem::path &archive_path);
+
+/// @brief Files already opened stay valid
+void unmount_all();
+
+/// @brief Open a file by its path relative to the mounts, not open if no mount has it
+File open(std::string_view name);
+
+inline File open(const char *name)
+{
+  return open(std::string_view{name});
+}
+
+inline File open(const std::string &name)
+{
+  return open(std::string_view{name});
+}
+
+/// @brief Absolute paths inside a mounted directory are looked up through the mounts (so archives can
+/// replace them), any other absolute path is mapped directly
+File open(const std::filesystem::path &path);
+
+bool exists(std::string_view name);
+
+/// @brief Hand the data to bgfx without copying it, the File is released by bgfx once it is consumed.
+/// Returns nullptr if the file is not open.
+const bgfx::Memory *make_ref(File &&file);
+
+}    // namespace blackboard::app::vfs
@@ -14,7 +14,7 @@ namespace blackboard::app {
 
 Window::~Window()
 {
-  logger::logger->info("Window {} destroyed", title);
+  BB_LOG_INFO("Window {} destroyed", title);
 }
 
 void Window::init_platform_window()
@@ -22,6 +22,7 @@ void Window::init_platform_window()
   window = SDL_CreateWindow(title.c_str(), width, height, SDL_WINDOW_RESIZABLE);
   SDL_SetWindowPosition(window, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED);
   SDL_SetWindowFullscreen(window, static_cast<SDL_bool>(fullscreen));
+  update_ddpi();
 
 //#ifdef _WIN32
 //  SetProcessDpiAwarenessContext(DPI_AWARENESS_CONTEXT_PER_MONITOR_AWARE_V2);
@@ -36,9 +37,17 @@ std::pair<uint16_t, uint16_t> Window::get_size_in_pixels() const
 }
 
 float Window::get_ddpi() const
+{
+  return ddpi;
+}
+
+void Window::update_ddpi()
 {
   // https://github.com/libsdl-org/SDL/blob/813c586edb9c3e83446f4cf6e801c8a62a3f9d17/docs/README-migration.md?plain=1#LL1092C122-L1092C122
-  return SDL_GetDesktopDisplayMode(SDL_GetDisplayForWindow(window))->display_scale * 96.0f;
+  if (const auto *mode = SDL_GetDesktopDisplayMode(SDL_GetDisplayForWindow(window)); mode)
+  {
+    ddpi = mode->display_scale * 96.0f;
+  }
 }
 
 std::pair<uint16_t, uint16_t> Window::get_position() const
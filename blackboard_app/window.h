@@ -12,7 +12,10 @@ struct Window
   void init_platform_window();
 
   std::pair<uint16_t, uint16_t> get_size_in_pixels() const;
+  /// @brief Dots per inch of the display showing the window, read on the main thread by update_ddpi. Any thread
   float get_ddpi() const;
+  /// @brief Read the dpi of the display showing the window. Main thread
+  void update_ddpi();
 
   // get position
   std::pair<uint16_t, uint16_t> get_position() const;
@@ -24,6 +27,7 @@ struct Window
   bool fullscreen{false};
   SDL_Window *window{nullptr};
   bool is_dragging{false};
+  float ddpi{96.0f};
 };
 
 }    // namespace blackboard::app
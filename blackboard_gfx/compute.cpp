@@ -0,0 +1,90 @@
+#include "compute.h"
+
+#include "program.h"
+
+#include <blackboard_app/logger.h>
+
+namespace blackboard::gfx {
+
+bool compute_supported()
+{
+  // the Noop renderer reports every capability but never executes anything
+  return bgfx::getRendererType() != bgfx::RendererType::Noop && (bgfx::getCaps()->supported & BGFX_CAPS_COMPUTE);
+}
+
+bgfx::DynamicVertexBufferHandle create_compute_buffer(uint32_t vec4_count, bgfx::Access::Enum access)
+{
+  static const bgfx::VertexLayout layout = [] {
+    bgfx::VertexLayout vec4_layout;
+    vec4_layout.begin().add(bgfx::Attrib::TexCoord0, 4, bgfx::AttribType::Float).end();
+    return vec4_layout;
+  }();
+
+  uint16_t flags{BGFX_BUFFER_NONE};
+  switch (access)
+  {
+    case bgfx::Access::Read:
+      flags = BGFX_BUFFER_COMPUTE_READ;
+      break;
+    case bgfx::Access::Write:
+      flags = BGFX_BUFFER_COMPUTE_WRITE;
+      break;
+    default:
+      flags = BGFX_BUFFER_COMPUTE_READ_WRITE;
+      break;
+  }
+  return bgfx::createDynamicVertexBuffer(vec4_count, layout, flags);
+}
+
+Compute_bindings &Compute_bindings::buffer(uint8_t stage, Buffer_handle handle, bgfx::Access::Enum access)
+{
+  buffers.push_back({.stage = stage, .handle = handle, .access = access});
+  return *this;
+}
+
+Compute_bindings &Compute_bindings::image(uint8_t stage, bgfx::TextureHandle handle, uint8_t mip,
+                                          bgfx::Access::Enum access, bgfx::TextureFormat::Enum format)
+{
+  images.push_back({.stage = stage, .handle = handle, .mip = mip, .access = access, .format = format});
+  return *this;
+}
+
+bool dispatch(bgfx::ViewId view_id, const Program &program, const Compute_bindings &bindings, uint32_t groups_x,
+              uint32_t groups_y, uint32_t groups_z, const Compute_reference &cpu_reference)
+{
+  if (compute_supported() && bgfx::isValid(program.program_handle))
+  {
+    bgfx::Encoder *encoder = bgfx::begin();
+    for (const auto &buffer : bindings.buffers)
+    {
+      std::visit([&](auto handle) { encoder->setBuffer(buffer.stage, handle, buffer.access); }, buffer.handle);
+    }
+    for (const auto &image : bindings.images)
+    {
+      encoder->setImage(image.stage, image.handle, image.mip, image.access, image.format);
+    }
+    encoder->dispatch(view_id, program.program_handle, groups_x, groups_y, groups_z);
+    bgfx::end(encoder);
+    return true;
+  }
+
+  if (!cpu_reference)
+  {
+    BB_LOG_LIMITED(spdlog::level::warn, 1, "Compute is not supported and the dispatch has no CPU reference, skipping it");
+    return false;
+  }
+
+  for (uint32_t z = 0u; z < groups_z; ++z)
+  {
+    for (uint32_t y = 0u; y < groups_y; ++y)
+    {
+      for (uint32_t x = 0u; x < groups_x; ++x)
+      {
+        cpu_reference(x, y, z);
+      }
+    }
+  }
+  return false;
+}
+
+}    // namespace blackboard::gfx
@@ -0,0 +1,57 @@
+#pragma once
+#include <bgfx/bgfx.h>
+
+#include <functional>
+#include <variant>
+#include <vector>
+
+namespace blackboard::gfx {
+
+struct Program;
+
+/// @brief True when the current renderer runs compute programs, always false with the Noop renderer
+bool compute_supported();
+
+/// @brief Dynamic buffer of float4 elements, bound as a structured buffer (BUFFER_RW_*) by compute shaders
+bgfx::DynamicVertexBufferHandle create_compute_buffer(uint32_t vec4_count, bgfx::Access::Enum access);
+
+/// @brief Buffers and images bound to a compute dispatch, stage is the register used in the shader
+struct Compute_bindings
+{
+  using Buffer_handle = std::variant<bgfx::VertexBufferHandle, bgfx::DynamicVertexBufferHandle, bgfx::IndexBufferHandle,
+                                     bgfx::DynamicIndexBufferHandle>;
+
+  struct Buffer
+  {
+    uint8_t stage{0u};
+    Buffer_handle handle{};
+    bgfx::Access::Enum access{bgfx::Access::Read};
+  };
+
+  struct Image
+  {
+    uint8_t stage{0u};
+    bgfx::TextureHandle handle{bgfx::kInvalidHandle};
+    uint8_t mip{0u};
+    bgfx::Access::Enum access{bgfx::Access::Read};
+    bgfx::TextureFormat::Enum format{bgfx::TextureFormat::Count};
+  };
+
+  Compute_bindings &buffer(uint8_t stage, Buffer_handle handle, bgfx::Access::Enum access);
+  Compute_bindings &image(uint8_t stage, bgfx::TextureHandle handle, uint8_t mip, bgfx::Access::Enum access,
+                          bgfx::TextureFormat::Enum format = bgfx::TextureFormat::Count);
+
+  std::vector<Buffer> buffers;
+  std::vector<Image> images;
+};
+
+/// @brief CPU version of a compute shader, called once per workgroup with its gl_WorkGroupID.
+/// It works on the CPU copies of the data the caller also uploads to the bound buffers.
+using Compute_reference = std::function<void(uint32_t group_x, uint32_t group_y, uint32_t group_z)>;
+
+/// @brief Dispatch the compute program on the GPU, or run the reference for every workgroup when compute is not
+/// supported (e.g. Noop renderer). Returns true when the work went to the GPU.
+bool dispatch(bgfx::ViewId view_id, const Program &program, const Compute_bindings &bindings, uint32_t groups_x,
+              uint32_t groups_y = 1u, uint32_t groups_z = 1u, const Compute_reference &cpu_reference = {});
+
+}    // namespace blackboard::gfx
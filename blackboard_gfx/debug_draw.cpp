@@ -0,0 +1,273 @@
+#include "debug_draw.h"
+
+#include <fs_debug_draw.bin.h>    // generated by embed_shaders
+#include <vs_debug_draw.bin.h>
+
+#include <blackboard_app/gui.h>
+#include <blackboard_app/logger.h>
+
+#include <bgfx/embedded_shader.h>
+#include <imgui/imgui.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace blackboard::gfx::debug_draw {
+
+struct Vertex
+{
+  float x;
+  float y;
+  float z;
+  uint32_t abgr;
+};
+
+struct Marker
+{
+  glm::vec3 position;
+  uint32_t abgr;
+  std::string text;
+};
+
+// shapes added by a thread during the frame
+struct Stream
+{
+  std::array<std::vector<Vertex>, static_cast<size_t>(Mode::COUNT)> lines;
+  std::vector<Marker> markers;
+};
+
+static constexpr int circle_segments{32};
+static constexpr std::array<uint64_t, static_cast<size_t>(Mode::COUNT)> states{
+  BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A | BGFX_STATE_DEPTH_TEST_LEQUAL | BGFX_STATE_PT_LINES |
+    BGFX_STATE_LINEAA | BGFX_STATE_BLEND_ALPHA,
+  BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A | BGFX_STATE_PT_LINES | BGFX_STATE_LINEAA | BGFX_STATE_BLEND_ALPHA};
+
+static const bgfx::EmbeddedShader embedded_shaders[] = {BLACKBOARD_EMBEDDED_SHADER(vs_debug_draw),
+                                                        BLACKBOARD_EMBEDDED_SHADER(fs_debug_draw),
+                                                        BGFX_EMBEDDED_SHADER_END()};
+
+static std::mutex streams_mutex;
+static std::vector<std::unique_ptr<Stream>> streams;
+static thread_local Stream *local_stream{nullptr};
+static bgfx::VertexLayout layout;
+static bgfx::ProgramHandle program = BGFX_INVALID_HANDLE;
+
+static Stream &stream()
+{
+  if (!local_stream)
+  {
+    // once per thread, the streams live until the end of the application
+    std::lock_guard lock{streams_mutex};
+    local_stream = streams.emplace_back(std::make_unique<Stream>()).get();
+  }
+  return *local_stream;
+}
+
+static void add_line(std::vector<Vertex> &lines, const glm::vec3 &from, const glm::vec3 &to, uint32_t abgr)
+{
+  lines.push_back({from.x, from.y, from.z, abgr});
+  lines.push_back({to.x, to.y, to.z, abgr});
+}
+
+static void add_box(std::vector<Vertex> &lines, const glm::vec3 (&corners)[8], uint32_t abgr)
+{
+  // corner i has the max x when bit 0 is set, the max y for bit 1 and the max z for bit 2
+  static constexpr uint8_t edges[12][2]{{0, 1}, {2, 3}, {4, 5}, {6, 7}, {0, 2}, {1, 3},
+                                        {4, 6}, {5, 7}, {0, 4}, {1, 5}, {2, 6}, {3, 7}};
+  for (const auto &edge : edges)
+    add_line(lines, corners[edge[0]], corners[edge[1]], abgr);
+}
+
+void line(const glm::vec3 &from, const glm::vec3 &to, uint32_t abgr, Mode mode)
+{
+  add_line(stream().lines[static_cast<size_t>(mode)], from, to, abgr);
+}
+
+void box(const glm::vec3 &min, const glm::vec3 &max, uint32_t abgr, Mode mode)
+{
+  glm::vec3 corners[8];
+  for (int corner = 0; corner < 8; ++corner)
+    corners[corner] = {corner & 1 ? max.x : min.x, corner & 2 ? max.y : min.y, corner & 4 ? max.z : min.z};
+  add_box(stream().lines[static_cast<size_t>(mode)], corners, abgr);
+}
+
+void box(const glm::mat4 &transform, const glm::vec3 &min, const glm::vec3 &max, uint32_t abgr, Mode mode)
+{
+  glm::vec3 corners[8];
+  for (int corner = 0; corner < 8; ++corner)
+  {
+    const glm::vec4 position = transform * glm::vec4{corner & 1 ? max.x : min.x, corner & 2 ? max.y : min.y,
+                                                     corner & 4 ? max.z : min.z, 1.0f};
+    corners[corner] = {position.x, position.y, position.z};
+  }
+  add_box(stream().lines[static_cast<size_t>(mode)], corners, abgr);
+}
+
+void sphere(const glm::vec3 &center, float radius, uint32_t abgr, Mode mode)
+{
+  static const auto circle = [] {
+    std::array<std::array<float, 2>, circle_segments + 1> points;
+    for (int i = 0; i <= circle_segments; ++i)
+    {
+      const float angle = 6.2831853f * static_cast<float>(i) / circle_segments;
+      points[i] = {std::cos(angle), std::sin(angle)};
+    }
+    return points;
+  }();
+
+  auto &lines = stream().lines[static_cast<size_t>(mode)];
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    const int u = (axis + 1) % 3;
+    const int v = (axis + 2) % 3;
+    for (int i = 0; i < circle_segments; ++i)
+    {
+      glm::vec3 from = center;
+      glm::vec3 to = center;
+      from[u] += circle[i][0] * radius;
+      from[v] += circle[i][1] * radius;
+      to[u] += circle[i + 1][0] * radius;
+      to[v] += circle[i + 1][1] * radius;
+      add_line(lines, from, to, abgr);
+    }
+  }
+}
+
+void text(const glm::vec3 &position, std::string_view text, uint32_t abgr)
+{
+  stream().markers.push_back({position, abgr, std::string{text}});
+}
+
+static void draw_lines(bgfx::ViewId view_id)
+{
+  std::array<uint32_t, static_cast<size_t>(Mode::COUNT)> counts{};
+  for (const auto &shapes : streams)
+  {
+    for (size_t mode = 0u; mode < counts.size(); ++mode)
+      counts[mode] += static_cast<uint32_t>(shapes->lines[mode].size());
+  }
+  uint32_t total{0u};
+  for (const auto count : counts)
+    total += count;
+  if (total == 0u)
+    return;
+
+  if (!bgfx::isValid(program))
+  {
+    layout.begin()
+      .add(bgfx::Attrib::Position, 3, bgfx::AttribType::Float)
+      .add(bgfx::Attrib::Color0, 4, bgfx::AttribType::Uint8, true)
+      .end();
+    const auto type = bgfx::getRendererType();
+    program = bgfx::createProgram(bgfx::createEmbeddedShader(embedded_shaders, type, "vs_debug_draw"),
+                                  bgfx::createEmbeddedShader(embedded_shaders, type, "fs_debug_draw"), true);
+    if (!bgfx::isValid(program))
+    {
+      BB_LOG_ERROR("Error creating the debug draw program");
+      return;
+    }
+  }
+
+  // the overlay lines are the first dropped when the transient buffer is full
+  const uint32_t vertex_count = std::min(bgfx::getAvailTransientVertexBuffer(total, layout) & ~1u, total);
+  if (vertex_count < total)
+  {
+    BB_LOG_LIMITED(spdlog::level::warn, 1, "Debug draw truncated to {} of {} vertices", vertex_count, total);
+    uint32_t budget = vertex_count;
+    for (auto &count : counts)
+    {
+      count = std::min(count, budget);
+      budget -= count;
+    }
+  }
+  if (vertex_count == 0u)
+    return;
+
+  bgfx::TransientVertexBuffer buffer;
+  bgfx::allocTransientVertexBuffer(&buffer, vertex_count, layout);
+  auto *vertices = reinterpret_cast<Vertex *>(buffer.data);
+  uint32_t start{0u};
+  for (size_t mode = 0u; mode < counts.size(); ++mode)
+  {
+    uint32_t copied{0u};
+    for (const auto &shapes : streams)
+    {
+      const auto count = std::min(static_cast<uint32_t>(shapes->lines[mode].size()), counts[mode] - copied);
+      std::memcpy(vertices + start + copied, shapes->lines[mode].data(), count * sizeof(Vertex));
+      copied += count;
+    }
+    if (counts[mode] == 0u)
+      continue;
+    bgfx::setVertexBuffer(0, &buffer, start, counts[mode]);
+    bgfx::setState(states[mode]);
+    bgfx::submit(view_id, program);
+    start += counts[mode];
+  }
+}
+
+static void draw_markers(const glm::mat4 &view_projection, ImDrawList *draw_list, glm::vec2 min, glm::vec2 max)
+{
+  if (!app::gui::isInit())
+    return;
+  if (!draw_list)
+    draw_list = ImGui::GetBackgroundDrawList();
+  if (min.x == max.x || min.y == max.y)
+  {
+    const auto *viewport = ImGui::GetMainViewport();
+    min = {viewport->Pos.x, viewport->Pos.y};
+    max = {viewport->Pos.x + viewport->Size.x, viewport->Pos.y + viewport->Size.y};
+  }
+
+  for (const auto &shapes : streams)
+  {
+    for (const auto &marker : shapes->markers)
+    {
+      const glm::vec4 clip = view_projection * glm::vec4{marker.position, 1.0f};
+      if (clip.w <= 0.0f || std::abs(clip.x) > clip.w || std::abs(clip.y) > clip.w)
+        continue;
+      const float x = min.x + (clip.x / clip.w * 0.5f + 0.5f) * (max.x - min.x);
+      const float y = min.y + (0.5f - clip.y / clip.w * 0.5f) * (max.y - min.y);
+      const ImVec2 size = ImGui::CalcTextSize(marker.text.c_str());
+      draw_list->AddText(ImVec2{x - size.x * 0.5f, y - size.y * 0.5f}, marker.abgr, marker.text.c_str());
+    }
+  }
+}
+
+void submit(bgfx::ViewId view_id, const glm::mat4 &view_projection, ImDrawList *draw_list, const glm::vec2 &min,
+            const glm::vec2 &max)
+{
+  std::lock_guard lock{streams_mutex};
+  draw_lines(view_id);
+  draw_markers(view_projection, draw_list, min, max);
+
+  for (auto &shapes : streams)
+  {
+    for (auto &lines : shapes->lines)
+      lines.clear();
+    shapes->markers.clear();
+  }
+}
+
+void shutdown()
+{
+  std::lock_guard lock{streams_mutex};
+  if (bgfx::isValid(program))
+  {
+    bgfx::destroy(program);
+    program.idx = bgfx::kInvalidHandle;
+  }
+  for (auto &shapes : streams)
+  {
+    for (auto &lines : shapes->lines)
+      lines.clear();
+    shapes->markers.clear();
+  }
+}
+
+}    // namespace blackboard::gfx::debug_draw
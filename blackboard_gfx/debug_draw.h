@@ -0,0 +1,51 @@
+#pragma once
+#include <bgfx/bgfx.h>
+#include <glm/glm.hpp>
+
+#include <string_view>
+
+struct ImDrawList;
+
+// Immediate mode shapes for debugging, in world space. Every thread appends to its own stream without locking,
+// submit() merges the streams of the frame into one transient vertex buffer and draws all the lines of a mode with a
+// single call. The text markers are projected on the screen and drawn by ImGui. The shapes are added from any
+// thread, but not while submit() runs.
+//
+//   gfx::debug_draw::box(bounds.min, bounds.max, 0xff00ff00);
+//   gfx::debug_draw::text(position, "spawn", 0xffffffff);
+//   gfx::debug_draw::submit(view_id, projection * view);
+
+namespace blackboard::gfx::debug_draw {
+
+enum class Mode : uint8_t
+{
+  DEPTH_TESTED = 0,
+  OVERLAY,    // drawn over the scene
+  COUNT
+};
+
+/// @brief Colors are 0xAABBGGRR, as bgfx and ImGui
+void line(const glm::vec3 &from, const glm::vec3 &to, uint32_t abgr, Mode mode = Mode::DEPTH_TESTED);
+
+void box(const glm::vec3 &min, const glm::vec3 &max, uint32_t abgr, Mode mode = Mode::DEPTH_TESTED);
+
+/// @brief Box given in the space of transform, e.g. the Bounds of an entity
+void box(const glm::mat4 &transform, const glm::vec3 &min, const glm::vec3 &max, uint32_t abgr,
+         Mode mode = Mode::DEPTH_TESTED);
+
+/// @brief Three circles around the axes
+void sphere(const glm::vec3 &center, float radius, uint32_t abgr, Mode mode = Mode::DEPTH_TESTED);
+
+/// @brief Text centered on a point, always over the scene
+void text(const glm::vec3 &position, std::string_view text, uint32_t abgr);
+
+/// @brief Draw the shapes added since the last call. The lines go to view_id and use its transform, the text
+/// markers are projected with view_projection on the rectangle from min to max of draw_list, by default the
+/// background of the main viewport. Between ImGui::NewFrame and ImGui::Render
+void submit(bgfx::ViewId view_id, const glm::mat4 &view_projection, ImDrawList *draw_list = nullptr,
+            const glm::vec2 &min = glm::vec2{0.0f}, const glm::vec2 &max = glm::vec2{0.0f});
+
+/// @brief Release the program, before bgfx::shutdown
+void shutdown();
+
+}    // namespace blackboard::gfx::debug_draw
@@ -0,0 +1,136 @@
+#include "draw_queue.h"
+
+#include <blackboard_app/logger.h>
+
+#include <algorithm>
+
+namespace blackboard::gfx {
+
+// key bits: view 8 | depth 16 | program 12 | material 14 | mesh 14
+static constexpr uint64_t index_mask{0x3fffu};
+static constexpr uint16_t max_indices{0x4000u};
+
+static uint64_t make_key(bgfx::ViewId view_id, uint16_t depth, bgfx::ProgramHandle program, uint16_t material,
+                         uint16_t mesh)
+{
+  return static_cast<uint64_t>(view_id & 0xffu) << 56u | static_cast<uint64_t>(depth) << 40u |
+         static_cast<uint64_t>(program.idx & 0xfffu) << 28u | static_cast<uint64_t>(material) << 14u | mesh;
+}
+
+static bgfx::ViewId view_of(uint64_t key)
+{
+  return static_cast<bgfx::ViewId>(key >> 56u);
+}
+
+static uint16_t material_of(uint64_t key)
+{
+  return static_cast<uint16_t>((key >> 14u) & index_mask);
+}
+
+static uint16_t mesh_of(uint64_t key)
+{
+  return static_cast<uint16_t>(key & index_mask);
+}
+
+uint16_t Draw_queue::add_mesh(const Mesh &mesh)
+{
+  if (m_meshes.size() == max_indices)
+  {
+    BB_LOG_ERROR("The draw queue can not hold more than {} meshes", max_indices);
+    return UINT16_MAX;
+  }
+  m_meshes.push_back(mesh);
+  return static_cast<uint16_t>(m_meshes.size() - 1u);
+}
+
+uint16_t Draw_queue::add_material(const Material &material)
+{
+  if (m_materials.size() == max_indices)
+  {
+    BB_LOG_ERROR("The draw queue can not hold more than {} materials", max_indices);
+    return UINT16_MAX;
+  }
+  m_materials.push_back(material);
+  return static_cast<uint16_t>(m_materials.size() - 1u);
+}
+
+void Draw_queue::push(bgfx::ViewId view_id, uint16_t mesh, uint16_t material, const glm::mat4 &transform,
+                      float depth)
+{
+  if (mesh >= m_meshes.size() || material >= m_materials.size() || !m_materials[material].valid() ||
+      view_id > 0xffu)
+  {
+    BB_LOG_LIMITED(spdlog::level::err, 1, "Draw of an unknown mesh or material ignored");
+    return;
+  }
+
+  // opaque first sorted by state, then blended from the farthest
+  uint16_t depth_bits{0u};
+  if (m_materials[material].blended())
+  {
+    const auto distance = static_cast<uint16_t>(std::clamp(depth, 0.0f, 1.0f) * 0x7fff);
+    depth_bits = static_cast<uint16_t>(0x8000u | (0x7fffu - distance));
+  }
+
+  m_draws.push_back({.key = make_key(view_id, depth_bits, m_materials[material].program(), material, mesh),
+                     .transform = static_cast<uint32_t>(m_transforms.size())});
+  m_transforms.push_back(transform);
+}
+
+void Draw_queue::submit()
+{
+  m_stats = {};
+  std::sort(m_draws.begin(), m_draws.end(), [](const Draw &a, const Draw &b) { return a.key < b.key; });
+
+  const Material *bound_material{nullptr};    // its state and bindings are still set
+  uint16_t bound_mesh{UINT16_MAX};
+  int32_t sequential_view{-1};
+  for (size_t i = 0u; i < m_draws.size(); ++i)
+  {
+    const uint64_t key = m_draws[i].key;
+    const auto view_id = view_of(key);
+    if (view_id != sequential_view)
+    {
+      bgfx::setViewMode(view_id, bgfx::ViewMode::Sequential);
+      sequential_view = view_id;
+    }
+
+    const auto &material = m_materials[material_of(key)];
+    if (!bound_material || *bound_material != material)
+    {
+      m_stats.uniform_uploads += material.bind(bound_material);
+      ++m_stats.material_changes;
+      bound_material = &material;
+    }
+    const uint16_t mesh = mesh_of(key);
+    if (mesh != bound_mesh)
+    {
+      bgfx::setVertexBuffer(0, m_meshes[mesh].vertices);
+      bgfx::setIndexBuffer(m_meshes[mesh].indices);
+      ++m_stats.mesh_changes;
+      bound_mesh = mesh;
+    }
+    bgfx::setTransform(&m_transforms[m_draws[i].transform]);
+
+    // the next draw keeps what it shares with this one
+    uint8_t discard{BGFX_DISCARD_ALL};
+    if (i + 1u < m_draws.size())
+    {
+      const uint64_t next = m_draws[i + 1u].key;
+      discard = BGFX_DISCARD_TRANSFORM | BGFX_DISCARD_INSTANCE_DATA |
+                material.discard_flags(m_materials[material_of(next)]);
+      if (mesh_of(next) != mesh)
+      {
+        discard |= BGFX_DISCARD_VERTEX_STREAMS | BGFX_DISCARD_INDEX_BUFFER;
+        bound_mesh = UINT16_MAX;
+      }
+    }
+    bgfx::submit(view_id, material.program(), 0, discard);
+    ++m_stats.draws;
+  }
+
+  m_draws.clear();
+  m_transforms.clear();
+}
+
+}    // namespace blackboard::gfx
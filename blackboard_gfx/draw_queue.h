@@ -0,0 +1,65 @@
+#pragma once
+#include "material.h"
+#include "mesh.h"
+
+#include <bgfx/bgfx.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// Draws collected during the frame and sorted by a 64 bit key before they reach bgfx: view, depth, program,
+// material and mesh from the most to the least significant bits. Consecutive draws of a material keep its state,
+// textures and uniforms, consecutive draws of a mesh keep its buffers, so bgfx only sees the transitions. Opaque
+// draws are ordered by program then material, the blended ones follow them back to front. The views the queue draws to
+// are made sequential: uniform values carry over from one draw to the next and bgfx must not sort them again.
+//
+//   gfx::Draw_queue queue;
+//   const auto cube = queue.add_mesh({cube_vertices, cube_indices});
+//   const auto red = queue.add_material(gfx::Material{{.program = program, .uniforms = {{"u_color", red}}}});
+//   queue.push(view_id, cube, red, world);
+//   queue.submit();
+
+namespace blackboard::gfx {
+
+class Draw_queue
+{
+  public:
+  struct Stats
+  {
+    uint32_t draws{0u};
+    uint32_t material_changes{0u};
+    uint32_t mesh_changes{0u};
+    uint32_t uniform_uploads{0u};
+  };
+
+  /// @brief Up to 16384 meshes and materials
+  uint16_t add_mesh(const Mesh &mesh);
+  uint16_t add_material(const Material &material);
+
+  /// @brief depth is the distance to the camera normalized from 0 to 1, it only orders the blended materials
+  void push(bgfx::ViewId view_id, uint16_t mesh, uint16_t material, const glm::mat4 &transform, float depth = 0.0f);
+
+  /// @brief Sort and submit the draws pushed since the last call
+  void submit();
+
+  /// @brief Counts of the last submit()
+  const Stats &stats() const
+  {
+    return m_stats;
+  }
+
+  private:
+  struct Draw
+  {
+    uint64_t key;
+    uint32_t transform;
+  };
+
+  std::vector<Mesh> m_meshes;
+  std::vector<Material> m_materials;
+  std::vector<Draw> m_draws;
+  std::vector<glm::mat4> m_transforms;
+  Stats m_stats;
+};
+
+}    // namespace blackboard::gfx
@@ -0,0 +1,312 @@
+#include "frame_graph.h"
+
+#include <blackboard_app/logger.h>
+
+#include <algorithm>
+#include <numeric>
+
+namespace blackboard::gfx {
+
+static constexpr size_t max_attachments{4u};
+
+static bool same_desc(const Texture_desc &a, const Texture_desc &b)
+{
+  return a.width == b.width && a.height == b.height && a.format == b.format && a.flags == b.flags;
+}
+
+static uint64_t texture_bytes(const Texture_desc &desc)
+{
+  bgfx::TextureInfo info;
+  bgfx::calcTextureSize(info, desc.width, desc.height, 1, false, false, 1, desc.format);
+  return info.storageSize;
+}
+
+Resource Frame_graph::Builder::create(const char *name, const Texture_desc &desc)
+{
+  m_graph.m_textures.push_back({.name = name, .desc = desc});
+  return static_cast<Resource>(m_graph.m_textures.size() - 1u);
+}
+
+Resource Frame_graph::Builder::read(Resource resource)
+{
+  if (resource >= m_graph.m_textures.size())
+  {
+    BB_LOG_ERROR("Pass {} reads an unknown resource", m_graph.m_passes[m_pass].name);
+    return invalid_resource;
+  }
+  m_graph.m_passes[m_pass].reads.push_back(resource);
+  return resource;
+}
+
+Resource Frame_graph::Builder::write(Resource resource)
+{
+  auto &pass = m_graph.m_passes[m_pass];
+  if (resource >= m_graph.m_textures.size())
+  {
+    BB_LOG_ERROR("Pass {} writes an unknown resource", pass.name);
+    return invalid_resource;
+  }
+
+  const auto &texture = m_graph.m_textures[resource];
+  if (!pass.writes.empty() && (resource == m_graph.m_backbuffer || pass.writes[0] == m_graph.m_backbuffer))
+  {
+    BB_LOG_ERROR("Pass {} can not write the backbuffer and textures", pass.name);
+    return invalid_resource;
+  }
+  if (pass.writes.size() == max_attachments)
+  {
+    BB_LOG_ERROR("Pass {} writes more than {} textures", pass.name, max_attachments);
+    return invalid_resource;
+  }
+
+  // the results of writes to textures outside of the graph are not known to the graph
+  if (texture.imported || texture.backbuffer)
+    pass.side_effect = true;
+  pass.writes.push_back(resource);
+  return resource;
+}
+
+void Frame_graph::Builder::side_effect()
+{
+  m_graph.m_passes[m_pass].side_effect = true;
+}
+
+bgfx::TextureHandle Frame_graph::Context::texture(Resource resource) const
+{
+  if (resource >= graph->m_textures.size())
+    return BGFX_INVALID_HANDLE;
+  return graph->m_textures[resource].handle;
+}
+
+Frame_graph::Frame_graph(bgfx::ViewId first_view, uint16_t view_count)
+: m_first_view{first_view}, m_view_count{view_count}
+{}
+
+Frame_graph::~Frame_graph()
+{
+  for (auto &framebuffer : m_framebuffers)
+  {
+    if (bgfx::isValid(framebuffer.handle))
+      bgfx::destroy(framebuffer.handle);
+  }
+  for (auto &render_target : m_render_targets)
+  {
+    if (bgfx::isValid(render_target.handle))
+      bgfx::destroy(render_target.handle);
+  }
+}
+
+void Frame_graph::add_pass(const char *name, const Setup &setup, Execute execute)
+{
+  m_passes.push_back({.name = name, .execute = std::move(execute), .reads = {}, .writes = {}});
+  Builder builder{*this, static_cast<uint16_t>(m_passes.size() - 1u)};
+  setup(builder);
+}
+
+Resource Frame_graph::import_texture(const char *name, bgfx::TextureHandle handle, const Texture_desc &desc)
+{
+  m_textures.push_back({.name = name, .desc = desc, .handle = handle, .imported = true});
+  return static_cast<Resource>(m_textures.size() - 1u);
+}
+
+Resource Frame_graph::backbuffer()
+{
+  if (m_backbuffer == invalid_resource)
+  {
+    m_textures.push_back({.name = "backbuffer", .desc = {}, .backbuffer = true});
+    m_backbuffer = static_cast<Resource>(m_textures.size() - 1u);
+  }
+  return m_backbuffer;
+}
+
+void Frame_graph::cull()
+{
+  // passes were added in dependency order: walking them backwards, a pass is needed when a needed pass reads
+  // one of its outputs
+  std::vector<bool> read_later(m_textures.size(), false);
+  for (auto pass = m_passes.rbegin(); pass != m_passes.rend(); ++pass)
+  {
+    pass->culled = !pass->side_effect && std::none_of(pass->writes.begin(), pass->writes.end(),
+                                                      [&](Resource resource) { return read_later[resource]; });
+    if (pass->culled)
+      continue;
+    for (const auto resource : pass->reads)
+      read_later[resource] = true;
+  }
+}
+
+void Frame_graph::allocate()
+{
+  const bgfx::Stats *stats = bgfx::getStats();
+  m_backbuffer_width = stats->width;
+  m_backbuffer_height = stats->height;
+
+  for (uint16_t index = 0u; index < m_passes.size(); ++index)
+  {
+    const auto &pass = m_passes[index];
+    if (pass.culled)
+      continue;
+    const auto use = [&](Resource resource) {
+      auto &texture = m_textures[resource];
+      texture.first_use = std::min(texture.first_use, index);
+      texture.last_use = std::max(texture.last_use, index);
+    };
+    std::for_each(pass.reads.begin(), pass.reads.end(), use);
+    std::for_each(pass.writes.begin(), pass.writes.end(), use);
+  }
+
+  for (auto &render_target : m_render_targets)
+  {
+    render_target.busy_until = -1;
+    render_target.used = false;
+  }
+
+  // transient textures by first use, each one takes a render target of the same description that is free by then
+  std::vector<Resource> transients;
+  for (Resource resource = 0u; resource < m_textures.size(); ++resource)
+  {
+    auto &texture = m_textures[resource];
+    if (texture.imported || texture.backbuffer || texture.first_use == UINT16_MAX)
+      continue;
+    if (texture.desc.width == 0u)
+      texture.desc.width = m_backbuffer_width;
+    if (texture.desc.height == 0u)
+      texture.desc.height = m_backbuffer_height;
+    transients.push_back(resource);
+  }
+  std::stable_sort(transients.begin(), transients.end(),
+                   [this](Resource a, Resource b) { return m_textures[a].first_use < m_textures[b].first_use; });
+
+  for (const auto resource : transients)
+  {
+    auto &texture = m_textures[resource];
+    auto render_target = std::find_if(m_render_targets.begin(), m_render_targets.end(), [&](const auto &target) {
+      return target.busy_until < texture.first_use && same_desc(target.desc, texture.desc);
+    });
+    if (render_target == m_render_targets.end())
+    {
+      const auto handle = bgfx::createTexture2D(texture.desc.width, texture.desc.height, false, 1,
+                                                texture.desc.format, texture.desc.flags);
+      if (!bgfx::isValid(handle))
+      {
+        BB_LOG_ERROR("Error creating the render target of {}", texture.name);
+        continue;
+      }
+      m_render_targets.push_back({.desc = texture.desc, .handle = handle});
+      render_target = m_render_targets.end() - 1;
+    }
+    render_target->busy_until = texture.last_use;
+    render_target->used = true;
+    texture.handle = render_target->handle;
+    m_stats.unaliased_bytes += texture_bytes(texture.desc);
+  }
+  m_stats.transient_textures = static_cast<uint32_t>(transients.size());
+}
+
+bgfx::FrameBufferHandle Frame_graph::framebuffer(const Pass &pass)
+{
+  if (pass.writes.empty() || pass.writes[0] == m_backbuffer)
+    return BGFX_INVALID_HANDLE;
+
+  std::vector<uint16_t> textures;
+  std::vector<bgfx::TextureHandle> handles;
+  for (const auto resource : pass.writes)
+  {
+    textures.push_back(m_textures[resource].handle.idx);
+    handles.push_back(m_textures[resource].handle);
+  }
+
+  auto cached = std::find_if(m_framebuffers.begin(), m_framebuffers.end(),
+                             [&](const auto &framebuffer) { return framebuffer.textures == textures; });
+  if (cached == m_framebuffers.end())
+  {
+    // the render targets outlive their framebuffers
+    const auto handle = bgfx::createFrameBuffer(static_cast<uint8_t>(handles.size()), handles.data(), false);
+    m_framebuffers.push_back({.textures = std::move(textures), .handle = handle});
+    cached = m_framebuffers.end() - 1;
+  }
+  cached->used = true;
+  return cached->handle;
+}
+
+void Frame_graph::release_unused()
+{
+  // a framebuffer stays while all its textures are render targets still used or textures imported this frame,
+  // the imported ones are owned by the application and are never render targets
+  const auto alive = [this](uint16_t texture) {
+    return std::any_of(m_render_targets.begin(), m_render_targets.end(),
+                       [texture](const auto &target) { return target.used && target.handle.idx == texture; }) ||
+           std::any_of(m_textures.begin(), m_textures.end(),
+                       [texture](const auto &imported) { return imported.imported && imported.handle.idx == texture; });
+  };
+  std::erase_if(m_framebuffers, [&](const auto &framebuffer) {
+    const bool stale =
+      !framebuffer.used || !std::all_of(framebuffer.textures.begin(), framebuffer.textures.end(), alive);
+    if (stale && bgfx::isValid(framebuffer.handle))
+      bgfx::destroy(framebuffer.handle);
+    return stale;
+  });
+  std::erase_if(m_render_targets, [](const auto &render_target) {
+    if (!render_target.used)
+      bgfx::destroy(render_target.handle);
+    return !render_target.used;
+  });
+  for (auto &framebuffer : m_framebuffers)
+    framebuffer.used = false;
+}
+
+void Frame_graph::execute()
+{
+  m_stats = {};
+  cull();
+  allocate();
+
+  uint16_t view_count{0u};
+  for (const auto &pass : m_passes)
+  {
+    ++m_stats.passes;
+    if (pass.culled)
+    {
+      ++m_stats.culled;
+      continue;
+    }
+    if (view_count == m_view_count)
+    {
+      BB_LOG_LIMITED(spdlog::level::err, 1, "The frame graph needs more than {} views", m_view_count);
+      break;
+    }
+
+    const auto view_id = static_cast<bgfx::ViewId>(m_first_view + view_count++);
+    uint16_t width = m_backbuffer_width;
+    uint16_t height = m_backbuffer_height;
+    if (!pass.writes.empty() && pass.writes[0] != m_backbuffer)
+    {
+      width = m_textures[pass.writes[0]].desc.width;
+      height = m_textures[pass.writes[0]].desc.height;
+    }
+
+    bgfx::resetView(view_id);
+    bgfx::setViewName(view_id, pass.name.c_str());
+    bgfx::setViewFrameBuffer(view_id, framebuffer(pass));
+    bgfx::setViewRect(view_id, 0, 0, width, height);
+    if (pass.execute)
+      pass.execute({.view_id = view_id, .width = width, .height = height, .graph = this});
+  }
+
+  // the views of the previous frame that are not used anymore
+  for (uint16_t view = view_count; view < m_used_views; ++view)
+    bgfx::resetView(static_cast<bgfx::ViewId>(m_first_view + view));
+  m_used_views = view_count;
+
+  release_unused();
+  m_stats.render_targets = static_cast<uint32_t>(m_render_targets.size());
+  m_stats.render_target_bytes = std::accumulate(
+    m_render_targets.begin(), m_render_targets.end(), uint64_t{0u},
+    [](uint64_t bytes, const auto &render_target) { return bytes + texture_bytes(render_target.desc); });
+
+  m_passes.clear();
+  m_textures.clear();
+  m_backbuffer = invalid_resource;
+}
+
+}    // namespace blackboard::gfx
@@ -0,0 +1,167 @@
+#pragma once
+#include <bgfx/bgfx.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// Per frame graph of render passes. Passes declare the textures they read and write when they are added, then
+// execute() culls the passes whose outputs nobody reads, gives the remaining passes consecutive view ids in the
+// order they were added and backs the transient textures with render targets shared by the resources whose
+// lifetimes do not overlap. The render targets and their framebuffers are kept from one frame to the next.
+// Views are reset before their pass runs and transient textures start undefined: passes set their clear.
+//
+//   gfx::Frame_graph graph;
+//   gfx::Resource color;
+//   graph.add_pass("scene", [&](auto &builder) {
+//     color = builder.write(builder.create("color", {.format = bgfx::TextureFormat::RGBA16F}));
+//     builder.write(builder.create("depth", {.format = bgfx::TextureFormat::D24S8}));
+//   }, [&](const auto &context) { renderer.submit(context.view_id, registry); });
+//   graph.add_pass("tonemap", [&](auto &builder) {
+//     builder.read(color);
+//     builder.write(graph.backbuffer());
+//   }, [&](const auto &context) { draw_fullscreen(context.view_id, context.texture(color)); });
+//   graph.execute();
+
+namespace blackboard::gfx {
+
+/// @brief Index of a texture of the graph
+using Resource = uint16_t;
+inline constexpr Resource invalid_resource{UINT16_MAX};
+
+struct Texture_desc
+{
+  uint16_t width{0u};     // 0 is the backbuffer width
+  uint16_t height{0u};    // 0 is the backbuffer height
+  bgfx::TextureFormat::Enum format{bgfx::TextureFormat::RGBA8};
+  uint64_t flags{BGFX_TEXTURE_RT};
+};
+
+class Frame_graph
+{
+  public:
+  class Builder
+  {
+    public:
+    /// @brief Transient texture, it only exists between the first and the last pass using it
+    Resource create(const char *name, const Texture_desc &desc);
+    /// @brief Sampled by the pass
+    Resource read(Resource resource);
+    /// @brief Render target of the pass, up to 4 textures or the backbuffer
+    Resource write(Resource resource);
+    /// @brief Keep the pass even if nobody reads its outputs
+    void side_effect();
+
+    private:
+    friend class Frame_graph;
+    Builder(Frame_graph &graph, uint16_t pass) : m_graph{graph}, m_pass{pass} {}
+
+    Frame_graph &m_graph;
+    uint16_t m_pass;
+  };
+
+  struct Context
+  {
+    bgfx::ViewId view_id;
+    uint16_t width;
+    uint16_t height;
+    const Frame_graph *graph;
+
+    /// @brief Texture backing the resource during this pass
+    bgfx::TextureHandle texture(Resource resource) const;
+  };
+
+  struct Stats
+  {
+    uint32_t passes{0u};
+    uint32_t culled{0u};
+    uint32_t transient_textures{0u};
+    uint32_t render_targets{0u};       // textures actually allocated for the transient ones
+    uint64_t render_target_bytes{0u};
+    uint64_t unaliased_bytes{0u};      // memory the transient textures would take without aliasing
+  };
+
+  using Setup = std::function<void(Builder &)>;
+  using Execute = std::function<void(const Context &)>;
+
+  /// @brief Passes get the view ids from first_view to first_view + view_count - 1
+  explicit Frame_graph(bgfx::ViewId first_view = 0u, uint16_t view_count = 200u);
+  ~Frame_graph();
+
+  Frame_graph(const Frame_graph &) = delete;
+  Frame_graph &operator=(const Frame_graph &) = delete;
+
+  /// @brief setup runs right away, execute runs from execute() if the pass is not culled
+  void add_pass(const char *name, const Setup &setup, Execute execute);
+
+  /// @brief Texture owned by the caller, passes writing it are never culled
+  Resource import_texture(const char *name, bgfx::TextureHandle handle, const Texture_desc &desc);
+
+  /// @brief The default framebuffer, passes writing it are never culled
+  Resource backbuffer();
+
+  /// @brief Compile and run the passes, then clear them for the next frame
+  void execute();
+
+  /// @brief Counts of the last execute()
+  const Stats &stats() const
+  {
+    return m_stats;
+  }
+
+  private:
+  struct Texture
+  {
+    std::string name;
+    Texture_desc desc;
+    bgfx::TextureHandle handle{bgfx::kInvalidHandle};    // imported, or the render target once compiled
+    bool imported{false};
+    bool backbuffer{false};
+    uint16_t first_use{UINT16_MAX};
+    uint16_t last_use{0u};
+  };
+
+  struct Pass
+  {
+    std::string name;
+    Execute execute;
+    std::vector<Resource> reads;
+    std::vector<Resource> writes;
+    bool side_effect{false};
+    bool culled{false};
+  };
+
+  struct Render_target
+  {
+    Texture_desc desc;
+    bgfx::TextureHandle handle{bgfx::kInvalidHandle};
+    int32_t busy_until{-1};    // last pass of the texture it currently backs
+    bool used{false};
+  };
+
+  struct Framebuffer
+  {
+    std::vector<uint16_t> textures;
+    bgfx::FrameBufferHandle handle{bgfx::kInvalidHandle};
+    bool used{false};
+  };
+
+  void cull();
+  void allocate();
+  bgfx::FrameBufferHandle framebuffer(const Pass &pass);
+  void release_unused();
+
+  std::vector<Texture> m_textures;
+  std::vector<Pass> m_passes;
+  std::vector<Render_target> m_render_targets;
+  std::vector<Framebuffer> m_framebuffers;
+  bgfx::ViewId m_first_view;
+  uint16_t m_view_count;
+  uint16_t m_used_views{0u};    // by the previous execute()
+  Resource m_backbuffer{invalid_resource};
+  uint16_t m_backbuffer_width{0u};
+  uint16_t m_backbuffer_height{0u};
+  Stats m_stats;
+};
+
+}    // namespace blackboard::gfx
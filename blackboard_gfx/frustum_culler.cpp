@@ -0,0 +1,381 @@
+#include "frustum_culler.h"
+
+#include "instanced_renderer.h"
+#include "simd.h"
+
+#include <blackboard_app/thread_pool.h>
+
+#include <entt/entity/registry.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <numeric>
+
+namespace blackboard::gfx {
+
+static constexpr uint32_t leaf_size{8u};
+static constexpr uint32_t empty_lane{UINT32_MAX};
+static constexpr size_t box_chunk_size{16384u};
+// subtrees found on the calling thread before the workers take over
+static constexpr size_t subtree_tasks{64u};
+// the refitted boxes may grow that much before the hierarchy is built again
+static constexpr float max_area_growth{2.0f};
+
+// Arvo: the extents of the rotated box are the sums of the absolute contributions of every axis
+static void world_box(const Bounds &bounds, const glm::mat4 &world, glm::vec3 &min, glm::vec3 &max)
+{
+  min = max = glm::vec3{world[3][0], world[3][1], world[3][2]};
+  for (int column = 0; column < 3; ++column)
+  {
+    for (int row = 0; row < 3; ++row)
+    {
+      const float a = world[column][row] * bounds.min[column];
+      const float b = world[column][row] * bounds.max[column];
+      min[row] += std::min(a, b);
+      max[row] += std::max(a, b);
+    }
+  }
+}
+
+static float total_area(const auto &nodes)
+{
+  float area{0.0f};
+  for (const auto &node : nodes)
+  {
+    for (int lane = 0; lane < 4; ++lane)
+    {
+      if (node.child[lane] == empty_lane)
+        continue;
+      const float x = node.max_x[lane] - node.min_x[lane];
+      const float y = node.max_y[lane] - node.min_y[lane];
+      const float z = node.max_z[lane] - node.min_z[lane];
+      area += x * y + y * z + z * x;
+    }
+  }
+  return area;
+}
+
+// the leaves crossing a plane test their primitives one by one
+static bool intersects(const auto &box, const float (&planes)[6][4])
+{
+  for (const auto &plane : planes)
+  {
+    const float x = plane[0] > 0.0f ? box.max.x : box.min.x;
+    const float y = plane[1] > 0.0f ? box.max.y : box.min.y;
+    const float z = plane[2] > 0.0f ? box.max.z : box.min.z;
+    if (plane[0] * x + plane[1] * y + plane[2] * z + plane[3] < 0.0f)
+      return false;
+  }
+  return true;
+}
+
+void Frustum_culler::update(const entt::registry &registry)
+{
+  const auto start = std::chrono::steady_clock::now();
+  const auto &bounds = registry.storage<Bounds>();
+  const auto &transforms = registry.storage<Transform>();
+
+  // adding or removing entities changes the sequence of the bounds storage
+  const entt::entity *entities = bounds.data();
+  bool changed{false};
+  size_t count{0u};
+  for (size_t i = 0u; i < bounds.size() && !changed; ++i)
+  {
+    if (!transforms.contains(entities[i]))
+      continue;
+    changed = count == m_source.size() || m_source[count] != entities[i];
+    ++count;
+  }
+  if (changed || count != m_source.size())
+  {
+    m_source.clear();
+    for (size_t i = 0u; i < bounds.size(); ++i)
+    {
+      if (transforms.contains(entities[i]))
+        m_source.push_back(entities[i]);
+    }
+    m_entities = m_source;
+    changed = true;
+  }
+
+  m_boxes.resize(m_entities.size());
+  app::parallel_for((m_entities.size() + box_chunk_size - 1u) / box_chunk_size, [&](size_t chunk) {
+    const size_t end = std::min(m_entities.size(), (chunk + 1u) * box_chunk_size);
+    for (size_t i = chunk * box_chunk_size; i < end; ++i)
+    {
+      const auto entity = m_entities[i];
+      world_box(bounds.get(entity), transforms.get(entity).world, m_boxes[i].min, m_boxes[i].max);
+    }
+  });
+
+  if (changed)
+  {
+    build();
+  }
+  else
+  {
+    refit();
+    if (total_area(m_nodes) > m_built_area * max_area_growth)
+      build();
+  }
+
+  m_stats.entities = static_cast<uint32_t>(m_entities.size());
+  m_stats.nodes = static_cast<uint32_t>(m_nodes.size());
+  m_stats.update_ms =
+    std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Frustum_culler::build()
+{
+  ++m_stats.builds;
+  m_nodes.clear();
+  m_built_area = 0.0f;
+  if (m_entities.empty())
+    return;
+
+  m_order.resize(m_entities.size());
+  std::iota(m_order.begin(), m_order.end(), 0u);
+  build_node(0u, static_cast<uint32_t>(m_order.size()));
+
+  // the leaves refer to ranges of primitives
+  std::vector<entt::entity> entities(m_entities.size());
+  std::vector<Box> boxes(m_boxes.size());
+  for (size_t i = 0u; i < m_order.size(); ++i)
+  {
+    entities[i] = m_entities[m_order[i]];
+    boxes[i] = m_boxes[m_order[i]];
+  }
+  m_entities.swap(entities);
+  m_boxes.swap(boxes);
+
+  refit();
+  m_built_area = total_area(m_nodes);
+}
+
+uint32_t Frustum_culler::build_node(uint32_t begin, uint32_t end)
+{
+  // median split along the longest axis of the centroids
+  const auto split = [this](uint32_t first, uint32_t last) {
+    glm::vec3 min{FLT_MAX};
+    glm::vec3 max{-FLT_MAX};
+    for (uint32_t i = first; i < last; ++i)
+    {
+      const auto &box = m_boxes[m_order[i]];
+      min = glm::min(min, box.min + box.max);
+      max = glm::max(max, box.min + box.max);
+    }
+    const glm::vec3 extent = max - min;
+    const int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+    const uint32_t middle = first + (last - first) / 2u;
+    std::nth_element(m_order.begin() + first, m_order.begin() + middle, m_order.begin() + last,
+                     [this, axis](uint32_t a, uint32_t b) {
+                       return m_boxes[a].min[axis] + m_boxes[a].max[axis] < m_boxes[b].min[axis] + m_boxes[b].max[axis];
+                     });
+    return middle;
+  };
+
+  uint32_t ranges[4][2];
+  int range_count{0};
+  if (end - begin <= leaf_size)
+  {
+    ranges[range_count][0] = begin;
+    ranges[range_count++][1] = end;
+  }
+  else
+  {
+    const uint32_t middle = split(begin, end);
+    for (const auto &[first, last] : {std::pair{begin, middle}, std::pair{middle, end}})
+    {
+      if (last - first <= leaf_size)
+      {
+        ranges[range_count][0] = first;
+        ranges[range_count++][1] = last;
+        continue;
+      }
+      const uint32_t quarter = split(first, last);
+      ranges[range_count][0] = first;
+      ranges[range_count++][1] = quarter;
+      ranges[range_count][0] = quarter;
+      ranges[range_count++][1] = last;
+    }
+  }
+
+  const auto index = static_cast<uint32_t>(m_nodes.size());
+  m_nodes.emplace_back();
+  for (int lane = 0; lane < 4; ++lane)
+  {
+    m_nodes[index].child[lane] = empty_lane;
+    m_nodes[index].count[lane] = 0u;
+  }
+  for (int lane = 0; lane < range_count; ++lane)
+  {
+    const auto [first, last] = ranges[lane];
+    if (last - first <= leaf_size)
+    {
+      m_nodes[index].child[lane] = first;
+      m_nodes[index].count[lane] = static_cast<uint8_t>(last - first);
+    }
+    else
+    {
+      const uint32_t child = build_node(first, last);
+      m_nodes[index].child[lane] = child;
+    }
+  }
+  return index;
+}
+
+void Frustum_culler::refit()
+{
+  // the children come after their parent
+  for (size_t index = m_nodes.size(); index-- > 0u;)
+  {
+    auto &node = m_nodes[index];
+    for (int lane = 0; lane < 4; ++lane)
+    {
+      glm::vec3 min{FLT_MAX};
+      glm::vec3 max{-FLT_MAX};
+      if (node.child[lane] == empty_lane)
+      {
+        // inverted, outside of every plane
+      }
+      else if (node.count[lane] != 0u)
+      {
+        for (uint32_t i = node.child[lane]; i < node.child[lane] + node.count[lane]; ++i)
+        {
+          min = glm::min(min, m_boxes[i].min);
+          max = glm::max(max, m_boxes[i].max);
+        }
+      }
+      else
+      {
+        const auto &child = m_nodes[node.child[lane]];
+        for (int child_lane = 0; child_lane < 4; ++child_lane)
+        {
+          min = glm::min(min, glm::vec3{child.min_x[child_lane], child.min_y[child_lane], child.min_z[child_lane]});
+          max = glm::max(max, glm::vec3{child.max_x[child_lane], child.max_y[child_lane], child.max_z[child_lane]});
+        }
+      }
+      node.min_x[lane] = min.x;
+      node.min_y[lane] = min.y;
+      node.min_z[lane] = min.z;
+      node.max_x[lane] = max.x;
+      node.max_y[lane] = max.y;
+      node.max_z[lane] = max.z;
+    }
+  }
+}
+
+void Frustum_culler::visit(const Task &task, const float (&planes)[6][4], std::vector<entt::entity> &visible,
+                           std::vector<Task> &tasks) const
+{
+  const auto &node = m_nodes[task.node];
+  uint32_t outside{0u};
+  uint32_t straddling{0u};
+  if (!task.inside)
+  {
+    const simd::float4 min_x = simd::load(node.min_x);
+    const simd::float4 min_y = simd::load(node.min_y);
+    const simd::float4 min_z = simd::load(node.min_z);
+    const simd::float4 max_x = simd::load(node.max_x);
+    const simd::float4 max_y = simd::load(node.max_y);
+    const simd::float4 max_z = simd::load(node.max_z);
+    const simd::float4 zero = simd::splat(0.0f);
+    simd::mask4 out = zero < zero;    // none
+    simd::mask4 crossing = out;
+    for (const auto &plane : planes)
+    {
+      // the corner farthest along the normal is behind the plane for a box outside, the nearest one for a box
+      // crossing it
+      const simd::float4 a = simd::splat(plane[0]);
+      const simd::float4 b = simd::splat(plane[1]);
+      const simd::float4 c = simd::splat(plane[2]);
+      const simd::float4 d = simd::splat(plane[3]);
+      const simd::float4 farthest = a * (plane[0] > 0.0f ? max_x : min_x) + b * (plane[1] > 0.0f ? max_y : min_y) +
+                                    c * (plane[2] > 0.0f ? max_z : min_z) + d;
+      const simd::float4 nearest = a * (plane[0] > 0.0f ? min_x : max_x) + b * (plane[1] > 0.0f ? min_y : max_y) +
+                                   c * (plane[2] > 0.0f ? min_z : max_z) + d;
+      out = out | (farthest < zero);
+      crossing = crossing | (nearest < zero);
+    }
+    outside = simd::bits(out);
+    straddling = simd::bits(crossing);
+  }
+
+  for (uint32_t lane = 0u; lane < 4u; ++lane)
+  {
+    if (node.child[lane] == empty_lane || outside & (1u << lane))
+      continue;
+    const bool inside = task.inside || !(straddling & (1u << lane));
+    if (node.count[lane] != 0u && inside)
+    {
+      const auto first = m_entities.begin() + node.child[lane];
+      visible.insert(visible.end(), first, first + node.count[lane]);
+    }
+    else if (node.count[lane] != 0u)
+    {
+      for (uint32_t i = node.child[lane]; i < node.child[lane] + node.count[lane]; ++i)
+      {
+        if (intersects(m_boxes[i], planes))
+          visible.push_back(m_entities[i]);
+      }
+    }
+    else
+    {
+      tasks.push_back({.node = node.child[lane], .inside = inside});
+    }
+  }
+}
+
+std::span<const entt::entity> Frustum_culler::cull(const glm::mat4 &view_projection)
+{
+  const auto start = std::chrono::steady_clock::now();
+  m_visible.clear();
+
+  // Gribb and Hartmann, the near plane of a -w..w depth range also holds the 0..w one
+  float planes[6][4];
+  for (int i = 0; i < 4; ++i)
+  {
+    const float w = view_projection[i][3];
+    planes[0][i] = w + view_projection[i][0];
+    planes[1][i] = w - view_projection[i][0];
+    planes[2][i] = w + view_projection[i][1];
+    planes[3][i] = w - view_projection[i][1];
+    planes[4][i] = w + view_projection[i][2];
+    planes[5][i] = w - view_projection[i][2];
+  }
+
+  if (!m_nodes.empty())
+  {
+    std::vector<Task> tasks{{.node = 0u, .inside = false}};
+    std::vector<Task> next;
+    while (!tasks.empty() && tasks.size() < subtree_tasks)
+    {
+      next.clear();
+      for (const auto &task : tasks)
+        visit(task, planes, m_visible, next);
+      tasks.swap(next);
+    }
+
+    m_task_visible.resize(tasks.size());
+    app::parallel_for(tasks.size(), [&](size_t index) {
+      auto &visible = m_task_visible[index];
+      visible.clear();
+      std::vector<Task> stack{tasks[index]};
+      while (!stack.empty())
+      {
+        const Task task = stack.back();
+        stack.pop_back();
+        visit(task, planes, visible, stack);
+      }
+    });
+    for (size_t index = 0u; index < tasks.size(); ++index)
+      m_visible.insert(m_visible.end(), m_task_visible[index].begin(), m_task_visible[index].end());
+  }
+
+  m_stats.visible = static_cast<uint32_t>(m_visible.size());
+  m_stats.cull_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+  return m_visible;
+}
+
+}    // namespace blackboard::gfx
@@ -0,0 +1,88 @@
+#pragma once
+#include "mesh.h"
+
+#include <entt/entity/fwd.hpp>
+#include <glm/glm.hpp>
+
+#include <span>
+#include <vector>
+
+// Finds the entities having Bounds and a Transform inside a view frustum. The world boxes are kept in a four wide
+// bounding volume hierarchy: update() refits it when the entities only moved and builds it again when entities
+// were added or removed, or when the refitted boxes got too loose. cull() tests the planes against the four
+// children of a node at once and walks the subtrees on the workers, the subtrees fully inside skip the tests.
+//
+//   gfx::Frustum_culler culler;
+//   culler.update(registry);
+//   renderer.submit(view_id, registry, culler.cull(projection * view));
+
+namespace blackboard::gfx {
+
+class Frustum_culler
+{
+  public:
+  struct Stats
+  {
+    uint32_t entities{0u};
+    uint32_t visible{0u};
+    uint32_t nodes{0u};
+    uint32_t builds{0u};    // since the creation
+    float update_ms{0.0f};
+    float cull_ms{0.0f};
+  };
+
+  /// @brief Refit or rebuild the hierarchy from the registry, once per frame before culling
+  void update(const entt::registry &registry);
+
+  /// @brief Entities whose world box intersects the frustum of view_projection, valid until the next call
+  std::span<const entt::entity> cull(const glm::mat4 &view_projection);
+
+  const Stats &stats() const
+  {
+    return m_stats;
+  }
+
+  private:
+  // the boxes of the four children in lanes, an empty lane has an inverted box and never passes the tests
+  struct alignas(16) Node
+  {
+    float min_x[4];
+    float min_y[4];
+    float min_z[4];
+    float max_x[4];
+    float max_y[4];
+    float max_z[4];
+    uint32_t child[4];    // node index, or first primitive of a leaf
+    uint8_t count[4];     // primitives of a leaf, 0 for a node
+  };
+
+  struct Box
+  {
+    glm::vec3 min;
+    glm::vec3 max;
+  };
+
+  struct Task
+  {
+    uint32_t node;
+    bool inside;
+  };
+
+  void build();
+  uint32_t build_node(uint32_t begin, uint32_t end);
+  void refit();
+  void visit(const Task &task, const float (&planes)[6][4], std::vector<entt::entity> &visible,
+             std::vector<Task> &tasks) const;
+
+  std::vector<entt::entity> m_source;      // entities of the last build in storage order
+  std::vector<entt::entity> m_entities;    // primitives in leaf order
+  std::vector<Box> m_boxes;                // world box of every primitive
+  std::vector<uint32_t> m_order;           // build scratch
+  std::vector<Node> m_nodes;               // parents before their children
+  std::vector<std::vector<entt::entity>> m_task_visible;
+  std::vector<entt::entity> m_visible;
+  float m_built_area{0.0f};
+  Stats m_stats;
+};
+
+}    // namespace blackboard::gfx
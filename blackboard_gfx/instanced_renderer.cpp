@@ -0,0 +1,234 @@
+#include "instanced_renderer.h"
+
+#include <fs_instanced.bin.h>    // generated by embed_shaders
+#include <vs_instanced.bin.h>
+
+#include <blackboard_app/logger.h>
+#include <blackboard_app/thread_pool.h>
+
+#include <bgfx/embedded_shader.h>
+#include <entt/entity/registry.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace blackboard::gfx {
+
+// entities extracted by a worker job
+static constexpr size_t chunk_size{16384u};
+static constexpr uint16_t instance_stride{64u};
+
+static const bgfx::EmbeddedShader embedded_shaders[] = {BLACKBOARD_EMBEDDED_SHADER(vs_instanced),
+                                                        BLACKBOARD_EMBEDDED_SHADER(fs_instanced),
+                                                        BGFX_EMBEDDED_SHADER_END()};
+
+static void write_instance(uint8_t *destination, const Transform &transform, const glm::vec4 &color)
+{
+  // glm matrices are column major, the shader reads rows
+  float instance[16];
+  for (int row = 0; row < 3; ++row)
+  {
+    for (int column = 0; column < 4; ++column)
+      instance[row * 4 + column] = transform.world[column][row];
+  }
+  for (int i = 0; i < 4; ++i)
+    instance[12 + i] = color[i];
+  std::memcpy(destination, instance, sizeof(instance));
+}
+
+Instanced_renderer::Instanced_renderer()
+{
+  m_instance_layout.begin()
+    .add(bgfx::Attrib::TexCoord7, 4, bgfx::AttribType::Float)
+    .add(bgfx::Attrib::TexCoord6, 4, bgfx::AttribType::Float)
+    .add(bgfx::Attrib::TexCoord5, 4, bgfx::AttribType::Float)
+    .add(bgfx::Attrib::TexCoord4, 4, bgfx::AttribType::Float)
+    .end();
+}
+
+Instanced_renderer::~Instanced_renderer()
+{
+  destroy_batches();
+  if (bgfx::isValid(m_default_program))
+    bgfx::destroy(m_default_program);
+}
+
+uint16_t Instanced_renderer::add_mesh(const Mesh &mesh)
+{
+  m_meshes.push_back(mesh);
+  return static_cast<uint16_t>(m_meshes.size() - 1u);
+}
+
+uint16_t Instanced_renderer::add_material(const Material &material)
+{
+  m_materials.push_back(material);
+  return static_cast<uint16_t>(m_materials.size() - 1u);
+}
+
+uint16_t Instanced_renderer::default_material()
+{
+  if (m_default_material != UINT16_MAX)
+    return m_default_material;
+
+  const auto type = bgfx::getRendererType();
+  m_default_program = bgfx::createProgram(bgfx::createEmbeddedShader(embedded_shaders, type, "vs_instanced"),
+                                          bgfx::createEmbeddedShader(embedded_shaders, type, "fs_instanced"), true);
+  if (!bgfx::isValid(m_default_program))
+    BB_LOG_ERROR("Error creating the instanced program");
+  m_default_material = add_material(Material{{.program = m_default_program}});
+  return m_default_material;
+}
+
+void Instanced_renderer::destroy_batches()
+{
+  for (auto &batch : m_batches)
+  {
+    if (bgfx::isValid(batch.instances))
+      bgfx::destroy(batch.instances);
+  }
+  m_batches.clear();
+}
+
+void Instanced_renderer::submit(bgfx::ViewId view_id, const entt::registry &registry)
+{
+  const auto &renderables = registry.storage<Renderable>();
+  submit(view_id, registry, {renderables.data(), renderables.size()});
+}
+
+void Instanced_renderer::submit(bgfx::ViewId view_id, const entt::registry &registry,
+                                std::span<const entt::entity> entities)
+{
+  const auto start = std::chrono::steady_clock::now();
+  m_stats = {};
+
+  const size_t batch_count = m_meshes.size() * m_materials.size();
+  if (m_batches.size() != batch_count)
+  {
+    destroy_batches();
+    m_batches.resize(batch_count);
+  }
+  if (batch_count == 0u)
+    return;
+
+  // the entities without a renderable or a transform are ignored
+  const auto &renderables = registry.storage<Renderable>();
+  const auto &transforms = registry.storage<Transform>();
+  const auto &colors = registry.storage<Color>();
+  const size_t entity_count = entities.size();
+  const size_t chunk_count = (entity_count + chunk_size - 1u) / chunk_size;
+  const auto mesh_count = static_cast<uint16_t>(m_meshes.size());
+  const auto material_count = static_cast<uint16_t>(m_materials.size());
+
+  const auto for_each_instance = [&](size_t chunk, auto &&function) {
+    const size_t end = std::min(entity_count, (chunk + 1u) * chunk_size);
+    for (size_t i = chunk * chunk_size; i < end; ++i)
+    {
+      const auto entity = entities[i];
+      if (!transforms.contains(entity) || !renderables.contains(entity))
+        continue;
+      const auto &renderable = renderables.get(entity);
+      const bool known = renderable.mesh < mesh_count && renderable.material < material_count;
+      function(entity, known ? renderable.material * mesh_count + renderable.mesh : batch_count);
+    }
+  };
+
+  // count the instances of every batch per chunk, the last column counts the skipped entities
+  const size_t columns = batch_count + 1u;
+  m_counts.assign(chunk_count * columns, 0u);
+  app::parallel_for(chunk_count, [&](size_t chunk) {
+    uint32_t *counts = m_counts.data() + chunk * columns;
+    for_each_instance(chunk, [counts](entt::entity, size_t batch) { ++counts[batch]; });
+  });
+
+  // the counts become the first instance of every chunk inside its batch
+  for (size_t batch = 0u; batch < columns; ++batch)
+  {
+    uint32_t total{0u};
+    for (size_t chunk = 0u; chunk < chunk_count; ++chunk)
+    {
+      auto &count = m_counts[chunk * columns + batch];
+      const uint32_t chunk_instances = count;
+      count = total;
+      total += chunk_instances;
+    }
+    if (batch == batch_count)
+    {
+      m_stats.skipped = total;
+      break;
+    }
+    m_batches[batch].count = total;
+  }
+
+  std::vector<const bgfx::Memory *> memories(batch_count, nullptr);
+  for (size_t batch = 0u; batch < batch_count; ++batch)
+  {
+    if (m_batches[batch].count == 0u)
+      continue;
+    memories[batch] = bgfx::alloc(m_batches[batch].count * instance_stride);
+    m_batches[batch].data = memories[batch]->data;
+  }
+
+  app::parallel_for(chunk_count, [&](size_t chunk) {
+    uint32_t *offsets = m_counts.data() + chunk * columns;
+    for_each_instance(chunk, [&](entt::entity entity, size_t batch) {
+      if (batch == batch_count)
+        return;
+      const glm::vec4 color = colors.contains(entity) ? colors.get(entity).rgba : glm::vec4{1.0f};
+      write_instance(m_batches[batch].data + static_cast<size_t>(offsets[batch]++) * instance_stride,
+                     transforms.get(entity), color);
+    });
+  });
+  m_stats.extract_ms =
+    std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+  // the batches are sorted by material then mesh, consecutive draws keep what they share
+  std::vector<size_t> drawn;
+  for (size_t batch = 0u; batch < batch_count; ++batch)
+  {
+    if (m_batches[batch].count != 0u)
+      drawn.push_back(batch);
+  }
+
+  // the uniforms set by a material are kept by the next ones, bgfx must not reorder the draws
+  bgfx::setViewMode(view_id, bgfx::ViewMode::Sequential);
+  const Material *bound_material{nullptr};
+  for (size_t i = 0u; i < drawn.size(); ++i)
+  {
+    const size_t batch = drawn[i];
+    auto &instances = m_batches[batch];
+
+    // persistent buffers, transient instance data is too small for millions of instances
+    if (!bgfx::isValid(instances.instances))
+    {
+      instances.instances =
+        bgfx::createDynamicVertexBuffer(instances.count, m_instance_layout, BGFX_BUFFER_ALLOW_RESIZE);
+    }
+    bgfx::update(instances.instances, 0u, memories[batch]);
+    instances.data = nullptr;
+
+    const auto &material = m_materials[batch / mesh_count];
+    if (!bound_material || *bound_material != material)
+    {
+      material.bind(bound_material);
+      bound_material = &material;
+    }
+    const auto &mesh = m_meshes[batch % mesh_count];
+    bgfx::setVertexBuffer(0, mesh.vertices);
+    bgfx::setIndexBuffer(mesh.indices);
+    bgfx::setInstanceDataBuffer(instances.instances, 0u, instances.count);
+
+    uint8_t discard{BGFX_DISCARD_ALL};
+    if (i + 1u < drawn.size())
+    {
+      discard = BGFX_DISCARD_TRANSFORM | BGFX_DISCARD_INSTANCE_DATA | BGFX_DISCARD_VERTEX_STREAMS |
+                BGFX_DISCARD_INDEX_BUFFER | material.discard_flags(m_materials[drawn[i + 1u] / mesh_count]);
+    }
+    bgfx::submit(view_id, material.program(), 0, discard);
+
+    m_stats.instances += instances.count;
+    ++m_stats.draws;
+  }
+}
+
+}    // namespace blackboard::gfx
@@ -0,0 +1,97 @@
+#pragma once
+#include "material.h"
+#include "mesh.h"
+
+#include <bgfx/bgfx.h>
+#include <entt/entity/fwd.hpp>
+#include <glm/glm.hpp>
+
+#include <span>
+#include <vector>
+
+// Draws the entities having a Transform and a Renderable with one instanced submit per mesh and material pair.
+// The instances are extracted from the registry by the workers straight into the memory handed to bgfx, 64 bytes
+// each: the first three rows of the world matrix (i_data0..2) and the color (i_data3), see shaders/vs_instanced.sc.
+//
+//   gfx::Instanced_renderer renderer;
+//   const auto cube = renderer.add_mesh({cube_vertices, cube_indices});
+//   const auto lit = renderer.default_material();
+//   registry.emplace<gfx::Renderable>(entity, cube, lit);
+//   registry.emplace<gfx::Transform>(entity, world);
+//   renderer.submit(view_id, registry);
+
+namespace blackboard::gfx {
+
+struct Transform
+{
+  glm::mat4 world{1.0f};
+};
+
+/// @brief Optional, white when missing
+struct Color
+{
+  glm::vec4 rgba{1.0f};
+};
+
+struct Renderable
+{
+  uint16_t mesh{0u};
+  uint16_t material{0u};
+};
+
+class Instanced_renderer
+{
+  public:
+  struct Stats
+  {
+    uint32_t instances{0u};
+    uint32_t draws{0u};
+    uint32_t skipped{0u};    // entities with an unknown mesh or material
+    float extract_ms{0.0f};
+  };
+
+  Instanced_renderer();
+  ~Instanced_renderer();
+
+  Instanced_renderer(const Instanced_renderer &) = delete;
+  Instanced_renderer &operator=(const Instanced_renderer &) = delete;
+
+  uint16_t add_mesh(const Mesh &mesh);
+  uint16_t add_material(const Material &material);
+
+  /// @brief Material drawing the instance colors with a directional light, the meshes need a position and a normal
+  uint16_t default_material();
+
+  /// @brief Extract the instances of the registry and submit one draw per mesh and material pair, the view becomes
+  /// sequential
+  void submit(bgfx::ViewId view_id, const entt::registry &registry);
+
+  /// @brief Same limited to entities, typically the visible ones found by a Frustum_culler
+  void submit(bgfx::ViewId view_id, const entt::registry &registry, std::span<const entt::entity> entities);
+
+  const Stats &stats() const
+  {
+    return m_stats;
+  }
+
+  private:
+  struct Batch
+  {
+    bgfx::DynamicVertexBufferHandle instances{bgfx::kInvalidHandle};
+    uint32_t count{0u};
+    uint8_t *data{nullptr};
+  };
+
+  void destroy_batches();
+
+  std::vector<Mesh> m_meshes;
+  std::vector<Material> m_materials;
+  std::vector<Batch> m_batches;    // material * mesh count + mesh
+  std::vector<uint32_t> m_counts;  // instances of every chunk and batch
+  bgfx::VertexLayout m_instance_layout;
+  bgfx::ProgramHandle m_default_program{bgfx::kInvalidHandle};
+  uint16_t m_default_material{UINT16_MAX};
+  Stats m_stats;
+};
+
+}    // namespace blackboard::gfx
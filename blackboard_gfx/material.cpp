@@ -0,0 +1,129 @@
+#include "material.h"
+
+#include <blackboard_app/logger.h>
+
+#include <algorithm>
+
+namespace blackboard::gfx {
+
+struct Material::Block
+{
+  struct Texture
+  {
+    bgfx::UniformHandle sampler{bgfx::kInvalidHandle};
+    bgfx::TextureHandle handle{bgfx::kInvalidHandle};
+    uint32_t flags{UINT32_MAX};
+  };
+
+  struct Uniform
+  {
+    bgfx::UniformHandle handle{bgfx::kInvalidHandle};
+    glm::vec4 value;
+  };
+
+  bgfx::ProgramHandle program{bgfx::kInvalidHandle};
+  uint64_t state{BGFX_STATE_DEFAULT};
+  std::vector<Texture> textures;
+  std::vector<Uniform> uniforms;
+  void (*texture_used)(bgfx::TextureHandle){nullptr};
+
+  ~Block()
+  {
+    // bgfx counts the references of the uniforms created with the same name
+    for (const auto &texture : textures)
+    {
+      if (bgfx::isValid(texture.sampler))
+        bgfx::destroy(texture.sampler);
+    }
+    for (const auto &uniform : uniforms)
+    {
+      if (bgfx::isValid(uniform.handle))
+        bgfx::destroy(uniform.handle);
+    }
+  }
+};
+
+Material::Material(const Material_desc &desc)
+{
+  auto block = std::make_shared<Block>();
+  block->program = desc.program;
+  block->state = desc.state;
+  block->texture_used = desc.texture_used;
+  for (const auto &texture : desc.textures)
+  {
+    const auto sampler = bgfx::createUniform(texture.sampler.c_str(), bgfx::UniformType::Sampler);
+    if (!bgfx::isValid(sampler))
+      BB_LOG_ERROR("Error creating the sampler {}", texture.sampler);
+    block->textures.push_back({.sampler = sampler, .handle = texture.handle, .flags = texture.flags});
+  }
+  for (const auto &uniform : desc.uniforms)
+  {
+    const auto handle = bgfx::createUniform(uniform.name.c_str(), bgfx::UniformType::Vec4);
+    if (!bgfx::isValid(handle))
+      BB_LOG_ERROR("Error creating the uniform {}", uniform.name);
+    block->uniforms.push_back({.handle = handle, .value = uniform.value});
+  }
+  m_block = std::move(block);
+}
+
+bool Material::valid() const
+{
+  return m_block && bgfx::isValid(m_block->program);
+}
+
+bgfx::ProgramHandle Material::program() const
+{
+  return m_block ? m_block->program : bgfx::ProgramHandle{bgfx::kInvalidHandle};
+}
+
+uint64_t Material::state() const
+{
+  return m_block ? m_block->state : BGFX_STATE_DEFAULT;
+}
+
+bool Material::blended() const
+{
+  return (state() & BGFX_STATE_BLEND_MASK) != 0u;
+}
+
+uint32_t Material::bind(const Material *previous) const
+{
+  if (!m_block)
+    return 0u;
+
+  const Block *before = previous ? previous->m_block.get() : nullptr;
+  if (!before || before->state != m_block->state)
+    bgfx::setState(m_block->state);
+
+  for (uint8_t stage = 0u; stage < m_block->textures.size(); ++stage)
+  {
+    const auto &texture = m_block->textures[stage];
+    if (m_block->texture_used)
+      m_block->texture_used(texture.handle);
+    bgfx::setTexture(stage, texture.sampler, texture.handle, texture.flags);
+  }
+
+  // uniform values outlive the draws, the ones the previous material already set are skipped
+  uint32_t uploads{0u};
+  for (const auto &uniform : m_block->uniforms)
+  {
+    if (before && std::any_of(before->uniforms.begin(), before->uniforms.end(), [&uniform](const auto &set) {
+          return set.handle.idx == uniform.handle.idx && set.value == uniform.value;
+        }))
+    {
+      continue;
+    }
+    bgfx::setUniform(uniform.handle, &uniform.value);
+    ++uploads;
+  }
+  return uploads;
+}
+
+uint8_t Material::discard_flags(const Material &next) const
+{
+  if (*this == next)
+    return BGFX_DISCARD_NONE;
+  return state() == next.state() ? BGFX_DISCARD_BINDINGS : BGFX_DISCARD_BINDINGS | BGFX_DISCARD_STATE;
+}
+
+}    // namespace blackboard::gfx
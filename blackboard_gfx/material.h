@@ -0,0 +1,71 @@
+#pragma once
+#include <bgfx/bgfx.h>
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// Immutable render state of a draw: the program, the bgfx state, the textures and the vec4 uniforms. The sampler
+// and uniform handles are created once with the material and shared by its copies, binding a material after
+// another one only sets what differs between the two.
+//
+//   const gfx::Material red{{.program = program, .uniforms = {{"u_color", {1.0f, 0.0f, 0.0f, 1.0f}}}}};
+
+namespace blackboard::gfx {
+
+struct Material_desc
+{
+  struct Texture
+  {
+    std::string sampler;
+    bgfx::TextureHandle handle{bgfx::kInvalidHandle};    // owned by the caller
+    uint32_t flags{UINT32_MAX};                          // sampler flags, UINT32_MAX keeps the texture ones
+  };
+
+  struct Uniform
+  {
+    std::string name;
+    glm::vec4 value{0.0f};
+  };
+
+  bgfx::ProgramHandle program{bgfx::kInvalidHandle};
+  uint64_t state{BGFX_STATE_DEFAULT};
+  std::vector<Texture> textures;    // the stage is the index
+  std::vector<Uniform> uniforms;
+  /// @brief Called with every texture the material binds, e.g. app::textures::mark_used for textures that can be
+  /// evicted while unused
+  void (*texture_used)(bgfx::TextureHandle){nullptr};
+};
+
+class Material
+{
+  public:
+  Material() = default;
+  explicit Material(const Material_desc &desc);
+
+  bool valid() const;
+  bgfx::ProgramHandle program() const;
+  uint64_t state() const;
+
+  /// @brief Drawn back to front after the opaque materials
+  bool blended() const;
+
+  /// @brief Set the state, textures and uniforms, previous is the material of the last submit if it kept its state
+  /// and uniforms, nullptr sets everything. Returns the uniforms uploaded
+  uint32_t bind(const Material *previous) const;
+
+  /// @brief Discard flags of a submit of this material followed by a draw of next
+  uint8_t discard_flags(const Material &next) const;
+
+  friend bool operator==(const Material &a, const Material &b)
+  {
+    return a.m_block == b.m_block;
+  }
+
+  private:
+  struct Block;
+  std::shared_ptr<const Block> m_block;
+};
+
+}    // namespace blackboard::gfx
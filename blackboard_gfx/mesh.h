@@ -0,0 +1,21 @@
+#pragma once
+#include <bgfx/bgfx.h>
+#include <glm/glm.hpp>
+
+namespace blackboard::gfx {
+
+/// @brief Buffers owned by the caller
+struct Mesh
+{
+  bgfx::VertexBufferHandle vertices{bgfx::kInvalidHandle};
+  bgfx::IndexBufferHandle indices{bgfx::kInvalidHandle};
+};
+
+/// @brief Box of the mesh in its local space
+struct Bounds
+{
+  glm::vec3 min{0.0f};
+  glm::vec3 max{0.0f};
+};
+
+}    // namespace blackboard::gfx
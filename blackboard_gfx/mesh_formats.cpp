@@ -0,0 +1,807 @@
+#include "mesh_formats.h"
+
+#include <blackboard_app/logger.h>
+#include <blackboard_app/thread_pool.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+namespace blackboard::gfx::mesh_formats {
+
+// Text parsing shared by the OBJ and glTF JSON readers, nothing is null terminated
+
+static bool is_space(char c)
+{
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+static bool is_digit(char c)
+{
+  return c >= '0' && c <= '9';
+}
+
+static const char *skip_spaces(const char *text, const char *end)
+{
+  while (text < end && is_space(*text))
+    ++text;
+  return text;
+}
+
+/// @brief Returns the end of the number, nullptr if there is none
+static const char *parse_number(const char *text, const char *end, double &value)
+{
+  static constexpr double powers[]{1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                   1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+  bool negative{false};
+  if (text < end && (*text == '-' || *text == '+'))
+    negative = *text++ == '-';
+
+  // the digits past the precision of the mantissa only count in the exponent
+  uint64_t mantissa{0u};
+  int exponent{0};
+  bool digits{false};
+  for (; text < end && is_digit(*text); ++text, digits = true)
+  {
+    if (mantissa < 100000000000000000ull)
+      mantissa = mantissa * 10u + static_cast<uint64_t>(*text - '0');
+    else
+      ++exponent;
+  }
+  if (text < end && *text == '.')
+  {
+    for (++text; text < end && is_digit(*text); ++text, digits = true)
+    {
+      if (mantissa < 100000000000000000ull)
+      {
+        mantissa = mantissa * 10u + static_cast<uint64_t>(*text - '0');
+        --exponent;
+      }
+    }
+  }
+  if (!digits)
+    return nullptr;
+  if (text < end && (*text == 'e' || *text == 'E'))
+  {
+    ++text;
+    bool negative_exponent{false};
+    if (text < end && (*text == '-' || *text == '+'))
+      negative_exponent = *text++ == '-';
+    int written{0};
+    for (; text < end && is_digit(*text); ++text)
+      written = std::min(written * 10 + (*text - '0'), 10000);
+    exponent += negative_exponent ? -written : written;
+  }
+
+  value = static_cast<double>(mantissa);
+  const int magnitude = std::abs(exponent);
+  const double scale = magnitude < 23 ? powers[magnitude] : std::pow(10.0, magnitude);
+  value = exponent < 0 ? value / scale : value * scale;
+  if (negative)
+    value = -value;
+  return text;
+}
+
+static const char *parse_float(const char *text, const char *end, float &value)
+{
+  double number;
+  text = parse_number(skip_spaces(text, end), end, number);
+  if (text)
+    value = static_cast<float>(number);
+  return text;
+}
+
+static const char *parse_int(const char *text, const char *end, int32_t &value)
+{
+  bool negative{false};
+  if (text < end && (*text == '-' || *text == '+'))
+    negative = *text++ == '-';
+  if (text == end || !is_digit(*text))
+    return nullptr;
+  int64_t number{0};
+  for (; text < end && is_digit(*text); ++text)
+    number = std::min<int64_t>(number * 10 + (*text - '0'), std::numeric_limits<int32_t>::max());
+  value = static_cast<int32_t>(negative ? -number : number);
+  return text;
+}
+
+namespace obj {
+
+// indices as written in the file, negative ones are counted back from the attributes parsed before them
+struct Raw_corner
+{
+  int32_t index[3];    // position, texcoord, normal: 1-based, 0 when missing, chunk based when relative
+  uint8_t relative;    // bit per attribute
+};
+
+struct Chunk
+{
+  std::vector<glm::vec3> positions;
+  std::vector<glm::vec2> texcoords;
+  std::vector<glm::vec3> normals;
+  std::vector<Raw_corner> corners;
+  size_t failed_line{0u};    // offset in the file of the first line that could not be parsed, 0 if none
+};
+
+static const char *parse_face_vertex(const char *text, const char *end, const Chunk &chunk, Raw_corner &corner)
+{
+  const size_t counts[3]{chunk.positions.size(), chunk.texcoords.size(), chunk.normals.size()};
+  corner = {{0, 0, 0}, 0u};
+  for (int attribute = 0; attribute < 3; ++attribute)
+  {
+    if (attribute > 0)
+    {
+      if (text == end || *text != '/')
+        break;
+      ++text;
+      // p//n skips the texture coordinate
+      if (text < end && *text == '/')
+        continue;
+    }
+    int32_t index;
+    text = parse_int(text, end, index);
+    if (!text || index == 0)
+      return nullptr;
+    if (index < 0)
+    {
+      corner.index[attribute] = static_cast<int32_t>(counts[attribute]) + index;
+      corner.relative |= static_cast<uint8_t>(1u << attribute);
+    }
+    else
+    {
+      corner.index[attribute] = index;
+    }
+  }
+  return text;
+}
+
+static bool parse_line(const char *text, const char *end, Chunk &chunk)
+{
+  text = skip_spaces(text, end);
+  if (text == end || *text == '#')
+    return true;
+
+  const char *keyword = text;
+  while (text < end && !is_space(*text))
+    ++text;
+  const std::string_view name{keyword, static_cast<size_t>(text - keyword)};
+  if (name == "v")
+  {
+    glm::vec3 position;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      if (text = parse_float(text, end, position[axis]); !text)
+        return false;
+    }
+    chunk.positions.push_back(position);
+  }
+  else if (name == "vn")
+  {
+    glm::vec3 normal;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      if (text = parse_float(text, end, normal[axis]); !text)
+        return false;
+    }
+    chunk.normals.push_back(normal);
+  }
+  else if (name == "vt")
+  {
+    // the v coordinate is optional, OBJ puts v = 0 at the bottom of the image and bgfx at the top
+    float u;
+    float v{0.0f};
+    if (text = parse_float(text, end, u); !text)
+      return false;
+    parse_float(text, end, v);
+    chunk.texcoords.push_back({u, 1.0f - v});
+  }
+  else if (name == "f")
+  {
+    Raw_corner first{};
+    Raw_corner previous{};
+    int count{0};
+    for (text = skip_spaces(text, end); text < end; text = skip_spaces(text, end), ++count)
+    {
+      Raw_corner corner;
+      if (text = parse_face_vertex(text, end, chunk, corner); !text)
+        return false;
+      if (count == 0)
+        first = corner;
+      else if (count >= 2)
+        chunk.corners.insert(chunk.corners.end(), {first, previous, corner});
+      previous = corner;
+    }
+    if (count < 3)
+      return false;
+  }
+  return true;
+}
+
+static void parse_chunk(const char *text, const char *end, const char *file, Chunk &chunk)
+{
+  while (text < end)
+  {
+    const char *line_end = static_cast<const char *>(std::memchr(text, '\n', static_cast<size_t>(end - text)));
+    if (!line_end)
+      line_end = end;
+    if (!parse_line(text, line_end, chunk))
+    {
+      chunk.failed_line = static_cast<size_t>(text - file) + 1u;
+      return;
+    }
+    text = line_end + 1;
+  }
+}
+
+static std::optional<Geometry> parse(std::string_view name, std::span<const uint8_t> data)
+{
+  // chunks of at least 1 MiB, starting at the beginning of a line
+  const char *file = reinterpret_cast<const char *>(data.data());
+  const char *file_end = file + data.size();
+  const size_t chunk_count = std::clamp<size_t>(data.size() >> 20u, 1u, 256u);
+  std::vector<const char *> starts(chunk_count + 1u, file_end);
+  starts[0] = file;
+  for (size_t chunk = 1u; chunk < chunk_count; ++chunk)
+  {
+    const char *start = std::max(file + data.size() * chunk / chunk_count, starts[chunk - 1u]);
+    const auto *line_end = static_cast<const char *>(std::memchr(start, '\n', static_cast<size_t>(file_end - start)));
+    starts[chunk] = line_end ? line_end + 1 : file_end;
+  }
+
+  std::vector<Chunk> chunks(chunk_count);
+  app::parallel_for(chunk_count,
+                    [&](size_t chunk) { parse_chunk(starts[chunk], starts[chunk + 1u], file, chunks[chunk]); });
+
+  // attributes of the previous chunks, the relative indices of a chunk start from them
+  struct Bases
+  {
+    size_t attributes[3];
+    size_t corners;
+  };
+  std::vector<Bases> bases(chunk_count + 1u, Bases{{0u, 0u, 0u}, 0u});
+  for (size_t chunk = 0u; chunk < chunk_count; ++chunk)
+  {
+    if (chunks[chunk].failed_line)
+    {
+      BB_LOG_ERROR("Error parsing {}: can not read the line at byte {}", name, chunks[chunk].failed_line - 1u);
+      return std::nullopt;
+    }
+    bases[chunk + 1u] = {{bases[chunk].attributes[0] + chunks[chunk].positions.size(),
+                          bases[chunk].attributes[1] + chunks[chunk].texcoords.size(),
+                          bases[chunk].attributes[2] + chunks[chunk].normals.size()},
+                         bases[chunk].corners + chunks[chunk].corners.size()};
+  }
+
+  Geometry geometry;
+  geometry.positions.resize(bases[chunk_count].attributes[0]);
+  geometry.texcoords.resize(bases[chunk_count].attributes[1]);
+  geometry.normals.resize(bases[chunk_count].attributes[2]);
+  geometry.corners.resize(bases[chunk_count].corners);
+  std::atomic<bool> out_of_range{false};
+  app::parallel_for(chunk_count, [&](size_t chunk) {
+    const auto &parsed = chunks[chunk];
+    const auto &base = bases[chunk];
+    std::copy(parsed.positions.begin(), parsed.positions.end(), geometry.positions.begin() + base.attributes[0]);
+    std::copy(parsed.texcoords.begin(), parsed.texcoords.end(), geometry.texcoords.begin() + base.attributes[1]);
+    std::copy(parsed.normals.begin(), parsed.normals.end(), geometry.normals.begin() + base.attributes[2]);
+
+    const size_t totals[3]{geometry.positions.size(), geometry.texcoords.size(), geometry.normals.size()};
+    for (size_t i = 0u; i < parsed.corners.size(); ++i)
+    {
+      const auto &corner = parsed.corners[i];
+      uint32_t resolved[3];
+      for (int attribute = 0; attribute < 3; ++attribute)
+      {
+        const bool relative = corner.relative & (1u << attribute);
+        if (!relative && corner.index[attribute] == 0 && attribute > 0)
+        {
+          resolved[attribute] = no_index;
+          continue;
+        }
+        const int64_t index = relative ? static_cast<int64_t>(base.attributes[attribute]) + corner.index[attribute]
+                                       : static_cast<int64_t>(corner.index[attribute]) - 1;
+        if (index < 0 || static_cast<size_t>(index) >= totals[attribute])
+        {
+          out_of_range.store(true, std::memory_order_relaxed);
+          return;
+        }
+        resolved[attribute] = static_cast<uint32_t>(index);
+      }
+      geometry.corners[base.corners + i] = {resolved[0], resolved[1], resolved[2]};
+    }
+  });
+  if (out_of_range.load())
+  {
+    BB_LOG_ERROR("Error parsing {}: a face references a missing vertex", name);
+    return std::nullopt;
+  }
+  return geometry;
+}
+
+}    // namespace obj
+
+namespace gltf {
+
+static constexpr uint32_t magic{0x46546c67u};           // "glTF"
+static constexpr uint32_t json_chunk{0x4e4f534au};      // "JSON"
+static constexpr uint32_t binary_chunk{0x004e4942u};    // "BIN\0"
+static constexpr int max_depth{64};
+
+// JSON document, the strings point into the file and keep their escapes
+struct Json
+{
+  enum class Type : uint8_t
+  {
+    NONE = 0,
+    BOOLEAN,
+    NUMBER,
+    STRING,
+    ARRAY,
+    OBJECT,
+    COUNT
+  };
+
+  Type type{Type::NONE};
+  double number{0.0};
+  std::string_view string;
+  std::vector<Json> items;               // of arrays and objects
+  std::vector<std::string_view> keys;    // of objects, one per item
+
+  /// @brief A NONE value when missing
+  const Json &operator[](std::string_view key) const
+  {
+    static const Json none;
+    const auto found = std::find(keys.begin(), keys.end(), key);
+    return found == keys.end() ? none : items[static_cast<size_t>(found - keys.begin())];
+  }
+
+  const Json &operator[](size_t index) const
+  {
+    static const Json none;
+    return index < items.size() ? items[index] : none;
+  }
+
+  size_t size() const
+  {
+    return items.size();
+  }
+
+  double number_or(double fallback) const
+  {
+    return type == Type::NUMBER ? number : fallback;
+  }
+
+  /// @brief Non negative integer, fallback otherwise
+  size_t index_or(size_t fallback) const
+  {
+    return type == Type::NUMBER && number >= 0.0 && number < 4294967296.0 ? static_cast<size_t>(number) : fallback;
+  }
+};
+
+static const char *skip_whitespace(const char *text, const char *end)
+{
+  while (text && text < end && (is_space(*text) || *text == '\n'))
+    ++text;
+  return text;
+}
+
+static const char *parse_string(const char *text, const char *end, std::string_view &value)
+{
+  const char *start = ++text;
+  for (; text < end && *text != '"'; ++text)
+  {
+    if (*text == '\\')
+      ++text;
+  }
+  if (text >= end)
+    return nullptr;
+  value = {start, static_cast<size_t>(text - start)};
+  return text + 1;
+}
+
+static const char *parse_value(const char *text, const char *end, Json &value, int depth)
+{
+  text = skip_whitespace(text, end);
+  if (text == end || depth > max_depth)
+    return nullptr;
+
+  const auto literal = [&](std::string_view word) {
+    return static_cast<size_t>(end - text) >= word.size() && std::string_view{text, word.size()} == word;
+  };
+  switch (*text)
+  {
+    case '"':
+      value.type = Json::Type::STRING;
+      return parse_string(text, end, value.string);
+    case '[':
+    case '{':
+    {
+      const bool object = *text == '{';
+      const char close = object ? '}' : ']';
+      value.type = object ? Json::Type::OBJECT : Json::Type::ARRAY;
+      text = skip_whitespace(text + 1, end);
+      if (text < end && *text == close)
+        return text + 1;
+      while (text)
+      {
+        if (object)
+        {
+          std::string_view key;
+          if (text = skip_whitespace(text, end); text == end || *text != '"')
+            return nullptr;
+          if (text = skip_whitespace(parse_string(text, end, key), end); !text || text == end || *text != ':')
+            return nullptr;
+          value.keys.push_back(key);
+          ++text;
+        }
+        if (text = skip_whitespace(parse_value(text, end, value.items.emplace_back(), depth + 1), end);
+            !text || text == end)
+          return nullptr;
+        if (*text == close)
+          return text + 1;
+        text = *text == ',' ? text + 1 : nullptr;
+      }
+      return nullptr;
+    }
+    case 't':
+      value.type = Json::Type::BOOLEAN;
+      value.number = 1.0;
+      return literal("true") ? text + 4 : nullptr;
+    case 'f':
+      value.type = Json::Type::BOOLEAN;
+      return literal("false") ? text + 5 : nullptr;
+    case 'n':
+      return literal("null") ? text + 4 : nullptr;
+    default:
+      value.type = Json::Type::NUMBER;
+      return parse_number(text, end, value.number);
+  }
+}
+
+struct Accessor
+{
+  const uint8_t *data{nullptr};
+  size_t stride{0u};
+  uint32_t count{0u};
+  uint32_t components{0u};
+  uint32_t component_type{0u};
+  bool normalized{false};
+
+  float get(uint32_t element, uint32_t component) const
+  {
+    const uint8_t *source = data + element * stride;
+    switch (component_type)
+    {
+      case 5120:
+      {
+        int8_t value;
+        std::memcpy(&value, source + component, sizeof(value));
+        return normalized ? std::max(value / 127.0f, -1.0f) : value;
+      }
+      case 5121:
+        return normalized ? source[component] / 255.0f : source[component];
+      case 5122:
+      {
+        int16_t value;
+        std::memcpy(&value, source + component * 2u, sizeof(value));
+        return normalized ? std::max(value / 32767.0f, -1.0f) : value;
+      }
+      case 5123:
+      {
+        uint16_t value;
+        std::memcpy(&value, source + component * 2u, sizeof(value));
+        return normalized ? value / 65535.0f : value;
+      }
+      case 5125:
+      {
+        uint32_t value;
+        std::memcpy(&value, source + component * 4u, sizeof(value));
+        return static_cast<float>(value);
+      }
+      default:
+      {
+        float value;
+        std::memcpy(&value, source + component * 4u, sizeof(value));
+        return value;
+      }
+    }
+  }
+
+  uint32_t index(uint32_t element) const
+  {
+    const uint8_t *source = data + element * stride;
+    switch (component_type)
+    {
+      case 5121:
+        return source[0];
+      case 5123:
+      {
+        uint16_t value;
+        std::memcpy(&value, source, sizeof(value));
+        return value;
+      }
+      default:
+      {
+        uint32_t value;
+        std::memcpy(&value, source, sizeof(value));
+        return value;
+      }
+    }
+  }
+};
+
+static size_t component_size(uint32_t component_type)
+{
+  switch (component_type)
+  {
+    case 5120:
+    case 5121:
+      return 1u;
+    case 5122:
+    case 5123:
+      return 2u;
+    case 5125:
+    case 5126:
+      return 4u;
+    default:
+      return 0u;
+  }
+}
+
+static bool read_accessor(const Json &root, std::span<const uint8_t> binary, const Json &index, Accessor &accessor)
+{
+  const auto &json = root["accessors"][index.index_or(no_index)];
+  const auto &view = root["bufferViews"][json["bufferView"].index_or(no_index)];
+  if (view.type != Json::Type::OBJECT || json["sparse"].type != Json::Type::NONE ||
+      view["buffer"].index_or(0u) != 0u)
+    return false;
+
+  static constexpr std::string_view types[]{"SCALAR", "VEC2", "VEC3", "VEC4"};
+  const auto type = std::find(std::begin(types), std::end(types), json["type"].string);
+  accessor.components = static_cast<uint32_t>(type - std::begin(types)) + 1u;
+  accessor.component_type = static_cast<uint32_t>(json["componentType"].index_or(0u));
+  accessor.normalized = json["normalized"].number != 0.0;
+  accessor.count = static_cast<uint32_t>(json["count"].index_or(0u));
+  const size_t element_size = component_size(accessor.component_type) * accessor.components;
+  accessor.stride = view["byteStride"].index_or(element_size);
+  if (type == std::end(types) || element_size == 0u || accessor.count == 0u || accessor.stride < element_size)
+    return false;
+
+  const size_t view_offset = view["byteOffset"].index_or(0u);
+  const size_t view_size = view["byteLength"].index_or(0u);
+  const size_t offset = json["byteOffset"].index_or(0u);
+  if (view_offset + view_size > binary.size() ||
+      offset + accessor.stride * (accessor.count - 1u) + element_size > view_size)
+    return false;
+  accessor.data = binary.data() + view_offset + offset;
+  return true;
+}
+
+static glm::mat4 node_transform(const Json &node)
+{
+  glm::mat4 transform{1.0f};
+  if (const auto &matrix = node["matrix"]; matrix.size() == 16u)
+  {
+    for (int column = 0; column < 4; ++column)
+    {
+      for (int row = 0; row < 4; ++row)
+        transform[column][row] = static_cast<float>(matrix[static_cast<size_t>(column * 4 + row)].number);
+    }
+    return transform;
+  }
+
+  const auto &t = node["translation"];
+  const auto &r = node["rotation"];
+  const auto &s = node["scale"];
+  const float x = static_cast<float>(r[0u].number_or(0.0));
+  const float y = static_cast<float>(r[1u].number_or(0.0));
+  const float z = static_cast<float>(r[2u].number_or(0.0));
+  const float w = static_cast<float>(r[3u].number_or(1.0));
+  const float scale[3]{static_cast<float>(s[0u].number_or(1.0)), static_cast<float>(s[1u].number_or(1.0)),
+                       static_cast<float>(s[2u].number_or(1.0))};
+  transform[0] = glm::vec4{1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + z * w), 2.0f * (x * z - y * w), 0.0f};
+  transform[1] = glm::vec4{2.0f * (x * y - z * w), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + x * w), 0.0f};
+  transform[2] = glm::vec4{2.0f * (x * z + y * w), 2.0f * (y * z - x * w), 1.0f - 2.0f * (x * x + y * y), 0.0f};
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    for (int row = 0; row < 3; ++row)
+      transform[axis][row] *= scale[axis];
+  }
+  transform[3] = glm::vec4{static_cast<float>(t[0u].number_or(0.0)), static_cast<float>(t[1u].number_or(0.0)),
+                           static_cast<float>(t[2u].number_or(0.0)), 1.0f};
+  return transform;
+}
+
+struct Primitive
+{
+  const Json *json;
+  glm::mat4 transform;
+  Accessor positions;
+  Accessor normals;      // count 0 when missing
+  Accessor texcoords;    // count 0 when missing
+  Accessor indices;      // count 0 when missing, the vertices are then used in order
+  size_t base;           // of the attributes in the geometry
+  size_t first_corner;
+  size_t corner_count;
+};
+
+static void add_node(const Json &root, size_t node, const glm::mat4 &parent, int depth,
+                     std::vector<Primitive> &primitives)
+{
+  const auto &json = root["nodes"][node];
+  if (json.type != Json::Type::OBJECT || depth > max_depth)
+    return;
+  const glm::mat4 transform = parent * node_transform(json);
+  if (const auto &mesh = root["meshes"][json["mesh"].index_or(no_index)]; mesh.type == Json::Type::OBJECT)
+  {
+    for (const auto &primitive : mesh["primitives"].items)
+    {
+      auto &added = primitives.emplace_back(Primitive{});
+      added.json = &primitive;
+      added.transform = transform;
+    }
+  }
+  for (const auto &child : json["children"].items)
+    add_node(root, child.index_or(no_index), transform, depth + 1, primitives);
+}
+
+static std::optional<Geometry> parse(std::string_view name, std::span<const uint8_t> data)
+{
+  uint32_t header[5];
+  if (data.size() < sizeof(header))
+  {
+    BB_LOG_ERROR("{} is not a binary glTF file", name);
+    return std::nullopt;
+  }
+  std::memcpy(header, data.data(), sizeof(header));
+  if (header[0] != magic || header[1] != 2u || header[4] != json_chunk ||
+      sizeof(header) + static_cast<size_t>(header[3]) > data.size())
+  {
+    BB_LOG_ERROR("{} is not a binary glTF 2.0 file", name);
+    return std::nullopt;
+  }
+  const char *json_text = reinterpret_cast<const char *>(data.data() + sizeof(header));
+  std::span<const uint8_t> binary;
+  if (const size_t offset = sizeof(header) + header[3]; offset + 8u <= data.size())
+  {
+    uint32_t chunk[2];
+    std::memcpy(chunk, data.data() + offset, sizeof(chunk));
+    if (chunk[1] == binary_chunk && offset + 8u + chunk[0] <= data.size())
+      binary = data.subspan(offset + 8u, chunk[0]);
+  }
+
+  Json root;
+  if (!parse_value(json_text, json_text + header[3], root, 0) || root.type != Json::Type::OBJECT)
+  {
+    BB_LOG_ERROR("Error parsing the JSON of {}", name);
+    return std::nullopt;
+  }
+
+  // nodes of the default scene, every mesh as is without scene
+  std::vector<Primitive> primitives;
+  if (const auto &scenes = root["scenes"]; scenes.size() > 0u)
+  {
+    for (const auto &node : scenes[root["scene"].index_or(0u)]["nodes"].items)
+      add_node(root, node.index_or(no_index), glm::mat4{1.0f}, 0, primitives);
+  }
+  else
+  {
+    for (const auto &mesh : root["meshes"].items)
+    {
+      for (const auto &primitive : mesh["primitives"].items)
+        primitives.push_back({.json = &primitive, .transform = glm::mat4{1.0f}});
+    }
+  }
+
+  Geometry geometry;
+  size_t vertex_count{0u};
+  size_t corner_count{0u};
+  for (auto &primitive : primitives)
+  {
+    const auto &json = *primitive.json;
+    const auto &attributes = json["attributes"];
+    if (json["mode"].index_or(4u) != 4u)
+    {
+      BB_LOG_WARN("{}: only triangle lists are loaded, a primitive is skipped", name);
+      continue;
+    }
+    if (!read_accessor(root, binary, attributes["POSITION"], primitive.positions) ||
+        primitive.positions.components != 3u ||
+        (attributes["NORMAL"].type != Json::Type::NONE &&
+         (!read_accessor(root, binary, attributes["NORMAL"], primitive.normals) ||
+          primitive.normals.components != 3u || primitive.normals.count != primitive.positions.count)) ||
+        (attributes["TEXCOORD_0"].type != Json::Type::NONE &&
+         (!read_accessor(root, binary, attributes["TEXCOORD_0"], primitive.texcoords) ||
+          primitive.texcoords.components != 2u || primitive.texcoords.count != primitive.positions.count)) ||
+        (json["indices"].type != Json::Type::NONE &&
+         (!read_accessor(root, binary, json["indices"], primitive.indices) || primitive.indices.components != 1u ||
+          (primitive.indices.component_type != 5121 && primitive.indices.component_type != 5123 &&
+           primitive.indices.component_type != 5125))))
+    {
+      BB_LOG_ERROR("Error reading the accessors of a primitive of {}", name);
+      return std::nullopt;
+    }
+    primitive.base = vertex_count;
+    primitive.first_corner = corner_count;
+    primitive.corner_count = (primitive.indices.count ? primitive.indices.count : primitive.positions.count) / 3u * 3u;
+    vertex_count += primitive.positions.count;
+    corner_count += primitive.corner_count;
+  }
+
+  // the texture coordinates and normals of every vertex are stored, the missing ones are never referenced
+  geometry.positions.resize(vertex_count);
+  geometry.normals.resize(vertex_count);
+  geometry.texcoords.resize(vertex_count);
+  geometry.corners.resize(corner_count);
+  std::atomic<bool> out_of_range{false};
+  app::parallel_for(primitives.size(), [&](size_t index) {
+    const auto &primitive = primitives[index];
+    if (primitive.positions.count == 0u)
+      return;
+
+    // normals go through the cofactors of the transform, mirrored transforms flip the triangles
+    const auto &transform = primitive.transform;
+    const glm::vec3 columns[3]{{transform[0].x, transform[0].y, transform[0].z},
+                               {transform[1].x, transform[1].y, transform[1].z},
+                               {transform[2].x, transform[2].y, transform[2].z}};
+    const glm::vec3 cofactors[3]{glm::cross(columns[1], columns[2]), glm::cross(columns[2], columns[0]),
+                                 glm::cross(columns[0], columns[1])};
+    const bool mirrored = glm::dot(columns[0], cofactors[0]) < 0.0f;
+    for (uint32_t vertex = 0u; vertex < primitive.positions.count; ++vertex)
+    {
+      const auto &positions = primitive.positions;
+      const glm::vec4 position = transform * glm::vec4{positions.get(vertex, 0u), positions.get(vertex, 1u),
+                                                       positions.get(vertex, 2u), 1.0f};
+      geometry.positions[primitive.base + vertex] = {position.x, position.y, position.z};
+      if (const auto &normals = primitive.normals; normals.count)
+      {
+        glm::vec3 normal = cofactors[0] * normals.get(vertex, 0u) + cofactors[1] * normals.get(vertex, 1u) +
+                           cofactors[2] * normals.get(vertex, 2u);
+        geometry.normals[primitive.base + vertex] = mirrored ? -normal : normal;
+      }
+      if (const auto &texcoords = primitive.texcoords; texcoords.count)
+        geometry.texcoords[primitive.base + vertex] = {texcoords.get(vertex, 0u), texcoords.get(vertex, 1u)};
+    }
+
+    for (size_t corner = 0u; corner < primitive.corner_count; ++corner)
+    {
+      const auto element = static_cast<uint32_t>(corner);
+      const uint32_t vertex = primitive.indices.count ? primitive.indices.index(element) : element;
+      if (vertex >= primitive.positions.count)
+      {
+        out_of_range.store(true, std::memory_order_relaxed);
+        return;
+      }
+      const auto global = static_cast<uint32_t>(primitive.base + vertex);
+      // the second and third corners are swapped for mirrored transforms
+      size_t slot{corner};
+      if (mirrored && corner % 3u == 1u)
+        ++slot;
+      else if (mirrored && corner % 3u == 2u)
+        --slot;
+      geometry.corners[primitive.first_corner + slot] = {global, primitive.texcoords.count ? global : no_index,
+                                                         primitive.normals.count ? global : no_index};
+    }
+  });
+  if (out_of_range.load())
+  {
+    BB_LOG_ERROR("Error parsing {}: an index references a missing vertex", name);
+    return std::nullopt;
+  }
+  return geometry;
+}
+
+}    // namespace gltf
+
+std::optional<Geometry> parse_obj(std::string_view name, std::span<const uint8_t> data)
+{
+  return obj::parse(name, data);
+}
+
+std::optional<Geometry> parse_glb(std::string_view name, std::span<const uint8_t> data)
+{
+  return gltf::parse(name, data);
+}
+
+}    // namespace blackboard::gfx::mesh_formats
@@ -0,0 +1,43 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+// Triangles read from the mesh files, before mesh_loader.h quantizes and optimizes them. Both readers parse on the
+// workers: OBJ text in chunks of lines, glTF primitives one per job.
+
+namespace blackboard::gfx::mesh_formats {
+
+inline constexpr uint32_t no_index{std::numeric_limits<uint32_t>::max()};
+
+// triangles as corners indexing separate attribute arrays, as OBJ files store them
+struct Corner
+{
+  uint32_t position;
+  uint32_t texcoord;    // no_index when missing
+  uint32_t normal;      // no_index when missing, computed from the faces
+};
+
+struct Geometry
+{
+  std::vector<glm::vec3> positions;
+  std::vector<glm::vec3> normals;
+  std::vector<glm::vec2> texcoords;
+  std::vector<Corner> corners;    // three per triangle
+};
+
+/// @brief Wavefront OBJ: v, vt, vn and f lines, faces are triangulated as fans. Groups, smoothing groups and
+/// materials are ignored, the whole file is one mesh
+std::optional<Geometry> parse_obj(std::string_view name, std::span<const uint8_t> data);
+
+/// @brief Binary glTF 2.0: the triangle primitives of the meshes reached from the default scene, in world space,
+/// with their POSITION, NORMAL and TEXCOORD_0 attributes. Only the binary chunk of the file can hold buffers, sparse
+/// accessors, morph targets and skins are not supported
+std::optional<Geometry> parse_glb(std::string_view name, std::span<const uint8_t> data);
+
+}    // namespace blackboard::gfx::mesh_formats
@@ -0,0 +1,343 @@
+#include "mesh_loader.h"
+
+#include "mesh_formats.h"
+#include "mesh_optimizer.h"
+
+#include <blackboard_app/logger.h>
+#include <blackboard_app/mapped_file.h>
+#include <blackboard_app/pack.h>
+#include <blackboard_app/resources.h>
+#include <blackboard_app/thread_pool.h>
+
+#include <bx/math.h>
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace blackboard::gfx {
+
+using mesh_formats::Corner;
+using mesh_formats::Geometry;
+using mesh_formats::no_index;
+
+struct Packed_vertex
+{
+  uint16_t position[4];    // half
+  int16_t normal[4];       // snorm16
+  uint16_t texcoord[2];    // half
+};
+
+static_assert(sizeof(Packed_vertex) == 20u);
+
+const bgfx::VertexLayout &mesh_layout()
+{
+  static const bgfx::VertexLayout layout = [] {
+    bgfx::VertexLayout result;
+    result.begin()
+      .add(bgfx::Attrib::Position, 4, bgfx::AttribType::Half)
+      .add(bgfx::Attrib::Normal, 4, bgfx::AttribType::Int16, true)
+      .add(bgfx::Attrib::TexCoord0, 2, bgfx::AttribType::Half)
+      .end();
+    return result;
+  }();
+  return layout;
+}
+
+static int16_t snorm16(float value)
+{
+  return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+// quantized vertices, those equal once quantized are merged
+static bool quantize(Geometry &geometry, std::vector<Packed_vertex> &vertices, std::vector<uint32_t> &indices)
+{
+  // area weighted normals of the positions, for the corners without one
+  std::vector<glm::vec3> position_normals;
+  if (std::any_of(geometry.corners.begin(), geometry.corners.end(),
+                  [](const Corner &corner) { return corner.normal == no_index; }))
+  {
+    position_normals.assign(geometry.positions.size(), glm::vec3{0.0f});
+    for (size_t corner = 0u; corner + 2u < geometry.corners.size(); corner += 3u)
+    {
+      const auto a = geometry.corners[corner].position;
+      const auto b = geometry.corners[corner + 1u].position;
+      const auto c = geometry.corners[corner + 2u].position;
+      const glm::vec3 normal =
+        glm::cross(geometry.positions[b] - geometry.positions[a], geometry.positions[c] - geometry.positions[a]);
+      position_normals[a] += normal;
+      position_normals[b] += normal;
+      position_normals[c] += normal;
+    }
+  }
+
+  std::vector<Packed_vertex> packed(geometry.corners.size());
+  static constexpr size_t batch_size{1u << 16u};
+  app::parallel_for((packed.size() + batch_size - 1u) / batch_size, [&](size_t batch) {
+    const size_t end = std::min(packed.size(), (batch + 1u) * batch_size);
+    for (size_t corner = batch * batch_size; corner < end; ++corner)
+    {
+      const auto &source = geometry.corners[corner];
+      const auto &position = geometry.positions[source.position];
+      glm::vec3 normal =
+        source.normal == no_index ? position_normals[source.position] : geometry.normals[source.normal];
+      const float length = glm::length(normal);
+      normal = length > 0.0f ? normal / length : glm::vec3{0.0f, 0.0f, 1.0f};
+      const glm::vec2 texcoord = source.texcoord == no_index ? glm::vec2{0.0f} : geometry.texcoords[source.texcoord];
+
+      auto &vertex = packed[corner];
+      vertex = {{bx::halfFromFloat(position.x), bx::halfFromFloat(position.y), bx::halfFromFloat(position.z),
+                 bx::halfFromFloat(1.0f)},
+                {snorm16(normal.x), snorm16(normal.y), snorm16(normal.z), 0},
+                {bx::halfFromFloat(texcoord.x), bx::halfFromFloat(texcoord.y)}};
+    }
+  });
+  geometry = {};
+
+  // open addressing over the packed bytes
+  const size_t capacity = std::bit_ceil(std::max<size_t>(packed.size() * 2u, 16u));
+  std::vector<uint32_t> slots(capacity, no_index);
+  vertices.clear();
+  indices.resize(packed.size());
+  for (size_t corner = 0u; corner < packed.size(); ++corner)
+  {
+    const auto &vertex = packed[corner];
+    size_t slot = app::pack::hash({reinterpret_cast<const char *>(&vertex), sizeof(vertex)}) & (capacity - 1u);
+    while (slots[slot] != no_index && std::memcmp(&vertices[slots[slot]], &vertex, sizeof(vertex)) != 0)
+      slot = (slot + 1u) & (capacity - 1u);
+    if (slots[slot] == no_index)
+    {
+      slots[slot] = static_cast<uint32_t>(vertices.size());
+      vertices.push_back(vertex);
+    }
+    indices[corner] = slots[slot];
+  }
+
+  // triangles collapsed by the quantization
+  size_t kept{0u};
+  for (size_t corner = 0u; corner < indices.size(); corner += 3u)
+  {
+    const auto a = indices[corner];
+    const auto b = indices[corner + 1u];
+    const auto c = indices[corner + 2u];
+    if (a == b || b == c || a == c)
+      continue;
+    indices[kept++] = a;
+    indices[kept++] = b;
+    indices[kept++] = c;
+  }
+  indices.resize(kept);
+  return !indices.empty() && vertices.size() < no_index;
+}
+
+std::optional<Cooked_mesh> cook_mesh(std::string_view name, std::span<const uint8_t> data)
+{
+  const auto start = std::chrono::steady_clock::now();
+  const auto extension = std::filesystem::path{name}.extension().string();
+  std::optional<Geometry> geometry;
+  if (extension == ".obj" || extension == ".OBJ")
+    geometry = mesh_formats::parse_obj(name, data);
+  else if (extension == ".glb" || extension == ".GLB")
+    geometry = mesh_formats::parse_glb(name, data);
+  else
+    BB_LOG_ERROR("Unknown mesh format {}, .obj and .glb files are supported", name);
+  if (!geometry)
+    return std::nullopt;
+
+  std::vector<Packed_vertex> vertices;
+  std::vector<uint32_t> indices;
+  if (!quantize(*geometry, vertices, indices))
+  {
+    BB_LOG_ERROR("{} has no triangle", name);
+    return std::nullopt;
+  }
+
+  const auto decode_position = [](const Packed_vertex &vertex) {
+    return glm::vec3{bx::halfToFloat(vertex.position[0]), bx::halfToFloat(vertex.position[1]),
+                     bx::halfToFloat(vertex.position[2])};
+  };
+  std::vector<glm::vec3> positions(vertices.size());
+  std::transform(vertices.begin(), vertices.end(), positions.begin(), decode_position);
+  const float input_misses = average_cache_miss_ratio(indices, vertices.size());
+  optimize_triangles(indices, positions);
+  // drops the vertices only used by the collapsed triangles
+  vertices.resize(optimize_vertex_fetch(std::span{indices}, std::span{vertices}));
+
+  Cooked_mesh cooked;
+  cooked.bounds = {decode_position(vertices[0]), decode_position(vertices[0])};
+  for (const auto &vertex : vertices)
+  {
+    const auto position = decode_position(vertex);
+    cooked.bounds.min = glm::min(cooked.bounds.min, position);
+    cooked.bounds.max = glm::max(cooked.bounds.max, position);
+  }
+  cooked.vertex_count = static_cast<uint32_t>(vertices.size());
+  cooked.index_count = static_cast<uint32_t>(indices.size());
+  cooked.index32 = vertices.size() > 0x10000u;
+  cooked.vertices.resize(vertices.size() * sizeof(Packed_vertex));
+  std::memcpy(cooked.vertices.data(), vertices.data(), cooked.vertices.size());
+  if (cooked.index32)
+  {
+    cooked.indices.resize(indices.size() * sizeof(uint32_t));
+    std::memcpy(cooked.indices.data(), indices.data(), cooked.indices.size());
+  }
+  else
+  {
+    cooked.indices.resize(indices.size() * sizeof(uint16_t));
+    auto *destination = reinterpret_cast<uint16_t *>(cooked.indices.data());
+    for (const auto index : indices)
+      *destination++ = static_cast<uint16_t>(index);
+  }
+
+  BB_LOG_DEBUG("Cooked {} in {:.1f} ms: {} vertices, {} triangles, cache misses per triangle {:.2f} -> {:.2f}", name,
+               std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count(),
+               cooked.vertex_count, cooked.index_count / 3u, input_misses,
+               average_cache_miss_ratio(indices, vertices.size()));
+  return cooked;
+}
+
+// Mesh cache, one file per source file named by the hash of its content:
+// [Mesh_cache_header][vertices][indices]
+struct Mesh_cache_header
+{
+  uint32_t magic{0x534d4242u};    // "BBMS"
+  uint32_t version{1u};
+  uint64_t key{0u};
+  uint32_t vertex_stride{sizeof(Packed_vertex)};
+  uint32_t vertex_count{0u};
+  uint32_t index_count{0u};
+  uint32_t index_size{0u};
+  float min[3]{};
+  float max[3]{};
+};
+
+static std::filesystem::path mesh_cache_path(uint64_t key)
+{
+  return app::resources::path() / "cache" / "meshes" / fmt::format("{:016x}.mesh", key);
+}
+
+static std::optional<Cooked_mesh> restore_cooked_mesh(uint64_t key, std::span<const uint8_t> file)
+{
+  Mesh_cache_header header;
+  if (file.size() < sizeof(header))
+    return std::nullopt;
+  std::memcpy(&header, file.data(), sizeof(header));
+  const size_t vertices_size = static_cast<size_t>(header.vertex_count) * header.vertex_stride;
+  const size_t indices_size = static_cast<size_t>(header.index_count) * header.index_size;
+  if (header.magic != Mesh_cache_header{}.magic || header.version != Mesh_cache_header{}.version ||
+      header.key != key || header.vertex_stride != sizeof(Packed_vertex) ||
+      (header.index_size != 2u && header.index_size != 4u) ||
+      sizeof(header) + vertices_size + indices_size != file.size())
+    return std::nullopt;
+
+  Cooked_mesh cooked;
+  cooked.vertices.assign(file.begin() + sizeof(header), file.begin() + sizeof(header) + vertices_size);
+  cooked.indices.assign(file.begin() + sizeof(header) + vertices_size, file.end());
+  cooked.index32 = header.index_size == 4u;
+  cooked.vertex_count = header.vertex_count;
+  cooked.index_count = header.index_count;
+  cooked.bounds = {{header.min[0], header.min[1], header.min[2]}, {header.max[0], header.max[1], header.max[2]}};
+  return cooked;
+}
+
+static void save_cooked_mesh(uint64_t key, const Cooked_mesh &cooked)
+{
+  const auto path = mesh_cache_path(key);
+  std::error_code error;
+  std::filesystem::create_directories(path.parent_path(), error);
+  auto temporary_path = path;
+  temporary_path += ".tmp";
+  {
+    std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+      BB_LOG_WARN("Can not write the mesh cache {}", path.string());
+      return;
+    }
+
+    const auto &bounds = cooked.bounds;
+    const Mesh_cache_header header{.key = key,
+                                   .vertex_count = cooked.vertex_count,
+                                   .index_count = cooked.index_count,
+                                   .index_size = cooked.index32 ? 4u : 2u,
+                                   .min = {bounds.min.x, bounds.min.y, bounds.min.z},
+                                   .max = {bounds.max.x, bounds.max.y, bounds.max.z}};
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(cooked.vertices.data()),
+               static_cast<std::streamsize>(cooked.vertices.size()));
+    file.write(reinterpret_cast<const char *>(cooked.indices.data()),
+               static_cast<std::streamsize>(cooked.indices.size()));
+  }
+  // another instance may be reading the previous file
+  std::filesystem::rename(temporary_path, path, error);
+}
+
+std::optional<Cooked_mesh> load_cooked_mesh(std::string_view name, std::span<const uint8_t> data)
+{
+  const uint64_t key = app::pack::hash({reinterpret_cast<const char *>(data.data()), data.size()});
+  if (const app::Mapped_file cache{mesh_cache_path(key)}; cache.is_open())
+  {
+    if (auto cooked = restore_cooked_mesh(key, cache.span()); cooked)
+    {
+      BB_LOG_DEBUG("Mesh {} restored from the cache", name);
+      return cooked;
+    }
+  }
+
+  auto cooked = cook_mesh(name, data);
+  if (cooked)
+    save_cooked_mesh(key, *cooked);
+  return cooked;
+}
+
+// bgfx reads the bytes in place and releases them once the buffer is created
+static const bgfx::Memory *make_ref(std::vector<uint8_t> &&bytes)
+{
+  auto *owned = new std::vector<uint8_t>(std::move(bytes));
+  return bgfx::makeRef(
+    owned->data(), static_cast<uint32_t>(owned->size()),
+    [](void *, void *user_data) { delete static_cast<std::vector<uint8_t> *>(user_data); }, owned);
+}
+
+bool create_mesh(Cooked_mesh &cooked)
+{
+  if (!(bgfx::getCaps()->supported & BGFX_CAPS_VERTEX_ATTRIB_HALF))
+  {
+    BB_LOG_ERROR("The renderer does not support half float vertex attributes");
+    return false;
+  }
+  if (cooked.vertices.empty() || cooked.indices.empty())
+    return false;
+
+  cooked.mesh.vertices = bgfx::createVertexBuffer(make_ref(std::move(cooked.vertices)), mesh_layout());
+  cooked.mesh.indices = bgfx::createIndexBuffer(make_ref(std::move(cooked.indices)),
+                                                cooked.index32 ? BGFX_BUFFER_INDEX32 : BGFX_BUFFER_NONE);
+  cooked.vertices = {};
+  cooked.indices = {};
+  if (!bgfx::isValid(cooked.mesh.vertices) || !bgfx::isValid(cooked.mesh.indices))
+  {
+    BB_LOG_ERROR("Error creating the buffers of a mesh");
+    if (bgfx::isValid(cooked.mesh.vertices))
+      bgfx::destroy(cooked.mesh.vertices);
+    if (bgfx::isValid(cooked.mesh.indices))
+      bgfx::destroy(cooked.mesh.indices);
+    cooked.mesh = {};
+    return false;
+  }
+  return true;
+}
+
+app::assets::Asset<Cooked_mesh> load_mesh(std::string_view name, app::Priority priority)
+{
+  return app::assets::load<Cooked_mesh>(
+    name, priority,
+    [name = std::string{name}](const app::vfs::File &file) { return load_cooked_mesh(name, file.span()); },
+    create_mesh);
+}
+
+}    // namespace blackboard::gfx
@@ -0,0 +1,54 @@
+#pragma once
+#include "mesh.h"
+
+#include <blackboard_app/assets.h>
+
+#include <bgfx/bgfx.h>
+
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+// Meshes loaded from Wavefront OBJ and binary glTF (.glb) files. The text of an OBJ file is parsed in chunks on the
+// workers, the primitives of a glTF file are read on the workers too, every node of the default scene adding its
+// primitives in world space. Triangles are then reordered for the vertex cache and less overdraw (mesh_optimizer.h),
+// vertices are stored as half float positions and texture coordinates with snorm16 normals, 20 bytes each, and
+// indices are 16 bit whenever the vertices fit. Half positions keep about 3 significant digits, so meshes should be
+// modeled around their origin. The cooked result is cached in Resources/cache/meshes by the hash of the file, later
+// loads of the same file map the cache instead of parsing it.
+//
+//   auto ship = gfx::load_mesh("assets/models/ship.glb");
+//   if (const auto *cooked = ship.get(); cooked)
+//     renderer.add_mesh(cooked->mesh);
+
+namespace blackboard::gfx {
+
+/// @brief Vertices in mesh_layout() and indices of a triangle list, ready for the GPU
+struct Cooked_mesh
+{
+  std::vector<uint8_t> vertices;
+  std::vector<uint8_t> indices;    // uint16_t, or uint32_t when index32 is set
+  bool index32{false};
+  uint32_t vertex_count{0u};
+  uint32_t index_count{0u};
+  Bounds bounds;
+  Mesh mesh;    // set by create_mesh, owned by the caller
+};
+
+/// @brief Half float position and texture coordinates, snorm16 normal. Needs BGFX_CAPS_VERTEX_ATTRIB_HALF
+const bgfx::VertexLayout &mesh_layout();
+
+/// @brief Parse a .obj or .glb file, the format is given by the extension of name. Any thread
+std::optional<Cooked_mesh> cook_mesh(std::string_view name, std::span<const uint8_t> data);
+
+/// @brief Cooked mesh of a file from the cache, or cooked and added to the cache. Any thread
+std::optional<Cooked_mesh> load_cooked_mesh(std::string_view name, std::span<const uint8_t> data);
+
+/// @brief Hand the vertices and indices over to bgfx and set cooked.mesh. Main thread
+bool create_mesh(Cooked_mesh &cooked);
+
+/// @brief Load the cooked mesh on the workers and create its buffers on the main thread
+app::assets::Asset<Cooked_mesh> load_mesh(std::string_view name, app::Priority priority = app::Priority::NORMAL);
+
+}    // namespace blackboard::gfx
@@ -0,0 +1,249 @@
+#include "mesh_optimizer.h"
+
+#include <cassert>
+#include <limits>
+
+namespace blackboard::gfx {
+
+static constexpr uint32_t no_vertex{std::numeric_limits<uint32_t>::max()};
+
+// triangles around every vertex, the ones of vertex v are adjacency[offsets[v]] to adjacency[offsets[v + 1] - 1]
+struct Adjacency
+{
+  std::vector<uint32_t> offsets;
+  std::vector<uint32_t> triangles;
+
+  Adjacency(std::span<const uint32_t> indices, size_t vertex_count)
+  : offsets(vertex_count + 1u, 0u), triangles(indices.size())
+  {
+    for (const auto index : indices)
+      ++offsets[index + 1u];
+    for (size_t vertex = 0u; vertex < vertex_count; ++vertex)
+      offsets[vertex + 1u] += offsets[vertex];
+    std::vector<uint32_t> cursors(offsets.begin(), offsets.end() - 1);
+    for (size_t corner = 0u; corner < indices.size(); ++corner)
+      triangles[cursors[indices[corner]]++] = static_cast<uint32_t>(corner / 3u);
+  }
+
+  uint32_t count(uint32_t vertex) const
+  {
+    return offsets[vertex + 1u] - offsets[vertex];
+  }
+};
+
+// Tipsify, returns the triangles in their new order and the first triangle of every cluster, a new cluster starts
+// each time no vertex of the last fans can be fanned around while still in the cache
+static std::vector<uint32_t> tipsify(std::span<const uint32_t> indices, size_t vertex_count, uint32_t cache_size,
+                                     std::vector<uint32_t> &clusters)
+{
+  const Adjacency adjacency{indices, vertex_count};
+  std::vector<uint32_t> live(vertex_count);
+  for (uint32_t vertex = 0u; vertex < vertex_count; ++vertex)
+    live[vertex] = adjacency.count(vertex);
+  // a vertex is in the cache while time - timestamp <= cache_size
+  std::vector<uint32_t> timestamps(vertex_count, 0u);
+  std::vector<uint8_t> emitted(indices.size() / 3u, 0u);
+  std::vector<uint32_t> dead_ends;
+  std::vector<uint32_t> candidates;
+  std::vector<uint32_t> order;
+  order.reserve(indices.size() / 3u);
+  uint32_t time{cache_size + 1u};
+  uint32_t scan{0u};
+
+  const auto skip_dead_end = [&]() {
+    while (!dead_ends.empty())
+    {
+      const auto vertex = dead_ends.back();
+      dead_ends.pop_back();
+      if (live[vertex] > 0u)
+        return vertex;
+    }
+    for (; scan < vertex_count; ++scan)
+    {
+      if (live[scan] > 0u)
+        return scan;
+    }
+    return no_vertex;
+  };
+
+  clusters.assign(1u, 0u);
+  for (uint32_t fanning = indices.empty() ? no_vertex : indices[0]; fanning != no_vertex;)
+  {
+    candidates.clear();
+    for (uint32_t i = adjacency.offsets[fanning]; i < adjacency.offsets[fanning + 1u]; ++i)
+    {
+      const auto triangle = adjacency.triangles[i];
+      if (emitted[triangle])
+        continue;
+      emitted[triangle] = 1u;
+      order.push_back(triangle);
+      for (uint32_t corner = 0u; corner < 3u; ++corner)
+      {
+        const auto vertex = indices[triangle * 3u + corner];
+        dead_ends.push_back(vertex);
+        candidates.push_back(vertex);
+        --live[vertex];
+        if (time - timestamps[vertex] > cache_size)
+          timestamps[vertex] = time++;
+      }
+    }
+
+    // the candidate entered the cache the earliest among the ones that stay in it while their fan is emitted
+    uint32_t next{no_vertex};
+    int64_t best_priority{-1};
+    for (const auto vertex : candidates)
+    {
+      if (live[vertex] == 0u)
+        continue;
+      int64_t priority{0};
+      if (time - timestamps[vertex] + 2u * live[vertex] <= cache_size)
+        priority = time - timestamps[vertex];
+      if (priority > best_priority)
+      {
+        best_priority = priority;
+        next = vertex;
+      }
+    }
+    if (next == no_vertex)
+    {
+      next = skip_dead_end();
+      if (next != no_vertex)
+        clusters.push_back(static_cast<uint32_t>(order.size()));
+    }
+    fanning = next;
+  }
+  return order;
+}
+
+void optimize_triangles(std::span<uint32_t> indices, std::span<const glm::vec3> positions, uint32_t cache_size)
+{
+  assert(indices.size() % 3u == 0u);
+  const size_t triangle_count = indices.size() / 3u;
+  if (triangle_count < 2u)
+    return;
+
+  std::vector<uint32_t> clusters;
+  const auto order = tipsify(indices, positions.size(), cache_size, clusters);
+
+  std::vector<uint32_t> ordered(indices.size());
+  for (size_t triangle = 0u; triangle < triangle_count; ++triangle)
+  {
+    for (size_t corner = 0u; corner < 3u; ++corner)
+      ordered[triangle * 3u + corner] = indices[order[triangle] * 3u + corner];
+  }
+
+  // Tipsify clusters are often a few fans, too small to be moved without losing the cache hits at their borders.
+  // They are merged until they start with an empty cache and still miss at most 5% more than the whole order
+  const float threshold = average_cache_miss_ratio(ordered, positions.size(), cache_size) * 1.05f;
+  std::vector<uint32_t> merged{0u};
+  std::vector<uint32_t> timestamps(positions.size(), 0u);
+  uint32_t misses{0u};
+  uint32_t flushed{0u};    // misses before the merged cluster
+  for (size_t triangle = 0u, cluster = 1u; triangle < triangle_count; ++triangle)
+  {
+    if (cluster < clusters.size() && clusters[cluster] == triangle)
+    {
+      ++cluster;
+      if (static_cast<float>(misses - flushed) <= threshold * static_cast<float>(triangle - merged.back()))
+      {
+        merged.push_back(static_cast<uint32_t>(triangle));
+        flushed = misses;
+      }
+    }
+    for (size_t corner = 0u; corner < 3u; ++corner)
+    {
+      const auto vertex = ordered[triangle * 3u + corner];
+      if (timestamps[vertex] <= flushed || misses - timestamps[vertex] >= cache_size)
+        timestamps[vertex] = ++misses;
+    }
+  }
+  merged.push_back(static_cast<uint32_t>(triangle_count));
+
+  // clusters far from the center of the mesh and facing away from it come first
+  glm::vec3 mesh_center{0.0f};
+  float mesh_area{0.0f};
+  struct Cluster
+  {
+    uint32_t first;
+    uint32_t last;
+    float key;
+  };
+  std::vector<Cluster> sorted(merged.size() - 1u);
+  std::vector<glm::vec3> centers(sorted.size());
+  std::vector<glm::vec3> normals(sorted.size());
+  for (size_t cluster = 0u; cluster < sorted.size(); ++cluster)
+  {
+    glm::vec3 center{0.0f};
+    glm::vec3 normal{0.0f};
+    float area{0.0f};
+    for (uint32_t triangle = merged[cluster]; triangle < merged[cluster + 1u]; ++triangle)
+    {
+      const auto &a = positions[ordered[triangle * 3u]];
+      const auto &b = positions[ordered[triangle * 3u + 1u]];
+      const auto &c = positions[ordered[triangle * 3u + 2u]];
+      const glm::vec3 weighted_normal = glm::cross(b - a, c - a);
+      const float triangle_area = glm::length(weighted_normal);
+      center += (a + b + c) * (triangle_area / 3.0f);
+      normal += weighted_normal;
+      area += triangle_area;
+    }
+    mesh_center += center;
+    mesh_area += area;
+    centers[cluster] = area > 0.0f ? center / area : positions[ordered[merged[cluster] * 3u]];
+    normals[cluster] = glm::length(normal) > 0.0f ? glm::normalize(normal) : normal;
+    sorted[cluster] = {merged[cluster], merged[cluster + 1u], 0.0f};
+  }
+  if (mesh_area > 0.0f)
+    mesh_center /= mesh_area;
+  for (size_t cluster = 0u; cluster < sorted.size(); ++cluster)
+    sorted[cluster].key = glm::dot(centers[cluster] - mesh_center, normals[cluster]);
+  std::stable_sort(sorted.begin(), sorted.end(), [](const auto &a, const auto &b) { return a.key > b.key; });
+
+  auto *output = indices.data();
+  for (const auto &cluster : sorted)
+    output = std::copy(ordered.begin() + cluster.first * 3u, ordered.begin() + cluster.last * 3u, output);
+}
+
+float average_cache_miss_ratio(std::span<const uint32_t> indices, size_t vertex_count, uint32_t cache_size)
+{
+  if (indices.size() < 3u)
+    return 0.0f;
+
+  // a vertex is in the FIFO cache while misses - timestamp < cache_size
+  std::vector<uint32_t> timestamps(vertex_count, 0u);
+  uint32_t misses{0u};
+  for (const auto index : indices)
+  {
+    if (timestamps[index] == 0u || misses - timestamps[index] >= cache_size)
+      timestamps[index] = ++misses;
+  }
+  return static_cast<float>(misses) / static_cast<float>(indices.size() / 3u);
+}
+
+namespace internal {
+
+size_t first_use_order(std::span<uint32_t> indices, size_t vertex_count, std::span<uint32_t> remap)
+{
+  assert(remap.size() >= vertex_count);
+  remap = remap.first(vertex_count);
+  std::fill(remap.begin(), remap.end(), no_vertex);
+  uint32_t next{0u};
+  for (auto &index : indices)
+  {
+    assert(index < vertex_count);
+    if (remap[index] == no_vertex)
+      remap[index] = next++;
+    index = remap[index];
+  }
+  const size_t used{next};
+  for (auto &position : remap)
+  {
+    if (position == no_vertex)
+      position = next++;
+  }
+  return used;
+}
+
+}    // namespace internal
+
+}    // namespace blackboard::gfx
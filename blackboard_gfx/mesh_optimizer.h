@@ -0,0 +1,50 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Index buffer orderings for faster draws of static meshes, in place. optimize_triangles runs
+// Tipsify (Sander et al. 2007): triangles are emitted by fans around vertices still in the post transform cache, then
+// the clusters of triangles it produces are sorted so the ones facing outward, usually hiding the others, come
+// first. optimize_vertex_fetch then stores the vertices in the order the indices first use them.
+//
+//   gfx::optimize_triangles(indices, positions);
+//   gfx::optimize_vertex_fetch(indices, vertices);
+
+namespace blackboard::gfx {
+
+/// @brief Reorder the triangles of a triangle list for the post transform cache, then for less overdraw.
+/// cache_size is the number of vertices the cache holds, 16 suits most GPUs
+void optimize_triangles(std::span<uint32_t> indices, std::span<const glm::vec3> positions, uint32_t cache_size = 16u);
+
+/// @brief Store the vertices in the order of their first use by indices, which are remapped.
+/// The vertices no index references are moved to the end, returns the count of used vertices
+template<typename Vertex>
+size_t optimize_vertex_fetch(std::span<uint32_t> indices, std::span<Vertex> vertices);
+
+/// @brief Post transform cache misses per triangle with a FIFO cache, between 0.5 and 3
+float average_cache_miss_ratio(std::span<const uint32_t> indices, size_t vertex_count, uint32_t cache_size = 16u);
+
+namespace internal {
+
+/// @brief New position of every vertex, used ones first by first use
+size_t first_use_order(std::span<uint32_t> indices, size_t vertex_count, std::span<uint32_t> remap);
+
+}    // namespace internal
+
+template<typename Vertex>
+size_t optimize_vertex_fetch(std::span<uint32_t> indices, std::span<Vertex> vertices)
+{
+  std::vector<uint32_t> remap(vertices.size());
+  const size_t used = internal::first_use_order(indices, vertices.size(), remap);
+  std::vector<Vertex> reordered(vertices.size());
+  for (size_t vertex = 0u; vertex < vertices.size(); ++vertex)
+    reordered[remap[vertex]] = vertices[vertex];
+  std::copy(reordered.begin(), reordered.end(), vertices.begin());
+  return used;
+}
+
+}    // namespace blackboard::gfx
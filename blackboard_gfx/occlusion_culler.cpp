@@ -0,0 +1,400 @@
+#include "occlusion_culler.h"
+
+#include "frustum_culler.h"
+#include "instanced_renderer.h"
+#include "simd.h"
+
+#include <blackboard_app/logger.h>
+#include <blackboard_app/thread_pool.h>
+
+#include <entt/entity/registry.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+
+namespace blackboard::gfx {
+
+static constexpr uint16_t tile_size{8u};
+// screen regions rasterized by a worker, multiples of the tile size
+static constexpr uint16_t bin_width{64u};
+static constexpr uint16_t bin_height{32u};
+static constexpr size_t test_chunk_size{4096u};
+// the vertices closer to the camera plane are not drawn
+static constexpr float min_w{1e-5f};
+// rounding of the interpolated depth, a flat occluder must not hide its own box
+static constexpr float depth_bias{1e-5f};
+
+static uint16_t round_up(uint16_t size, uint16_t multiple)
+{
+  return static_cast<uint16_t>(std::max<uint32_t>((size + multiple - 1u) / multiple * multiple, multiple));
+}
+
+Occlusion_culler::Occlusion_culler(uint16_t width, uint16_t height)
+: m_width{round_up(width, tile_size)},
+  m_height{round_up(height, tile_size)},
+  m_bins_x{static_cast<uint16_t>((m_width + bin_width - 1u) / bin_width)},
+  m_bins_y{static_cast<uint16_t>((m_height + bin_height - 1u) / bin_height)}
+{
+  m_depth.resize(static_cast<size_t>(m_width) * m_height);
+  m_bins.resize(static_cast<size_t>(m_bins_x) * m_bins_y);
+
+  uint16_t level_width = m_width / tile_size;
+  uint16_t level_height = m_height / tile_size;
+  while (true)
+  {
+    m_levels.push_back(
+      {level_width, level_height, std::vector<float>(static_cast<size_t>(level_width) * level_height)});
+    if (level_width == 1u && level_height == 1u)
+      break;
+    level_width = static_cast<uint16_t>((level_width + 1u) / 2u);
+    level_height = static_cast<uint16_t>((level_height + 1u) / 2u);
+  }
+}
+
+uint16_t Occlusion_culler::add_mesh(Occluder_mesh mesh)
+{
+  if (mesh.indices.size() % 3u != 0u ||
+      std::any_of(mesh.indices.begin(), mesh.indices.end(),
+                  [&mesh](uint32_t index) { return index >= mesh.positions.size(); }))
+  {
+    BB_LOG_ERROR("Occluder mesh with invalid indices, it will not hide anything");
+    mesh.indices.clear();
+  }
+  m_meshes.push_back(std::move(mesh));
+  return static_cast<uint16_t>(m_meshes.size() - 1u);
+}
+
+void Occlusion_culler::setup(const Occluder_mesh &mesh, const glm::mat4 &transform,
+                             std::vector<Triangle> &triangles) const
+{
+  std::vector<glm::vec4> clip(mesh.positions.size());
+  for (size_t i = 0u; i < clip.size(); ++i)
+    clip[i] = transform * glm::vec4{mesh.positions[i], 1.0f};
+
+  using namespace simd;
+  const float4 half_width = splat(m_width * 0.5f);
+  const float4 half_height = splat(m_height * 0.5f);
+  const size_t triangle_count = mesh.indices.size() / 3u;
+  for (size_t first = 0u; first < triangle_count; first += 4u)
+  {
+    // four triangles in lanes, the last one is repeated when there are less
+    const size_t lanes = std::min<size_t>(4u, triangle_count - first);
+    float x[3][4];
+    float y[3][4];
+    float z[3][4];
+    float w[3][4];
+    for (size_t lane = 0u; lane < 4u; ++lane)
+    {
+      const size_t triangle = first + std::min(lane, lanes - 1u);
+      for (size_t vertex = 0u; vertex < 3u; ++vertex)
+      {
+        const auto &position = clip[mesh.indices[triangle * 3u + vertex]];
+        x[vertex][lane] = position.x;
+        y[vertex][lane] = position.y;
+        z[vertex][lane] = position.z;
+        w[vertex][lane] = position.w;
+      }
+    }
+
+    float4 screen_x[3];
+    float4 screen_y[3];
+    float4 depth[3];
+    for (int vertex = 0; vertex < 3; ++vertex)
+    {
+      // the rows go down the screen
+      const float4 inverse_w = splat(1.0f) / max(load(w[vertex]), splat(min_w));
+      screen_x[vertex] = half_width + load(x[vertex]) * inverse_w * half_width;
+      screen_y[vertex] = half_height - load(y[vertex]) * inverse_w * half_height;
+      depth[vertex] = load(z[vertex]) * inverse_w;
+    }
+
+    // edge i is opposite to vertex i, it is the area of the triangle at that vertex
+    float4 a[3];
+    float4 b[3];
+    float4 c[3];
+    for (int edge = 0; edge < 3; ++edge)
+    {
+      const int from = (edge + 1) % 3;
+      const int to = (edge + 2) % 3;
+      a[edge] = screen_y[from] - screen_y[to];
+      b[edge] = screen_x[to] - screen_x[from];
+      c[edge] = screen_x[from] * screen_y[to] - screen_x[to] * screen_y[from];
+    }
+    const float4 area = a[0] * screen_x[0] + b[0] * screen_y[0] + c[0];
+
+    // depth interpolated with the barycentric coordinates
+    const float4 inverse_area = splat(1.0f) / area;
+    const float4 depth_a = (a[0] * depth[0] + a[1] * depth[1] + a[2] * depth[2]) * inverse_area;
+    const float4 depth_b = (b[0] * depth[0] + b[1] * depth[1] + b[2] * depth[2]) * inverse_area;
+    const float4 depth_c = (c[0] * depth[0] + c[1] * depth[1] + c[2] * depth[2]) * inverse_area;
+
+    float edges[3][3][4];
+    float planes[3][4];
+    float areas[4];
+    float bounds[4][4];
+    for (int edge = 0; edge < 3; ++edge)
+    {
+      store(edges[edge][0], a[edge]);
+      store(edges[edge][1], b[edge]);
+      store(edges[edge][2], c[edge]);
+    }
+    store(planes[0], depth_a);
+    store(planes[1], depth_b);
+    store(planes[2], depth_c);
+    store(areas, area);
+    store(bounds[0], min(min(screen_x[0], screen_x[1]), screen_x[2]));
+    store(bounds[1], min(min(screen_y[0], screen_y[1]), screen_y[2]));
+    store(bounds[2], max(max(screen_x[0], screen_x[1]), screen_x[2]));
+    store(bounds[3], max(max(screen_y[0], screen_y[1]), screen_y[2]));
+
+    for (size_t lane = 0u; lane < lanes; ++lane)
+    {
+      if (w[0][lane] <= min_w || w[1][lane] <= min_w || w[2][lane] <= min_w || std::abs(areas[lane]) < 1e-4f)
+        continue;
+      const float min_x = std::max(std::floor(bounds[0][lane]), 0.0f);
+      const float min_y = std::max(std::floor(bounds[1][lane]), 0.0f);
+      const float max_x = std::min(std::ceil(bounds[2][lane]), static_cast<float>(m_width));
+      const float max_y = std::min(std::ceil(bounds[3][lane]), static_cast<float>(m_height));
+      if (min_x >= max_x || min_y >= max_y)
+        continue;
+
+      // either winding, the edges are made positive inside
+      Triangle triangle;
+      const float sign = areas[lane] > 0.0f ? 1.0f : -1.0f;
+      for (int edge = 0; edge < 3; ++edge)
+      {
+        for (int coefficient = 0; coefficient < 3; ++coefficient)
+          triangle.edges[edge][coefficient] = edges[edge][coefficient][lane] * sign;
+      }
+      for (int coefficient = 0; coefficient < 3; ++coefficient)
+        triangle.depth[coefficient] = planes[coefficient][lane];
+      triangle.min_x = static_cast<uint16_t>(min_x);
+      triangle.min_y = static_cast<uint16_t>(min_y);
+      triangle.max_x = static_cast<uint16_t>(max_x);
+      triangle.max_y = static_cast<uint16_t>(max_y);
+      triangles.push_back(triangle);
+    }
+  }
+}
+
+void Occlusion_culler::rasterize(const Triangle &triangle, uint16_t bin_x, uint16_t bin_y)
+{
+  using namespace simd;
+  // the bins start on multiples of 4 pixels, the pixels of a group past the triangle fail the edge tests
+  const auto begin_x = static_cast<uint16_t>(std::max<uint16_t>(triangle.min_x, bin_x * bin_width) & ~3u);
+  const uint16_t end_x = std::min<uint16_t>(triangle.max_x, std::min<uint16_t>((bin_x + 1u) * bin_width, m_width));
+  const uint16_t begin_y = std::max<uint16_t>(triangle.min_y, bin_y * bin_height);
+  const uint16_t end_y = std::min<uint16_t>(triangle.max_y, std::min<uint16_t>((bin_y + 1u) * bin_height, m_height));
+
+  const float4 zero = splat(0.0f);
+  const float4 centers = make(0.5f, 1.5f, 2.5f, 3.5f);
+  const float4 a0 = splat(triangle.edges[0][0]);
+  const float4 a1 = splat(triangle.edges[1][0]);
+  const float4 a2 = splat(triangle.edges[2][0]);
+  const float4 depth_a = splat(triangle.depth[0]);
+  for (uint16_t y = begin_y; y < end_y; ++y)
+  {
+    const float center_y = y + 0.5f;
+    const float4 row0 = splat(triangle.edges[0][1] * center_y + triangle.edges[0][2]);
+    const float4 row1 = splat(triangle.edges[1][1] * center_y + triangle.edges[1][2]);
+    const float4 row2 = splat(triangle.edges[2][1] * center_y + triangle.edges[2][2]);
+    const float4 row_depth = splat(triangle.depth[1] * center_y + triangle.depth[2]);
+    float *pixels = m_depth.data() + static_cast<size_t>(y) * m_width;
+    for (uint16_t x = begin_x; x < end_x; x += 4u)
+    {
+      const float4 center_x = splat(x) + centers;
+      const mask4 inside =
+        (zero <= a0 * center_x + row0) & (zero <= a1 * center_x + row1) & (zero <= a2 * center_x + row2);
+      if (bits(inside) == 0u)
+        continue;
+      const float4 depth = depth_a * center_x + row_depth;
+      const float4 nearest = load(pixels + x);
+      store(pixels + x, select(inside, min(nearest, depth), nearest));
+    }
+  }
+}
+
+void Occlusion_culler::build_levels()
+{
+  auto &tiles = m_levels[0];
+  for (uint16_t tile_y = 0u; tile_y < tiles.height; ++tile_y)
+  {
+    for (uint16_t tile_x = 0u; tile_x < tiles.width; ++tile_x)
+    {
+      const float *pixels = m_depth.data() + static_cast<size_t>(tile_y) * tile_size * m_width + tile_x * tile_size;
+      simd::float4 farthest = simd::load(pixels);
+      for (uint16_t row = 0u; row < tile_size; ++row, pixels += m_width)
+        farthest = simd::max(farthest, simd::max(simd::load(pixels), simd::load(pixels + 4)));
+      float lanes[4];
+      simd::store(lanes, farthest);
+      tiles.depth[static_cast<size_t>(tile_y) * tiles.width + tile_x] =
+        std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+    }
+  }
+
+  for (size_t index = 1u; index < m_levels.size(); ++index)
+  {
+    const auto &below = m_levels[index - 1u];
+    auto &level = m_levels[index];
+    for (uint16_t y = 0u; y < level.height; ++y)
+    {
+      const uint16_t y0 = y * 2u;
+      const uint16_t y1 = std::min<uint16_t>(y0 + 1u, below.height - 1u);
+      for (uint16_t x = 0u; x < level.width; ++x)
+      {
+        const uint16_t x0 = x * 2u;
+        const uint16_t x1 = std::min<uint16_t>(x0 + 1u, below.width - 1u);
+        level.depth[static_cast<size_t>(y) * level.width + x] =
+          std::max(std::max(below.depth[y0 * below.width + x0], below.depth[y0 * below.width + x1]),
+                   std::max(below.depth[y1 * below.width + x0], below.depth[y1 * below.width + x1]));
+      }
+    }
+  }
+}
+
+bool Occlusion_culler::occluded(const glm::mat4 &transform, const glm::vec3 &min, const glm::vec3 &max) const
+{
+  float min_x{FLT_MAX};
+  float min_y{FLT_MAX};
+  float max_x{-FLT_MAX};
+  float max_y{-FLT_MAX};
+  float nearest{FLT_MAX};
+  for (int corner = 0; corner < 8; ++corner)
+  {
+    const glm::vec4 position = transform * glm::vec4{corner & 1 ? max.x : min.x, corner & 2 ? max.y : min.y,
+                                                     corner & 4 ? max.z : min.z, 1.0f};
+    // boxes reaching behind the camera are kept
+    if (position.w <= min_w)
+      return false;
+    const float x = (position.x / position.w * 0.5f + 0.5f) * m_width;
+    const float y = (0.5f - position.y / position.w * 0.5f) * m_height;
+    min_x = std::min(min_x, x);
+    min_y = std::min(min_y, y);
+    max_x = std::max(max_x, x);
+    max_y = std::max(max_y, y);
+    nearest = std::min(nearest, position.z / position.w);
+  }
+
+  const auto begin_x = static_cast<int32_t>(std::max(std::floor(min_x), 0.0f));
+  const auto begin_y = static_cast<int32_t>(std::max(std::floor(min_y), 0.0f));
+  const auto end_x = static_cast<int32_t>(std::min(std::ceil(max_x), static_cast<float>(m_width)));
+  const auto end_y = static_cast<int32_t>(std::min(std::ceil(max_y), static_cast<float>(m_height)));
+  if (begin_x >= end_x || begin_y >= end_y)
+    return false;
+
+  // the level where the rectangle covers at most 4 texels per side
+  size_t index{0u};
+  int32_t texel_x0 = begin_x / tile_size;
+  int32_t texel_y0 = begin_y / tile_size;
+  int32_t texel_x1 = (end_x - 1) / tile_size;
+  int32_t texel_y1 = (end_y - 1) / tile_size;
+  while ((texel_x1 - texel_x0 >= 4 || texel_y1 - texel_y0 >= 4) && index + 1u < m_levels.size())
+  {
+    ++index;
+    texel_x0 /= 2;
+    texel_y0 /= 2;
+    texel_x1 /= 2;
+    texel_y1 /= 2;
+  }
+
+  const auto &level = m_levels[index];
+  for (int32_t y = texel_y0; y <= texel_y1; ++y)
+  {
+    for (int32_t x = texel_x0; x <= texel_x1; ++x)
+    {
+      if (level.depth[static_cast<size_t>(y) * level.width + x] + depth_bias >= nearest)
+        return false;
+    }
+  }
+  return true;
+}
+
+std::span<const entt::entity> Occlusion_culler::cull(const entt::registry &registry, const glm::mat4 &view_projection,
+                                                     std::span<const entt::entity> entities)
+{
+  auto start = std::chrono::steady_clock::now();
+  m_stats = {};
+  const auto &transforms = registry.storage<Transform>();
+  const auto &occluders = registry.storage<Occluder>();
+  const auto &bounds = registry.storage<Bounds>();
+
+  struct Draw
+  {
+    const Occluder_mesh *mesh;
+    glm::mat4 transform;
+  };
+  std::vector<Draw> draws;
+  for (const auto entity : entities)
+  {
+    if (!occluders.contains(entity) || !transforms.contains(entity))
+      continue;
+    const auto mesh = occluders.get(entity).mesh;
+    if (mesh < m_meshes.size())
+      draws.push_back({&m_meshes[mesh], view_projection * transforms.get(entity).world});
+  }
+  m_stats.occluders = static_cast<uint32_t>(draws.size());
+
+  m_occluder_triangles.resize(draws.size());
+  app::parallel_for(draws.size(), [&](size_t index) {
+    m_occluder_triangles[index].clear();
+    setup(*draws[index].mesh, draws[index].transform, m_occluder_triangles[index]);
+  });
+
+  for (auto &bin : m_bins)
+    bin.clear();
+  for (const auto &triangles : m_occluder_triangles)
+  {
+    for (const auto &triangle : triangles)
+    {
+      for (uint16_t bin_y = triangle.min_y / bin_height; bin_y <= (triangle.max_y - 1u) / bin_height; ++bin_y)
+      {
+        for (uint16_t bin_x = triangle.min_x / bin_width; bin_x <= (triangle.max_x - 1u) / bin_width; ++bin_x)
+          m_bins[static_cast<size_t>(bin_y) * m_bins_x + bin_x].push_back(&triangle);
+      }
+    }
+    m_stats.triangles += static_cast<uint32_t>(triangles.size());
+  }
+
+  std::fill(m_depth.begin(), m_depth.end(), FLT_MAX);
+  app::parallel_for(m_bins.size(), [this](size_t bin) {
+    const auto bin_x = static_cast<uint16_t>(bin % m_bins_x);
+    const auto bin_y = static_cast<uint16_t>(bin / m_bins_x);
+    for (const auto *triangle : m_bins[bin])
+      rasterize(*triangle, bin_x, bin_y);
+  });
+  build_levels();
+  m_stats.raster_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+  start = std::chrono::steady_clock::now();
+  m_hidden.assign(entities.size(), 0u);
+  std::vector<uint32_t> chunk_tested((entities.size() + test_chunk_size - 1u) / test_chunk_size, 0u);
+  app::parallel_for(chunk_tested.size(), [&](size_t chunk) {
+    const size_t end = std::min(entities.size(), (chunk + 1u) * test_chunk_size);
+    for (size_t i = chunk * test_chunk_size; i < end; ++i)
+    {
+      const auto entity = entities[i];
+      if (!bounds.contains(entity) || !transforms.contains(entity))
+        continue;
+      const auto &box = bounds.get(entity);
+      m_hidden[i] = occluded(view_projection * transforms.get(entity).world, box.min, box.max);
+      ++chunk_tested[chunk];
+    }
+  });
+
+  m_visible.clear();
+  for (size_t i = 0u; i < entities.size(); ++i)
+  {
+    if (m_hidden[i])
+      ++m_stats.occluded;
+    else
+      m_visible.push_back(entities[i]);
+  }
+  for (const auto tested : chunk_tested)
+    m_stats.tested += tested;
+  m_stats.test_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+  return m_visible;
+}
+
+}    // namespace blackboard::gfx
@@ -0,0 +1,101 @@
+#pragma once
+#include <entt/entity/fwd.hpp>
+#include <glm/glm.hpp>
+
+#include <span>
+#include <vector>
+
+// Hides the entities behind the occluders with a depth buffer rendered on the CPU, no GPU query involved. The
+// entities having an Occluder among the ones given to cull() are drawn into a small depth buffer: the triangles are
+// set up four at a time, binned into screen regions and the regions are rasterized on the workers. A max depth
+// pyramid is built from it, then the screen rectangle of every world box is compared with the pyramid level where it
+// covers a few texels. Occluders are usually simplified versions of the large meshes, walls and floors, and only
+// their triangles fully in front of the camera are drawn.
+//
+//   gfx::Occlusion_culler occlusion;
+//   const auto wall = occlusion.add_mesh({wall_positions, wall_indices});
+//   registry.emplace<gfx::Occluder>(entity, wall);
+//   const auto visible = occlusion.cull(registry, view_projection, frustum.cull(view_projection));
+//   renderer.submit(view_id, registry, visible);
+
+namespace blackboard::gfx {
+
+/// @brief CPU copy of a mesh drawn into the occlusion depth buffer
+struct Occluder_mesh
+{
+  std::vector<glm::vec3> positions;
+  std::vector<uint32_t> indices;
+};
+
+struct Occluder
+{
+  uint16_t mesh{0u};
+};
+
+class Occlusion_culler
+{
+  public:
+  struct Stats
+  {
+    uint32_t occluders{0u};
+    uint32_t triangles{0u};    // drawn after the setup rejected the degenerate and clipped ones
+    uint32_t tested{0u};
+    uint32_t occluded{0u};
+    float raster_ms{0.0f};
+    float test_ms{0.0f};
+  };
+
+  /// @brief The depth buffer size is rounded up to multiples of 8
+  explicit Occlusion_culler(uint16_t width = 320u, uint16_t height = 192u);
+
+  uint16_t add_mesh(Occluder_mesh mesh);
+
+  /// @brief Draw the occluders among entities, then return the entities whose Bounds are not hidden by them.
+  /// The entities without Bounds and Transform are kept, the result is valid until the next call
+  std::span<const entt::entity> cull(const entt::registry &registry, const glm::mat4 &view_projection,
+                                     std::span<const entt::entity> entities);
+
+  const Stats &stats() const
+  {
+    return m_stats;
+  }
+
+  private:
+  // edge functions are positive inside, the depth is a plane in screen space
+  struct Triangle
+  {
+    float edges[3][3];
+    float depth[3];
+    uint16_t min_x;
+    uint16_t min_y;
+    uint16_t max_x;    // exclusive
+    uint16_t max_y;
+  };
+
+  struct Level
+  {
+    uint16_t width;
+    uint16_t height;
+    std::vector<float> depth;    // farthest depth of the texels below
+  };
+
+  void setup(const Occluder_mesh &mesh, const glm::mat4 &transform, std::vector<Triangle> &triangles) const;
+  void rasterize(const Triangle &triangle, uint16_t bin_x, uint16_t bin_y);
+  void build_levels();
+  bool occluded(const glm::mat4 &transform, const glm::vec3 &min, const glm::vec3 &max) const;
+
+  uint16_t m_width;
+  uint16_t m_height;
+  uint16_t m_bins_x;
+  uint16_t m_bins_y;
+  std::vector<Occluder_mesh> m_meshes;
+  std::vector<float> m_depth;                             // nearest depth of every pixel
+  std::vector<Level> m_levels;                            // 8x8 pixels first, then halved down to one texel
+  std::vector<std::vector<Triangle>> m_occluder_triangles;
+  std::vector<std::vector<const Triangle *>> m_bins;
+  std::vector<uint8_t> m_hidden;
+  std::vector<entt::entity> m_visible;
+  Stats m_stats;
+};
+
+}    // namespace blackboard::gfx
@@ -1,5 +1,8 @@
 #include "program.h"
 
+#include "shader_pack.h"
+
+#include <blackboard_app/vfs.h>
 #include <blackboard_app/resources.h>
 #include <blackboard_app/logger.h>
 
@@ -17,11 +20,13 @@ constexpr auto shader_bin_extension = ".bin";
 constexpr auto shader_platform_flags = " --platform osx";
 constexpr auto shader_fragment_program_flags = " -p metal";
 constexpr auto shader_vertex_program_flags = " -p metal";
+constexpr auto shader_compute_program_flags = " -p metal";
 constexpr auto shaderc_binary = "tools/shaderc/shaderc";
 #elif _WIN32
 constexpr auto shader_platform_flags = " --platform windows";
 constexpr auto shader_fragment_program_flags = " -p ps_5_0";
 constexpr auto shader_vertex_program_flags = " -p vs_5_0";
+constexpr auto shader_compute_program_flags = " -p cs_5_0";
 constexpr auto shaderc_binary = "tools/shaderc/shaderc.exe";
 #endif
 
@@ -35,12 +40,11 @@ bgfx::ShaderHandle load_program(const std::filesystem::path &file_path)
 {
     if (std::filesystem::exists(file_path))
     {
-        std::ifstream file(file_path, std::ios::ate | std::ios::binary);
-        std::streampos file_size = file.tellg();
-        const bgfx::Memory *mem = bgfx::alloc(static_cast<uint32_t>(file_size) + 1);
-        file.seekg(0, std::ios::beg);
-        file.read(reinterpret_cast<char *>(mem->data), file_size);
-        file.close();
+        const auto *mem = blackboard::app::vfs::make_ref(blackboard::app::vfs::open(file_path));
+        if (!mem)
+        {
+            return {bgfx::kInvalidHandle};
+        }
         auto handle = bgfx::createShader(mem);
         if (isValid(handle))
         {
@@ -51,34 +55,71 @@ bgfx::ShaderHandle load_program(const std::filesystem::path &file_path)
     return {bgfx::kInvalidHandle};
 }
 
-int compile_program(const std::filesystem::path &file_path,
-                  blackboard::gfx::Program::Type type)
+std::string shaderc_flags(blackboard::gfx::Program::Type type)
 {
-    std::string cmd =
-      blackboard::app::resources::path().append(shaderc_binary).string();    // shaderc binary
-    cmd.append(" -f " + file_path.string());    // input file
-    cmd.append(" -o " + file_path.string() + shader_bin_extension);    // output file
-    cmd.append(
-      " -i " +
-      blackboard::app::resources::path().append("shaders/common").string());    // include path
-    cmd.append(blackboard::gfx::Program::TypeFlag[type]);    // shader type
-    cmd.append(shader_platform_flags);    // platform flags
+    std::string flags{shader_platform_flags};
     switch (type)
     {
-      case blackboard::gfx::Program::VERTEX:
-            cmd.append(shader_vertex_program_flags);    // platform flags
+        case blackboard::gfx::Program::VERTEX:
+            flags.append(shader_vertex_program_flags);
             break;
         case blackboard::gfx::Program::FRAGMENT:
-            cmd.append(shader_fragment_program_flags);    // platform flags
+            flags.append(shader_fragment_program_flags);
+            break;
+        case blackboard::gfx::Program::COMPUTE:
+            flags.append(shader_compute_program_flags);
             break;
         default:
             assert("Program type not implemented");
             break;
     }
+    return flags;
+}
+
+int compile_program(const std::filesystem::path &file_path,
+                  blackboard::gfx::Program::Type type, const std::string &defines = {},
+                  const std::filesystem::path &output_path = {})
+{
+    std::string cmd =
+      blackboard::app::resources::path().append(shaderc_binary).string();    // shaderc binary
+    cmd.append(" -f " + file_path.string());    // input file
+    if (output_path.empty())
+    {
+        cmd.append(" -o " + file_path.string() + shader_bin_extension);    // output file
+    }
+    else
+    {
+        cmd.append(" -o " + output_path.string());    // output file
+    }
+    if (!defines.empty())
+    {
+        cmd.append(" --define \"" + defines + "\"");    // defines separated by ';'
+    }
+    cmd.append(
+      " -i " +
+      blackboard::app::resources::path().append("shaders/common").string());    // include path
+    cmd.append(blackboard::gfx::Program::TypeFlag[type]);    // shader type
+    cmd.append(shaderc_flags(type));    // platform flags
   cmd.append(" > " + blackboard::app::resources::path().append(shaderc_binary).parent_path().string() + "/temp_output.txt");
     return system(cmd.c_str());
 }
 
+bgfx::ShaderHandle load_program(const blackboard::gfx::Shader_pack &pack, std::string_view name)
+{
+    const auto *mem = blackboard::gfx::find_shader(pack, name);
+    if (!mem)
+    {
+        blackboard::app::logger::logger->error("Shader not found in the shader pack: {}", name);
+        return {bgfx::kInvalidHandle};
+    }
+    auto handle = bgfx::createShader(mem);
+    if (isValid(handle))
+    {
+        bgfx::setName(handle, name.data(), static_cast<int32_t>(name.size()));
+    }
+    return handle;
+}
+
 void log_compilation_error(const std::filesystem::path &shader_file_path)
 {
     std::ifstream temp_file(blackboard::app::resources::path().append(shaderc_binary).parent_path().string() + "/temp_output.txt", std::ios::binary | std::ios::in);
@@ -103,6 +144,8 @@ Program::~Program()
     bgfx::destroy(vertex_shader_handel);
   if (bgfx::isValid(fragment_shader_handel))
     bgfx::destroy(fragment_shader_handel);
+  if (bgfx::isValid(compute_shader_handel))
+    bgfx::destroy(compute_shader_handel);
 }
 
 bool init(Program& prog, const std::filesystem::path &vsh_path, const std::filesystem::path &fsh_path)
@@ -148,4 +191,116 @@ bool init(Program& prog, const std::filesystem::path &vsh_path, const std::files
     return false;
 }
 
+bool init(Program& prog, const Shader_pack &pack, std::string_view vsh_name, std::string_view fsh_name)
+{
+    using namespace internal;
+    const auto vsh = load_program(pack, vsh_name);
+    if (!bgfx::isValid(vsh))
+    {
+        return false;
+    }
+    const auto fsh = load_program(pack, fsh_name);
+    if (!bgfx::isValid(fsh))
+    {
+        bgfx::destroy(vsh);
+        return false;
+    }
+
+    const auto prog_handle = bgfx::createProgram(vsh, fsh, false);
+    if(bgfx::isValid(prog_handle))
+    {
+      prog = {};
+      prog.program_handle = prog_handle;
+      prog.vertex_shader_handel = vsh;
+      prog.fragment_shader_handel = fsh;
+
+      return true;
+    }
+
+    bgfx::destroy(vsh);
+    bgfx::destroy(fsh);
+    return false;
+}
+
+bool init(Program& prog, const std::filesystem::path &csh_path)
+{
+    using namespace internal;
+    const auto comp_error_code = compile_program(csh_path, Program::Type::COMPUTE);
+    if (comp_error_code != 0)
+    {
+        log_compilation_error(csh_path);
+        return false;
+    }
+
+    const auto csh = load_program(csh_path.string() + shader_bin_extension);
+    if (!bgfx::isValid(csh))
+    {
+        app::logger::logger->error("Error loading program: {}", csh_path.string() + shader_bin_extension);
+        return false;
+    }
+
+    const auto prog_handle = bgfx::createProgram(csh, false);
+    if(bgfx::isValid(prog_handle))
+    {
+      prog = {};
+      prog.program_handle = prog_handle;
+      prog.compute_shader_handel = csh;
+
+      return true;
+    }
+
+    bgfx::destroy(csh);
+    return false;
+}
+
+bool init(Program& prog, const Shader_pack &pack, std::string_view csh_name)
+{
+    using namespace internal;
+    const auto csh = load_program(pack, csh_name);
+    if (!bgfx::isValid(csh))
+    {
+        return false;
+    }
+
+    const auto prog_handle = bgfx::createProgram(csh, false);
+    if(bgfx::isValid(prog_handle))
+    {
+      prog = {};
+      prog.program_handle = prog_handle;
+      prog.compute_shader_handel = csh;
+
+      return true;
+    }
+
+    bgfx::destroy(csh);
+    return false;
+}
+
+bool compile_shader(const std::filesystem::path &source_path, const std::filesystem::path &binary_path,
+                    Program::Type type, const std::string &defines)
+{
+    using namespace internal;
+    if (compile_program(source_path, type, defines, binary_path) != 0)
+    {
+        log_compilation_error(source_path);
+        return false;
+    }
+    return true;
+}
+
+std::string shaderc_profile(Program::Type type)
+{
+    return internal::shaderc_flags(type);
+}
+
+bgfx::ShaderHandle load_shader(const std::filesystem::path &binary_path)
+{
+    return internal::load_program(binary_path);
+}
+
+bgfx::ShaderHandle load_shader(const Shader_pack &pack, std::string_view name)
+{
+    return internal::load_program(pack, name);
+}
+
 }    // namespace blackboard::gfx
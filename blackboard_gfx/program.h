@@ -4,9 +4,12 @@
 #include <filesystem>
 #include <array>
 #include <string>
+#include <string_view>
 
 namespace blackboard::gfx {
 
+struct Shader_pack;
+
 struct Program
 {
   enum Type : uint8_t
@@ -26,6 +29,29 @@ struct Program
   bgfx::ProgramHandle program_handle{bgfx::kInvalidHandle};
 };
 
+/// @brief Compile the shaders at runtime with shaderc, needs BLACKBOARD_RUNTIME_SHADERC
 bool init(Program& program, const std::filesystem::path &vshPath, const std::filesystem::path &fshPath);
 
+/// @brief Create the program from shaders cooked at build time, e.g. init(program, pack, "vs_cubes", "fs_cubes")
+bool init(Program& program, const Shader_pack &pack, std::string_view vsh_name, std::string_view fsh_name);
+
+/// @brief Compute program compiled at runtime with shaderc, needs BLACKBOARD_RUNTIME_SHADERC
+bool init(Program& program, const std::filesystem::path &cshPath);
+
+/// @brief Compute program from a shader cooked at build time, e.g. init(program, pack, "cs_transforms")
+bool init(Program& program, const Shader_pack &pack, std::string_view csh_name);
+
+/// @brief Compile a single shader at runtime with shaderc, defines are separated by ';'.
+/// Needs BLACKBOARD_RUNTIME_SHADERC
+bool compile_shader(const std::filesystem::path &source_path, const std::filesystem::path &binary_path,
+                    Program::Type type, const std::string &defines = {});
+
+/// @brief shaderc platform and profile flags compile_shader uses for the stage
+std::string shaderc_profile(Program::Type type);
+
+bgfx::ShaderHandle load_shader(const std::filesystem::path &binary_path);
+
+/// @brief Shader of the current renderer from the pack, the name does not include the profile folder
+bgfx::ShaderHandle load_shader(const Shader_pack &pack, std::string_view name);
+
 }    // namespace blackboard::core::renderer
@@ -0,0 +1,66 @@
+#include "shader_pack.h"
+
+#include <blackboard_app/logger.h>
+#include <blackboard_app/pack.h>
+
+#include <string>
+
+namespace blackboard::gfx {
+
+bool init(Shader_pack &pack, std::string_view name)
+{
+  pack.file = app::vfs::open(name);
+  if (!pack.file.is_open())
+  {
+    app::logger::logger->error("Error opening shader pack: {}", name);
+    return false;
+  }
+
+  if (!app::pack::header(pack.file.span()))
+  {
+    app::logger::logger->error("Invalid shader pack: {}", name);
+    pack.file = {};
+    return false;
+  }
+  return true;
+}
+
+const char *shader_profile_name(bgfx::RendererType::Enum type)
+{
+  switch (type)
+  {
+    case bgfx::RendererType::Direct3D11:
+    case bgfx::RendererType::Direct3D12:
+      return "dx11";
+    case bgfx::RendererType::Metal:
+      return "metal";
+    case bgfx::RendererType::OpenGL:
+      return "glsl";
+    case bgfx::RendererType::OpenGLES:
+      return "essl";
+    case bgfx::RendererType::Vulkan:
+      return "spirv";
+    default:
+      return nullptr;
+  }
+}
+
+const bgfx::Memory *find_shader(const Shader_pack &pack, std::string_view name)
+{
+  const char *profile = shader_profile_name(bgfx::getRendererType());
+  if (!profile || !pack.file.is_open())
+    return nullptr;
+
+  std::string entry_name{profile};
+  entry_name.append("/").append(name);
+
+  const auto file = pack.file.span();
+  const auto *entry = app::pack::find(file, entry_name);
+  if (!entry)
+    return nullptr;
+
+  const auto data = app::pack::data(file, *entry);
+  return bgfx::makeRef(data.data(), static_cast<uint32_t>(data.size()));
+}
+
+}    // namespace blackboard::gfx
@@ -0,0 +1,28 @@
+#pragma once
+#include <bgfx/bgfx.h>
+#include <blackboard_app/vfs.h>
+
+#include <string_view>
+
+namespace blackboard::gfx {
+
+/// @brief Shaders cooked at build time by cook_shaders (cmake/shaders.cmake).
+/// The file is read through the vfs and stays alive with the pack, shaders are handed to bgfx without copies
+/// so the pack must outlive every frame that creates shaders from it.
+struct Shader_pack
+{
+  app::vfs::File file;
+};
+
+/// @brief Name of the pack inside the vfs, cook_shaders copies it to Resources/assets/shaders.pack
+inline constexpr std::string_view default_shader_pack_name{"assets/shaders.pack"};
+
+bool init(Shader_pack &pack, std::string_view name = default_shader_pack_name);
+
+/// @brief Folder of the pack entries for a renderer type, nullptr if shaders can not be cooked for it
+const char *shader_profile_name(bgfx::RendererType::Enum type);
+
+/// @brief Reference to the binary of the shader for the current renderer, nullptr if it is not in the pack
+const bgfx::Memory *find_shader(const Shader_pack &pack, std::string_view name);
+
+}    // namespace blackboard::gfx
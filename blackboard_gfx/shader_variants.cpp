@@ -0,0 +1,218 @@
+#include "shader_variants.h"
+
+#include "shader_pack.h"
+
+#include <blackboard_app/logger.h>
+#include <blackboard_app/pack.h>
+
+#include <bit>
+#include <cassert>
+#include <system_error>
+
+namespace internal {
+
+std::string key_suffix(blackboard::gfx::Variant_key stage_key)
+{
+  return fmt::format("{:x}", stage_key);
+}
+
+// the key bits alone do not identify a binary once options are renamed, added or reordered
+std::string binary_suffix(blackboard::gfx::Variant_key stage_key, const std::string &defines,
+                          blackboard::gfx::Program::Type stage)
+{
+  const auto hash = blackboard::app::pack::hash(defines + "|" + blackboard::gfx::shaderc_profile(stage));
+  return fmt::format(".{}.{:016x}.bin", key_suffix(stage_key), hash);
+}
+
+bool is_up_to_date(const std::filesystem::path &binary_path, const std::filesystem::path &source_path)
+{
+  std::error_code error;
+  const auto binary_time = std::filesystem::last_write_time(binary_path, error);
+  if (error)
+    return false;
+  const auto source_time = std::filesystem::last_write_time(source_path, error);
+  return !error && binary_time >= source_time;
+}
+
+}    // namespace internal
+
+namespace blackboard::gfx {
+
+Shader_variants::Shader_variants(std::filesystem::path vsh_path, std::filesystem::path fsh_path)
+: m_paths{std::move(vsh_path), std::move(fsh_path)}
+{
+  m_names = {m_paths[Program::VERTEX].stem().string(), m_paths[Program::FRAGMENT].stem().string()};
+}
+
+Shader_variants::Shader_variants(const Shader_pack &pack, std::string vsh_name, std::string fsh_name)
+: m_names{std::move(vsh_name), std::move(fsh_name)}, m_pack{&pack}
+{}
+
+Shader_variants::~Shader_variants()
+{
+  // programs do not own the shared shaders
+  m_programs.clear();
+  for (auto &shaders : m_shaders)
+  {
+    for (auto &[key, handle] : shaders)
+    {
+      if (bgfx::isValid(handle))
+        bgfx::destroy(handle);
+    }
+  }
+}
+
+uint8_t Shader_variants::add_option(std::string define, uint8_t stages)
+{
+  assert(m_used_bits < 32u && "Variant_key is full");
+  m_options.push_back({.defines = {std::move(define)}, .shift = m_used_bits, .bits = 1u, .stages = stages});
+  m_used_bits += 1u;
+  return static_cast<uint8_t>(m_options.size() - 1u);
+}
+
+uint8_t Shader_variants::add_option(std::vector<std::string> defines, uint8_t stages)
+{
+  assert(defines.size() > 1u && "enum options need at least two values");
+  const auto bits = static_cast<uint8_t>(std::bit_width(defines.size() - 1u));
+  assert(m_used_bits + bits <= 32u && "Variant_key is full");
+  m_options.push_back({.defines = std::move(defines), .shift = m_used_bits, .bits = bits, .stages = stages});
+  m_used_bits += bits;
+  return static_cast<uint8_t>(m_options.size() - 1u);
+}
+
+Variant_key Shader_variants::set(Variant_key key, uint8_t option, uint32_t value) const
+{
+  const auto &opt = m_options[option];
+  if (value >= value_count(opt))
+  {
+    assert(false && "option value out of range");
+    app::logger::logger->error("Value {} out of range for the option {} of {}/{}", value, opt.defines.front(),
+                               m_names[Program::VERTEX], m_names[Program::FRAGMENT]);
+    return key;
+  }
+  const Variant_key mask = ((1u << opt.bits) - 1u) << opt.shift;
+  return (key & ~mask) | ((value << opt.shift) & mask);
+}
+
+uint32_t Shader_variants::get(Variant_key key, uint8_t option) const
+{
+  const auto &opt = m_options[option];
+  return (key >> opt.shift) & ((1u << opt.bits) - 1u);
+}
+
+uint32_t Shader_variants::value_count(const Option &opt)
+{
+  // a boolean option has a single define and two values
+  return opt.defines.size() == 1u ? 2u : static_cast<uint32_t>(opt.defines.size());
+}
+
+bool Shader_variants::is_valid(Variant_key key) const
+{
+  // enum options with a count of values that is not a power of two leave bit patterns without a define
+  for (uint8_t i = 0u; i < m_options.size(); ++i)
+  {
+    if (get(key, i) >= value_count(m_options[i]))
+      return false;
+  }
+  return m_used_bits == 32u || key >> m_used_bits == 0u;
+}
+
+std::string Shader_variants::defines(Variant_key key, uint8_t stages) const
+{
+  std::string result;
+  for (uint8_t i = 0u; i < m_options.size(); ++i)
+  {
+    const auto &opt = m_options[i];
+    if (!(opt.stages & stages))
+      continue;
+
+    const auto value = get(key, i);
+    if (opt.defines.size() == 1u && value == 0u)
+      continue;    // boolean option off
+    if (value >= value_count(opt))
+      continue;    // not a value of the option, see is_valid
+    const auto &define = opt.defines.size() == 1u ? opt.defines.front() : opt.defines[value];
+    if (!result.empty())
+      result.append(";");
+    result.append(define);
+  }
+  return result;
+}
+
+Variant_key Shader_variants::stage_mask(Program::Type stage) const
+{
+  Variant_key mask{0u};
+  for (const auto &opt : m_options)
+  {
+    if (opt.stages & (1u << stage))
+      mask |= ((1u << opt.bits) - 1u) << opt.shift;
+  }
+  return mask;
+}
+
+bgfx::ShaderHandle Shader_variants::shader(Program::Type stage, Variant_key stage_key)
+{
+  if (const auto it = m_shaders[stage].find(stage_key); it != m_shaders[stage].end())
+    return it->second;
+
+  bgfx::ShaderHandle handle{bgfx::kInvalidHandle};
+  const auto stage_defines = defines(stage_key, static_cast<uint8_t>(1u << stage));
+  if (m_pack)
+  {
+    // variant 0 is the shader cooked without defines
+    const auto name = stage_key == 0u ? m_names[stage] : m_names[stage] + "@" + internal::key_suffix(stage_key);
+    handle = load_shader(*m_pack, name);
+    if (!bgfx::isValid(handle))
+    {
+      app::logger::logger->error("Add \"{} {}\" to {}.variants to cook the missing variant", internal::key_suffix(stage_key),
+                                 stage_defines, m_names[stage]);
+    }
+  }
+  else
+  {
+    const auto &source_path = m_paths[stage];
+    auto binary_path = source_path;
+    binary_path += internal::binary_suffix(stage_key, stage_defines, stage);
+    if (internal::is_up_to_date(binary_path, source_path) ||
+        compile_shader(source_path, binary_path, stage, stage_defines))
+    {
+      handle = load_shader(binary_path);
+    }
+  }
+
+  m_shaders[stage].emplace(stage_key, handle);
+  return handle;
+}
+
+const Program *Shader_variants::program(Variant_key key)
+{
+  if (const auto it = m_programs.find(key); it != m_programs.end())
+    return it->second.get();
+
+  std::unique_ptr<Program> variant;
+  if (!is_valid(key))
+  {
+    app::logger::logger->error("Variant {:x} of {}/{} sets values its options do not have", key,
+                               m_names[Program::VERTEX], m_names[Program::FRAGMENT]);
+    return m_programs.emplace(key, std::move(variant)).first->second.get();
+  }
+  const auto vsh = shader(Program::VERTEX, key & stage_mask(Program::VERTEX));
+  const auto fsh = shader(Program::FRAGMENT, key & stage_mask(Program::FRAGMENT));
+  if (bgfx::isValid(vsh) && bgfx::isValid(fsh))
+  {
+    if (const auto handle = bgfx::createProgram(vsh, fsh, false); bgfx::isValid(handle))
+    {
+      variant = std::make_unique<Program>();
+      variant->program_handle = handle;
+    }
+  }
+  if (!variant)
+  {
+    app::logger::logger->error("Error building variant {:x} ({}) of {}/{}", key, defines(key), m_names[Program::VERTEX],
+                               m_names[Program::FRAGMENT]);
+  }
+
+  return m_programs.emplace(key, std::move(variant)).first->second.get();
+}
+
+}    // namespace blackboard::gfx
@@ -0,0 +1,97 @@
+#pragma once
+#include "program.h"
+
+#include <bgfx/bgfx.h>
+
+#include <array>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace blackboard::gfx {
+
+struct Shader_pack;
+
+/// @brief Compact bitmask selecting a value for every option of a Shader_variants
+using Variant_key = uint32_t;
+
+/// @brief Permutations of one vertex/fragment pair selected by preprocessor defines.
+///
+/// Options are boolean defines or enums (exactly one define of a list is set). A variant is compiled,
+/// or loaded from the shader pack, the first time it is requested and then cached; shaders are shared
+/// between variants differing only by options their stage does not use.
+///
+///   Shader_variants lit{pack, "vs_lit", "fs_lit"};
+///   const auto skinned = lit.add_option("SKINNED", Shader_variants::vertex_stage);
+///   const auto shading = lit.add_option({"SHADING_FLAT", "SHADING_SMOOTH"}, Shader_variants::fragment_stage);
+///   const auto *program = lit.program(lit.set(lit.set(0, skinned, 1), shading, 1));
+class Shader_variants
+{
+  public:
+  inline static constexpr uint8_t vertex_stage{1u << Program::VERTEX};
+  inline static constexpr uint8_t fragment_stage{1u << Program::FRAGMENT};
+  inline static constexpr uint8_t all_stages{vertex_stage | fragment_stage};
+
+  struct Option
+  {
+    std::vector<std::string> defines;    // a single define for boolean options
+    uint8_t shift{0u};
+    uint8_t bits{0u};
+    uint8_t stages{all_stages};
+  };
+
+  /// @brief Variants compiled at runtime with shaderc, binaries are cached next to the sources. Their names hold
+  /// the hash of the defines and of the shaderc profile, editing the options does not load stale binaries
+  Shader_variants(std::filesystem::path vsh_path, std::filesystem::path fsh_path);
+
+  /// @brief Variants cooked at build time, see the .variants files of cook_shaders
+  Shader_variants(const Shader_pack &pack, std::string vsh_name, std::string fsh_name);
+
+  ~Shader_variants();
+
+  Shader_variants(const Shader_variants &) = delete;
+  Shader_variants &operator=(const Shader_variants &) = delete;
+
+  /// @brief Boolean option, returns its id
+  uint8_t add_option(std::string define, uint8_t stages = all_stages);
+
+  /// @brief Enum option, value i sets defines[i], returns its id
+  uint8_t add_option(std::vector<std::string> defines, uint8_t stages = all_stages);
+
+  /// @brief The key is returned unchanged when value is not a value of the option
+  Variant_key set(Variant_key key, uint8_t option, uint32_t value) const;
+  uint32_t get(Variant_key key, uint8_t option) const;
+
+  /// @brief Every option of the key is set to one of its values and no bit past the options is set
+  bool is_valid(Variant_key key) const;
+
+  /// @brief Defines of the variant used by the given stages separated by ';', as passed to shaderc --define
+  std::string defines(Variant_key key, uint8_t stages = all_stages) const;
+
+  /// @brief Program of the variant, nullptr if it can not be built (failures are cached too)
+  const Program *program(Variant_key key);
+
+  size_t variant_count() const
+  {
+    return m_programs.size();
+  }
+
+  private:
+  static uint32_t value_count(const Option &opt);
+  Variant_key stage_mask(Program::Type stage) const;
+  bgfx::ShaderHandle shader(Program::Type stage, Variant_key stage_key);
+
+  std::array<std::filesystem::path, 2> m_paths;
+  std::array<std::string, 2> m_names;
+  const Shader_pack *m_pack{nullptr};
+
+  std::vector<Option> m_options;
+  uint8_t m_used_bits{0u};
+
+  std::array<std::unordered_map<Variant_key, bgfx::ShaderHandle>, 2> m_shaders;
+  std::unordered_map<Variant_key, std::unique_ptr<Program>> m_programs;
+};
+
+}    // namespace blackboard::gfx
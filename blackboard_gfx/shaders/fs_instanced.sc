@@ -0,0 +1,12 @@
+$input v_color0, v_normal
+
+// Instance color lit by a fixed directional light
+
+#include <bgfx_shader.sh>
+
+void main()
+{
+	vec3 light_direction = normalize(vec3(0.4, 0.8, 0.5));
+	float light = 0.3 + 0.7 * max(dot(normalize(v_normal), light_direction), 0.0);
+	gl_FragColor = vec4(v_color0.rgb * light, v_color0.a);
+}
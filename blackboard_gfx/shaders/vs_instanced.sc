@@ -0,0 +1,15 @@
+$input a_position, a_normal, i_data0, i_data1, i_data2, i_data3
+$output v_color0, v_normal
+
+// Instance data of Instanced_renderer: the first three rows of the world matrix and the color
+
+#include <bgfx_shader.sh>
+
+void main()
+{
+	mat4 model = mtxFromRows(i_data0, i_data1, i_data2, vec4(0.0, 0.0, 0.0, 1.0));
+	vec4 world_position = mul(model, vec4(a_position, 1.0));
+	gl_Position = mul(u_viewProj, world_position);
+	v_normal = mul(model, vec4(a_normal, 0.0)).xyz;
+	v_color0 = i_data3;
+}
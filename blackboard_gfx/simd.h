@@ -0,0 +1,313 @@
+#pragma once
+#include <cstdint>
+
+// Four float lanes: SSE2 on x86-64, NEON on arm64, plain loops anywhere else. Only the operations needed by the
+// culling code, comparisons give lane masks that select() and bits() consume.
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BLACKBOARD_SIMD_SSE 1
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define BLACKBOARD_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace blackboard::gfx::simd {
+
+#if BLACKBOARD_SIMD_SSE
+
+struct float4
+{
+  __m128 v;
+};
+
+struct mask4
+{
+  __m128 v;
+};
+
+inline float4 load(const float *values)
+{
+  return {_mm_loadu_ps(values)};
+}
+
+inline void store(float *values, float4 a)
+{
+  _mm_storeu_ps(values, a.v);
+}
+
+inline float4 splat(float value)
+{
+  return {_mm_set1_ps(value)};
+}
+
+inline float4 make(float a, float b, float c, float d)
+{
+  return {_mm_setr_ps(a, b, c, d)};
+}
+
+inline float4 operator+(float4 a, float4 b)
+{
+  return {_mm_add_ps(a.v, b.v)};
+}
+
+inline float4 operator-(float4 a, float4 b)
+{
+  return {_mm_sub_ps(a.v, b.v)};
+}
+
+inline float4 operator*(float4 a, float4 b)
+{
+  return {_mm_mul_ps(a.v, b.v)};
+}
+
+inline float4 operator/(float4 a, float4 b)
+{
+  return {_mm_div_ps(a.v, b.v)};
+}
+
+inline float4 min(float4 a, float4 b)
+{
+  return {_mm_min_ps(a.v, b.v)};
+}
+
+inline float4 max(float4 a, float4 b)
+{
+  return {_mm_max_ps(a.v, b.v)};
+}
+
+inline mask4 operator<(float4 a, float4 b)
+{
+  return {_mm_cmplt_ps(a.v, b.v)};
+}
+
+inline mask4 operator<=(float4 a, float4 b)
+{
+  return {_mm_cmple_ps(a.v, b.v)};
+}
+
+inline mask4 operator|(mask4 a, mask4 b)
+{
+  return {_mm_or_ps(a.v, b.v)};
+}
+
+inline mask4 operator&(mask4 a, mask4 b)
+{
+  return {_mm_and_ps(a.v, b.v)};
+}
+
+/// @brief a where the mask is set, b elsewhere
+inline float4 select(mask4 mask, float4 a, float4 b)
+{
+  return {_mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v))};
+}
+
+/// @brief Lane i is bit i
+inline uint32_t bits(mask4 mask)
+{
+  return static_cast<uint32_t>(_mm_movemask_ps(mask.v));
+}
+
+#elif BLACKBOARD_SIMD_NEON
+
+struct float4
+{
+  float32x4_t v;
+};
+
+struct mask4
+{
+  uint32x4_t v;
+};
+
+inline float4 load(const float *values)
+{
+  return {vld1q_f32(values)};
+}
+
+inline void store(float *values, float4 a)
+{
+  vst1q_f32(values, a.v);
+}
+
+inline float4 splat(float value)
+{
+  return {vdupq_n_f32(value)};
+}
+
+inline float4 make(float a, float b, float c, float d)
+{
+  const float values[4]{a, b, c, d};
+  return {vld1q_f32(values)};
+}
+
+inline float4 operator+(float4 a, float4 b)
+{
+  return {vaddq_f32(a.v, b.v)};
+}
+
+inline float4 operator-(float4 a, float4 b)
+{
+  return {vsubq_f32(a.v, b.v)};
+}
+
+inline float4 operator*(float4 a, float4 b)
+{
+  return {vmulq_f32(a.v, b.v)};
+}
+
+inline float4 operator/(float4 a, float4 b)
+{
+  return {vdivq_f32(a.v, b.v)};
+}
+
+inline float4 min(float4 a, float4 b)
+{
+  return {vminq_f32(a.v, b.v)};
+}
+
+inline float4 max(float4 a, float4 b)
+{
+  return {vmaxq_f32(a.v, b.v)};
+}
+
+inline mask4 operator<(float4 a, float4 b)
+{
+  return {vcltq_f32(a.v, b.v)};
+}
+
+inline mask4 operator<=(float4 a, float4 b)
+{
+  return {vcleq_f32(a.v, b.v)};
+}
+
+inline mask4 operator|(mask4 a, mask4 b)
+{
+  return {vorrq_u32(a.v, b.v)};
+}
+
+inline mask4 operator&(mask4 a, mask4 b)
+{
+  return {vandq_u32(a.v, b.v)};
+}
+
+inline float4 select(mask4 mask, float4 a, float4 b)
+{
+  return {vbslq_f32(mask.v, a.v, b.v)};
+}
+
+inline uint32_t bits(mask4 mask)
+{
+  static const int32_t shifts[4]{0, 1, 2, 3};
+  return vaddvq_u32(vshlq_u32(vshrq_n_u32(mask.v, 31), vld1q_s32(shifts)));
+}
+
+#else
+
+struct float4
+{
+  float v[4];
+};
+
+struct mask4
+{
+  bool v[4];
+};
+
+template<typename Function>
+inline float4 lanes(Function &&function)
+{
+  return {function(0), function(1), function(2), function(3)};
+}
+
+template<typename Function>
+inline mask4 lane_mask(Function &&function)
+{
+  return {function(0), function(1), function(2), function(3)};
+}
+
+inline float4 load(const float *values)
+{
+  return {values[0], values[1], values[2], values[3]};
+}
+
+inline void store(float *values, float4 a)
+{
+  for (int i = 0; i < 4; ++i)
+    values[i] = a.v[i];
+}
+
+inline float4 splat(float value)
+{
+  return {value, value, value, value};
+}
+
+inline float4 make(float a, float b, float c, float d)
+{
+  return {a, b, c, d};
+}
+
+inline float4 operator+(float4 a, float4 b)
+{
+  return lanes([&](int i) { return a.v[i] + b.v[i]; });
+}
+
+inline float4 operator-(float4 a, float4 b)
+{
+  return lanes([&](int i) { return a.v[i] - b.v[i]; });
+}
+
+inline float4 operator*(float4 a, float4 b)
+{
+  return lanes([&](int i) { return a.v[i] * b.v[i]; });
+}
+
+inline float4 operator/(float4 a, float4 b)
+{
+  return lanes([&](int i) { return a.v[i] / b.v[i]; });
+}
+
+inline float4 min(float4 a, float4 b)
+{
+  return lanes([&](int i) { return a.v[i] < b.v[i] ? a.v[i] : b.v[i]; });
+}
+
+inline float4 max(float4 a, float4 b)
+{
+  return lanes([&](int i) { return a.v[i] > b.v[i] ? a.v[i] : b.v[i]; });
+}
+
+inline mask4 operator<(float4 a, float4 b)
+{
+  return lane_mask([&](int i) { return a.v[i] < b.v[i]; });
+}
+
+inline mask4 operator<=(float4 a, float4 b)
+{
+  return lane_mask([&](int i) { return a.v[i] <= b.v[i]; });
+}
+
+inline mask4 operator|(mask4 a, mask4 b)
+{
+  return lane_mask([&](int i) { return a.v[i] || b.v[i]; });
+}
+
+inline mask4 operator&(mask4 a, mask4 b)
+{
+  return lane_mask([&](int i) { return a.v[i] && b.v[i]; });
+}
+
+inline float4 select(mask4 mask, float4 a, float4 b)
+{
+  return lanes([&](int i) { return mask.v[i] ? a.v[i] : b.v[i]; });
+}
+
+inline uint32_t bits(mask4 mask)
+{
+  return static_cast<uint32_t>(mask.v[0]) | static_cast<uint32_t>(mask.v[1]) << 1u |
+         static_cast<uint32_t>(mask.v[2]) << 2u | static_cast<uint32_t>(mask.v[3]) << 3u;
+}
+
+#endif
+
+}    // namespace blackboard::gfx::simd
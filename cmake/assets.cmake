@@ -0,0 +1,44 @@
+cmake_minimum_required(VERSION 3.21)
+
+option(BLACKBOARD_ARCHIVE_ASSETS "Pack the assets of the applications into Resources/assets.pack" OFF)
+
+# Pack every file inside assets_dir into Resources/assets.pack, entries are named "assets/<relative path>"
+# as the loose files copied into Resources/assets, so the application code is the same in both cases.
+# With COMPRESS entries are stored LZ4 compressed whenever that makes them smaller.
+# The archive is mounted on top of the Resources folder by blackboard::app::App, see blackboard_app/vfs.h.
+function(archive_assets target assets_dir)
+    cmake_parse_arguments(ARCHIVE "COMPRESS" "" "" ${ARGN})
+
+    file(GLOB_RECURSE asset_files CONFIGURE_DEPENDS ${assets_dir}/*)
+
+    set(archive_dir ${CMAKE_CURRENT_BINARY_DIR}/archived_assets)
+    set(manifest_file ${archive_dir}/assets.manifest)
+    set(pack_file ${archive_dir}/assets.pack)
+    set(manifest_content "")
+    foreach(asset_file ${asset_files})
+        file(RELATIVE_PATH asset_name ${assets_dir} ${asset_file})
+        string(APPEND manifest_content "assets/${asset_name}\t${asset_file}\n")
+    endforeach()
+    file(GENERATE OUTPUT ${manifest_file} CONTENT "${manifest_content}")
+
+    set(pack_flags "")
+    if(ARCHIVE_COMPRESS)
+        set(pack_flags --lz4)
+    endif()
+
+    add_custom_command(
+        OUTPUT ${pack_file}
+        COMMAND blackboard_pack ${pack_flags} ${pack_file} ${manifest_file}
+        DEPENDS ${asset_files} ${manifest_file} blackboard_pack
+        COMMENT "Archiving assets of ${target}"
+        VERBATIM
+    )
+    add_custom_target(${target}_archive_assets ALL DEPENDS ${pack_file})
+    add_dependencies(${target} ${target}_archive_assets)
+
+    blackboard_resources_dir(${target} resources_dir)
+    add_custom_command(TARGET ${target}
+        POST_BUILD
+        COMMAND ${CMAKE_COMMAND} -E copy_if_different ${pack_file} ${resources_dir}/assets.pack
+    )
+endfunction()
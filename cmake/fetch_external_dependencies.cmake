@@ -156,3 +156,46 @@ if(NOT bgfx_cmake_POPULATED)
     set( BGFX_CUSTOM_TARGETS  OFF CACHE INTERNAL "" )
     add_subdirectory(${bgfx_cmake_SOURCE_DIR} ${bgfx_cmake_BINARY_DIR} EXCLUDE_FROM_ALL)
 endif()
+
+# EnTT
+if(EXISTS ${FETCHCONTENT_BASE_DIR}/entt-src)
+    set(repo_entt "file://${FETCHCONTENT_BASE_DIR}/entt-src")
+    set(FETCHCONTENT_SOURCE_DIR_ENTT ${FETCHCONTENT_BASE_DIR}/entt-src)
+else()
+    set(repo_entt "git@github.com:skypjack/entt.git")
+endif()
+FetchContent_Declare(
+    EnTT
+    GIT_REPOSITORY ${repo_entt}
+    GIT_TAG v3.11.1
+    GIT_SHALLOW 1
+)
+FetchContent_MakeAvailable(EnTT)
+
+# lz4
+if(EXISTS ${FETCHCONTENT_BASE_DIR}/lz4-src)
+    set(repo_lz4 "file://${FETCHCONTENT_BASE_DIR}/lz4-src")
+    set(FETCHCONTENT_SOURCE_DIR_LZ4 ${FETCHCONTENT_BASE_DIR}/lz4-src)
+else()
+    set(repo_lz4 "git@github.com:lz4/lz4.git")
+endif()
+FetchContent_Declare(
+    lz4
+    GIT_REPOSITORY ${repo_lz4}
+    GIT_TAG v1.9.4
+    GIT_SHALLOW 1
+)
+FetchContent_GetProperties(lz4)
+if(NOT lz4_POPULATED)
+    FetchContent_Populate(lz4)
+endif()
+
+add_library(lz4 STATIC
+    ${lz4_SOURCE_DIR}/lib/lz4.c
+    ${lz4_SOURCE_DIR}/lib/lz4hc.c
+)
+
+target_include_directories(lz4
+    PUBLIC
+    $<BUILD_INTERFACE:${lz4_SOURCE_DIR}/lib>
+)
@@ -0,0 +1,232 @@
+cmake_minimum_required(VERSION 3.21)
+
+# Shader profiles cooked for the host platform, as "name:shaderc platform:graphics profile:compute profile".
+# The name is the folder used inside the pack, see blackboard::gfx::shader_profile_name.
+if(APPLE)
+    set(BLACKBOARD_SHADER_PROFILES
+        "metal:osx:metal:metal"
+    )
+elseif(WIN32)
+    set(BLACKBOARD_SHADER_PROFILES
+        "dx11:windows:s_5_0:s_5_0"
+        "spirv:windows:spirv:spirv"
+    )
+else()
+    set(BLACKBOARD_SHADER_PROFILES
+        "glsl:linux:150:430"
+        "spirv:linux:spirv:spirv"
+    )
+endif()
+
+# Resources folder of an application bundle/executable
+function(blackboard_resources_dir target output_variable)
+    if(APPLE)
+        set(${output_variable} "$<TARGET_FILE_DIR:${target}>/../Resources" PARENT_SCOPE)
+    else()
+        set(${output_variable} "$<TARGET_FILE_DIR:${target}>/Resources" PARENT_SCOPE)
+    endif()
+endfunction()
+
+# Compile every vs_*.sc, fs_*.sc and cs_*.sc file inside shaders_dir for all the BLACKBOARD_SHADER_PROFILES
+# and pack the binaries into Resources/assets/shaders.pack, entries are named "<profile name>/<shader name>".
+# Variants of blackboard::gfx::Shader_variants are cooked as "<profile name>/<shader name>@<key>".
+# Shaders are compiled at build time only, the application does not need shaderc to run.
+function(cook_shaders target shaders_dir)
+    file(GLOB shader_sources
+        ${shaders_dir}/vs_*.sc
+        ${shaders_dir}/fs_*.sc
+        ${shaders_dir}/cs_*.sc
+    )
+
+    set(cooked_dir ${CMAKE_CURRENT_BINARY_DIR}/cooked_shaders)
+    set(manifest_file ${cooked_dir}/shaders.manifest)
+    set(pack_file ${cooked_dir}/shaders.pack)
+    set(manifest_content "")
+    set(cooked_binaries "")
+
+    set(varying_def ${shaders_dir}/varying.def.sc)
+
+    foreach(profile ${BLACKBOARD_SHADER_PROFILES})
+        string(REPLACE ":" ";" profile_fields ${profile})
+        list(GET profile_fields 0 profile_name)
+        list(GET profile_fields 1 profile_platform)
+        list(GET profile_fields 2 profile_graphics)
+        list(GET profile_fields 3 profile_compute)
+
+        foreach(shader_source ${shader_sources})
+            get_filename_component(shader_name ${shader_source} NAME_WE)
+            string(SUBSTRING ${shader_name} 0 2 shader_stage)
+            set(shader_profile ${profile_graphics})
+            set(shader_dependencies ${shader_source})
+            set(shader_varying_flags "")
+            if(shader_stage STREQUAL "vs")
+                set(shader_type vertex)
+            elseif(shader_stage STREQUAL "fs")
+                set(shader_type fragment)
+            else()
+                set(shader_type compute)
+                set(shader_profile ${profile_compute})
+            endif()
+            if(NOT shader_type STREQUAL "compute")
+                set(shader_varying_flags --varyingdef ${varying_def})
+                list(APPEND shader_dependencies ${varying_def})
+            endif()
+
+            # the shader itself, then the variants listed in <shader name>.variants as "<key> <DEFINE;DEFINE>"
+            set(shader_entries "${shader_name}")
+            set(shader_entries_defines "-")
+            set(variants_file ${shaders_dir}/${shader_name}.variants)
+            if(EXISTS ${variants_file})
+                set_property(DIRECTORY APPEND PROPERTY CMAKE_CONFIGURE_DEPENDS ${variants_file})
+                # keep the ';' separating the defines out of the cmake lists
+                file(READ ${variants_file} variants_content)
+                string(REPLACE ";" "," variants_content "${variants_content}")
+                string(REPLACE "\n" ";" variant_lines "${variants_content}")
+                foreach(variant_line ${variant_lines})
+                    string(REGEX MATCH "^([0-9a-fA-F]+)[ \t]+([^ \t\r]+)" variant_match "${variant_line}")
+                    if(variant_match)
+                        list(APPEND shader_entries "${shader_name}@${CMAKE_MATCH_1}")
+                        list(APPEND shader_entries_defines "${CMAKE_MATCH_2}")
+                    endif()
+                endforeach()
+            endif()
+
+            list(LENGTH shader_entries shader_entry_count)
+            math(EXPR shader_last_entry "${shader_entry_count} - 1")
+            foreach(entry_index RANGE ${shader_last_entry})
+                list(GET shader_entries ${entry_index} entry_name)
+                list(GET shader_entries_defines ${entry_index} entry_defines)
+                set(shader_define_flags "")
+                if(NOT entry_defines STREQUAL "-")
+                    string(REPLACE "," "$<SEMICOLON>" entry_defines "${entry_defines}")
+                    set(shader_define_flags --define "${entry_defines}")
+                endif()
+
+                set(shader_binary ${cooked_dir}/${profile_name}/${entry_name}.bin)
+                add_custom_command(
+                    OUTPUT ${shader_binary}
+                    COMMAND ${CMAKE_COMMAND} -E make_directory ${cooked_dir}/${profile_name}
+                    COMMAND shaderc
+                        -f ${shader_source}
+                        -o ${shader_binary}
+                        --type ${shader_type}
+                        --platform ${profile_platform}
+                        -p ${shader_profile}
+                        -i ${bgfx_cmake_SOURCE_DIR}/bgfx/src
+                        -i ${bgfx_cmake_SOURCE_DIR}/bgfx/examples/common
+                        ${shader_varying_flags}
+                        ${shader_define_flags}
+                        -O 3
+                    DEPENDS ${shader_dependencies} shaderc
+                    COMMENT "Cooking shader ${profile_name}/${entry_name}"
+                    VERBATIM
+                )
+                string(APPEND manifest_content "${profile_name}/${entry_name}\t${shader_binary}\n")
+                list(APPEND cooked_binaries ${shader_binary})
+            endforeach()
+        endforeach()
+    endforeach()
+
+    file(GENERATE OUTPUT ${manifest_file} CONTENT "${manifest_content}")
+
+    add_custom_command(
+        OUTPUT ${pack_file}
+        COMMAND blackboard_pack ${pack_file} ${manifest_file}
+        DEPENDS ${cooked_binaries} ${manifest_file} blackboard_pack
+        COMMENT "Packing shaders of ${target}"
+        VERBATIM
+    )
+    add_custom_target(${target}_cook_shaders ALL DEPENDS ${pack_file})
+    add_dependencies(${target} ${target}_cook_shaders)
+
+    blackboard_resources_dir(${target} resources_dir)
+    add_custom_command(TARGET ${target}
+        POST_BUILD
+        COMMAND ${CMAKE_COMMAND} -E copy_if_different ${pack_file} ${resources_dir}/assets/shaders.pack
+    )
+endfunction()
+
+# Compile every vs_*.sc and fs_*.sc file inside shaders_dir for all the BLACKBOARD_SHADER_PROFILES into C arrays
+# embedded in the target, for shaders the target needs before any asset can be read.
+# Every shader gets a generated "<shader name>.bin.h" in the target include path, which defines the
+# bgfx::EmbeddedShader entry BLACKBOARD_EMBEDDED_SHADER(<shader name>) for bgfx::createEmbeddedShader tables.
+function(embed_shaders target shaders_dir)
+    file(GLOB shader_sources
+        ${shaders_dir}/vs_*.sc
+        ${shaders_dir}/fs_*.sc
+    )
+
+    set(embedded_dir ${CMAKE_CURRENT_BINARY_DIR}/embedded_shaders)
+    set(varying_def ${shaders_dir}/varying.def.sc)
+    set(embedded_headers "")
+
+    foreach(shader_source ${shader_sources})
+        get_filename_component(shader_name ${shader_source} NAME_WE)
+        string(SUBSTRING ${shader_name} 0 2 shader_stage)
+        if(shader_stage STREQUAL "vs")
+            set(shader_type vertex)
+        else()
+            set(shader_type fragment)
+        endif()
+
+        set(header_content "#pragma once\n// Generated by embed_shaders from ${shader_source}\n#include <bgfx/bgfx.h>\n\n")
+        set(header_entries "")
+        foreach(profile ${BLACKBOARD_SHADER_PROFILES})
+            string(REPLACE ":" ";" profile_fields ${profile})
+            list(GET profile_fields 0 profile_name)
+            list(GET profile_fields 1 profile_platform)
+            list(GET profile_fields 2 profile_graphics)
+
+            # renderers reading the binaries of the profile, see blackboard::gfx::shader_profile_name
+            if(profile_name STREQUAL "dx11")
+                set(profile_renderers Direct3D11 Direct3D12)
+            elseif(profile_name STREQUAL "metal")
+                set(profile_renderers Metal)
+            elseif(profile_name STREQUAL "glsl")
+                set(profile_renderers OpenGL)
+            elseif(profile_name STREQUAL "essl")
+                set(profile_renderers OpenGLES)
+            else()
+                set(profile_renderers Vulkan)
+            endif()
+
+            set(array_name ${shader_name}_${profile_name})
+            set(shader_header ${embedded_dir}/${profile_name}/${shader_name}.bin.h)
+            add_custom_command(
+                OUTPUT ${shader_header}
+                COMMAND ${CMAKE_COMMAND} -E make_directory ${embedded_dir}/${profile_name}
+                COMMAND shaderc
+                    -f ${shader_source}
+                    -o ${shader_header}
+                    --bin2c ${array_name}
+                    --type ${shader_type}
+                    --platform ${profile_platform}
+                    -p ${profile_graphics}
+                    -i ${bgfx_cmake_SOURCE_DIR}/bgfx/src
+                    --varyingdef ${varying_def}
+                    -O 3
+                DEPENDS ${shader_source} ${varying_def} shaderc
+                COMMENT "Embedding shader ${profile_name}/${shader_name}"
+                VERBATIM
+            )
+            list(APPEND embedded_headers ${shader_header})
+            string(APPEND header_content "#include \"${profile_name}/${shader_name}.bin.h\"\n")
+            foreach(renderer ${profile_renderers})
+                string(APPEND header_entries "    {bgfx::RendererType::${renderer}, ${array_name}, sizeof(${array_name})}, \\\n")
+            endforeach()
+        endforeach()
+
+        string(APPEND header_content
+            "\n#define ${shader_name}_embedded_data \\\n${header_entries}\n"
+            "#ifndef BLACKBOARD_EMBEDDED_SHADER\n"
+            "#define BLACKBOARD_EMBEDDED_SHADER(_name) \\\n"
+            "  {#_name, {_name##_embedded_data {bgfx::RendererType::Count, nullptr, 0}}}\n"
+            "#endif\n"
+        )
+        file(GENERATE OUTPUT ${embedded_dir}/${shader_name}.bin.h CONTENT "${header_content}")
+        list(APPEND embedded_headers ${embedded_dir}/${shader_name}.bin.h)
+    endforeach()
+
+    target_sources(${target} PRIVATE ${embedded_headers})
+    target_include_directories(${target} PRIVATE ${embedded_dir})
+endfunction()
@@ -54,12 +54,17 @@ void execute_systems(Context& ctx)
   ctx.system_b.update(blackboard::app::App::delta_time());
 }
 
-void init(Context& ctx)
+// runs on a worker while the renderer initializes
+void load()
 {
-  blackboard::app::gui::set_blackboard_theme();
   const auto dpi{app->main_window.get_ddpi()};
   blackboard::app::gui::load_font(blackboard::app::resources::path() / "assets/fonts/Inter/Inter-Light.otf", 12.0f,
                                   dpi);
+}
+
+void init(Context& ctx)
+{
+  blackboard::app::gui::set_blackboard_theme();
   auto& r = ctx.r;
   r.ctx().emplace<Callback_data>();
   // There are two ways to register a listener on a specific component
@@ -160,6 +165,7 @@ int main(int argc, char *argv[])
 
   Context ctx{};
   app->on_update = [&ctx](){app_update(ctx);};
+  app->on_load = load;
   app->on_init = [&ctx](){init(ctx);};
   app->run();
 
@@ -0,0 +1,245 @@
+#include <blackboard_app/binary_log_format.h>
+
+#include <spdlog/fmt/fmt.h>
+#if defined(SPDLOG_FMT_EXTERNAL)
+#include <fmt/args.h>
+#include <fmt/chrono.h>
+#else
+#include <spdlog/fmt/bundled/args.h>
+#include <spdlog/fmt/bundled/chrono.h>
+#endif
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Usage: blackboard_log_decode <binary log> [output text file]
+// Every record is written as "[time] [thread index] message", in the order the writer thread collected them.
+
+namespace {
+
+using namespace blackboard::app::binary_log;
+
+struct Format
+{
+  std::string signature;
+  std::string format_string;
+};
+
+// reads stop at end, the end of the record, chunk or file being decoded
+template<typename T>
+bool read(const std::vector<char> &data, size_t &offset, size_t end, T &value)
+{
+  if (offset + sizeof(T) > std::min(end, data.size()))
+    return false;
+  std::memcpy(&value, data.data() + offset, sizeof(T));
+  offset += sizeof(T);
+  return true;
+}
+
+std::string overrun(const Format &format)
+{
+  return "<corrupt record, its arguments run past its end, format \"" + format.format_string + "\">";
+}
+
+std::string decode_record(const Format &format, const std::vector<char> &data, size_t offset, size_t end)
+{
+  fmt::dynamic_format_arg_store<fmt::format_context> args;
+  for (const char code : format.signature)
+  {
+    switch (code)
+    {
+      case format::arg_bool:
+      {
+        uint8_t value{0u};
+        if (!read(data, offset, end, value))
+          return overrun(format);
+        args.push_back(value != 0u);
+      }
+      break;
+      case format::arg_char:
+      {
+        char value{0};
+        if (!read(data, offset, end, value))
+          return overrun(format);
+        args.push_back(value);
+      }
+      break;
+      case format::arg_int:
+      {
+        int64_t value{0};
+        if (!read(data, offset, end, value))
+          return overrun(format);
+        args.push_back(value);
+      }
+      break;
+      case format::arg_uint:
+      {
+        uint64_t value{0u};
+        if (!read(data, offset, end, value))
+          return overrun(format);
+        args.push_back(value);
+      }
+      break;
+      case format::arg_float:
+      {
+        float value{0.f};
+        if (!read(data, offset, end, value))
+          return overrun(format);
+        args.push_back(value);
+      }
+      break;
+      case format::arg_double:
+      {
+        double value{0.};
+        if (!read(data, offset, end, value))
+          return overrun(format);
+        args.push_back(value);
+      }
+      break;
+      case format::arg_pointer:
+      {
+        uint64_t value{0u};
+        if (!read(data, offset, end, value))
+          return overrun(format);
+        args.push_back(fmt::format("{:#x}", value));
+      }
+      break;
+      case format::arg_string:
+      {
+        uint32_t size{0u};
+        if (!read(data, offset, end, size) || size > end - offset)
+          return overrun(format);
+        args.push_back(std::string{data.data() + offset, size});
+        offset += size;
+      }
+      break;
+      default:
+        return "<unknown argument type in format \"" + format.format_string + "\">";
+    }
+  }
+
+  try
+  {
+    return fmt::vformat(format.format_string, args);
+  }
+  catch (const fmt::format_error &error)
+  {
+    return "<" + std::string{error.what()} + " in format \"" + format.format_string + "\">";
+  }
+}
+
+}    // namespace
+
+int main(int argc, char *argv[])
+{
+  if (argc != 2 && argc != 3)
+  {
+    std::cerr << "Usage: " << argv[0] << " <binary log> [output text file]" << std::endl;
+    return 1;
+  }
+
+  std::ifstream input(argv[1], std::ios::binary);
+  if (!input.is_open())
+  {
+    std::cerr << "blackboard_log_decode: can not open " << argv[1] << std::endl;
+    return 1;
+  }
+  const std::vector<char> data{std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>()};
+
+  std::ofstream output_file;
+  if (argc == 3)
+  {
+    output_file.open(argv[2], std::ios::trunc);
+    if (!output_file.is_open())
+    {
+      std::cerr << "blackboard_log_decode: can not write " << argv[2] << std::endl;
+      return 1;
+    }
+  }
+  std::ostream &output = argc == 3 ? output_file : std::cout;
+
+  size_t offset{0u};
+  format::File_header header;
+  if (!read(data, offset, data.size(), header) || header.magic != format::magic || header.version != format::version)
+  {
+    std::cerr << "blackboard_log_decode: " << argv[1] << " is not a binary log" << std::endl;
+    return 1;
+  }
+  const std::chrono::sys_time<std::chrono::nanoseconds> start_time{std::chrono::nanoseconds{header.start_time}};
+
+  std::unordered_map<uint32_t, Format> formats;
+  size_t record_count{0u};
+  format::Chunk_header chunk;
+  while (read(data, offset, data.size(), chunk))
+  {
+    const size_t chunk_end = offset + chunk.size;
+    if (chunk_end > data.size())
+    {
+      std::cerr << "blackboard_log_decode: truncated file" << std::endl;
+      break;
+    }
+
+    switch (chunk.type)
+    {
+      case format::Chunk_type::FORMAT:
+      {
+        format::Format_header format_header;
+        if (!read(data, offset, chunk_end, format_header) ||
+            offset + format_header.signature_size + format_header.format_size > chunk_end)
+        {
+          std::cerr << "blackboard_log_decode: corrupt format chunk" << std::endl;
+          break;
+        }
+        Format &entry = formats[format_header.id];
+        entry.signature.assign(data.data() + offset, format_header.signature_size);
+        entry.format_string.assign(data.data() + offset + format_header.signature_size, format_header.format_size);
+      }
+      break;
+      case format::Chunk_type::EVENTS:
+      {
+        format::Events_header events_header;
+        read(data, offset, chunk_end, events_header);
+        format::Record_header record;
+        while (offset + sizeof(record) <= chunk_end && read(data, offset, chunk_end, record))
+        {
+          // a record holds at least its header and ends inside its chunk, anything else is a corrupt log
+          const size_t record_end = offset - sizeof(record) + record.size;
+          if (record.size < sizeof(record) || record_end > chunk_end)
+          {
+            std::cerr << "blackboard_log_decode: corrupt record of size " << record.size << " at offset "
+                      << offset - sizeof(record) << ", skipping the rest of its chunk" << std::endl;
+            break;
+          }
+          const auto time = start_time + std::chrono::nanoseconds{record.time};
+          const auto it = formats.find(record.format_id);
+          const auto text = it != formats.end() ? decode_record(it->second, data, offset, record_end)
+                                                : fmt::format("<unknown format {}>", record.format_id);
+          const auto seconds = std::chrono::floor<std::chrono::seconds>(time);
+          const auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(time - seconds).count();
+          output << fmt::format("[{:%Y-%m-%d %H:%M:%S}.{:06}] [thread {}] {}\n", seconds, microseconds,
+                                events_header.thread_index, text);
+          offset = record_end;
+          ++record_count;
+        }
+      }
+      break;
+      case format::Chunk_type::DROPPED:
+      {
+        uint64_t count{0u};
+        read(data, offset, chunk_end, count);
+        output << fmt::format("[dropped {} records]\n", count);
+      }
+      break;
+    }
+    offset = chunk_end;
+  }
+
+  std::cerr << "blackboard_log_decode: " << record_count << " records" << std::endl;
+  return 0;
+}
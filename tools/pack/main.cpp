@@ -0,0 +1,164 @@
+#include <blackboard_app/pack.h>
+
+#include <lz4hc.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// Usage: blackboard_pack [--lz4] <output pack> <manifest>
+// Every manifest line is "<entry name>\t<file path>".
+// With --lz4 every entry is stored as an LZ4 block when that makes it smaller.
+
+namespace {
+
+struct Input
+{
+  std::string name;
+  std::filesystem::path path;
+  std::vector<char> data;
+  uint16_t flags{0u};
+  uint32_t size{0u};
+};
+
+bool read_manifest(const std::filesystem::path &manifest_path, std::vector<Input> &inputs)
+{
+  std::ifstream manifest(manifest_path);
+  if (!manifest.is_open())
+  {
+    std::cerr << "blackboard_pack: can not open manifest " << manifest_path.string() << std::endl;
+    return false;
+  }
+
+  std::string line;
+  while (std::getline(manifest, line))
+  {
+    if (line.empty())
+      continue;
+    const auto separator = line.find('\t');
+    if (separator == std::string::npos)
+    {
+      std::cerr << "blackboard_pack: malformed manifest line \"" << line << "\"" << std::endl;
+      return false;
+    }
+
+    Input input{.name = line.substr(0, separator), .path = line.substr(separator + 1), .data = {}};
+    std::ifstream file(input.path, std::ios::binary);
+    if (!file.is_open())
+    {
+      std::cerr << "blackboard_pack: can not open " << input.path.string() << std::endl;
+      return false;
+    }
+    input.data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    input.size = static_cast<uint32_t>(input.data.size());
+    inputs.push_back(std::move(input));
+  }
+  return true;
+}
+
+void compress(Input &input)
+{
+  std::vector<char> compressed(static_cast<size_t>(LZ4_compressBound(static_cast<int>(input.data.size()))));
+  const int compressed_size = LZ4_compress_HC(input.data.data(), compressed.data(), static_cast<int>(input.data.size()),
+                                              static_cast<int>(compressed.size()), LZ4HC_CLEVEL_MAX);
+  if (compressed_size > 0 && static_cast<size_t>(compressed_size) < input.data.size())
+  {
+    compressed.resize(static_cast<size_t>(compressed_size));
+    input.data = std::move(compressed);
+    input.flags |= blackboard::app::pack::flag_lz4;
+  }
+}
+
+}    // namespace
+
+int main(int argc, char *argv[])
+{
+  using namespace blackboard::app;
+
+  const bool use_lz4{argc == 4 && std::string{argv[1]} == "--lz4"};
+  if (argc != 3 && !use_lz4)
+  {
+    std::cerr << "Usage: " << argv[0] << " [--lz4] <output pack> <manifest>" << std::endl;
+    return 1;
+  }
+  const std::filesystem::path output_path{argv[argc - 2]};
+  const std::filesystem::path manifest_path{argv[argc - 1]};
+
+  std::vector<Input> inputs;
+  if (!read_manifest(manifest_path, inputs))
+    return 1;
+
+  if (use_lz4)
+  {
+    for (auto &input : inputs)
+      compress(input);
+  }
+
+  std::sort(inputs.begin(), inputs.end(),
+            [](const Input &a, const Input &b) { return pack::hash(a.name) < pack::hash(b.name); });
+  for (size_t i = 1; i < inputs.size(); ++i)
+  {
+    if (pack::hash(inputs[i - 1].name) == pack::hash(inputs[i].name))
+    {
+      std::cerr << "blackboard_pack: \"" << inputs[i - 1].name << "\" and \"" << inputs[i].name
+                << "\" have the same name hash" << std::endl;
+      return 1;
+    }
+  }
+
+  const auto align = [](uint64_t value) { return (value + pack::data_alignment - 1) & ~(pack::data_alignment - 1); };
+
+  pack::Header header{};
+  header.entry_count = static_cast<uint32_t>(inputs.size());
+  header.names_offset = static_cast<uint32_t>(sizeof(pack::Header) + inputs.size() * sizeof(pack::Entry));
+
+  std::vector<pack::Entry> entries;
+  std::string names;
+  for (const auto &input : inputs)
+  {
+    entries.push_back({.hash = pack::hash(input.name),
+                       .size = input.size,
+                       .stored_size = static_cast<uint32_t>(input.data.size()),
+                       .name_offset = static_cast<uint32_t>(names.size()),
+                       .name_size = static_cast<uint16_t>(input.name.size()),
+                       .flags = input.flags});
+    names.append(input.name);
+  }
+
+  uint64_t offset{align(header.names_offset + names.size())};
+  for (auto &entry : entries)
+  {
+    entry.offset = offset;
+    offset = align(offset + entry.stored_size);
+  }
+
+  std::ofstream output(output_path, std::ios::binary | std::ios::trunc);
+  if (!output.is_open())
+  {
+    std::cerr << "blackboard_pack: can not write " << output_path.string() << std::endl;
+    return 1;
+  }
+
+  const auto pad_to = [&output](uint64_t position) {
+    static constexpr char zeros[pack::data_alignment]{};
+    const auto current = static_cast<uint64_t>(output.tellp());
+    output.write(zeros, static_cast<std::streamsize>(position - current));
+  };
+
+  output.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  output.write(reinterpret_cast<const char *>(entries.data()),
+               static_cast<std::streamsize>(entries.size() * sizeof(pack::Entry)));
+  output.write(names.data(), static_cast<std::streamsize>(names.size()));
+  for (size_t i = 0; i < inputs.size(); ++i)
+  {
+    pad_to(entries[i].offset);
+    output.write(inputs[i].data.data(), static_cast<std::streamsize>(inputs[i].data.size()));
+  }
+
+  std::cout << "blackboard_pack: " << inputs.size() << " entries written to " << output_path.string() << std::endl;
+  return 0;
+}